@@ -0,0 +1,487 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Ricardo Fares
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "./ast.h"
+
+/**
+ * The initial capacities of the program storages.
+ */
+#define AST_INITIAL_NODES  (64)
+#define AST_INITIAL_CONSTS (16)
+#define AST_INITIAL_SLOTS  (16)
+#define AST_INITIAL_INDEX  (128)
+
+/**
+ * It grows the specified storage to fit at least the specified minimum
+ * amount of elements, doubling its capacity.
+ * <p>
+ * If there is not enough memory, then the application is immediately
+ * terminated.
+ *
+ * @param storage  the storage to be grown
+ * @param capacity the storage capacity in elements, which is updated
+ * @param size     the size of a single element
+ * @param minimum  the minimum capacity in elements after growing
+ *
+ * @return the grown storage
+ */
+static void *
+grow(void *storage, uint32_t *capacity, const size_t size, const uint32_t minimum) {
+    uint32_t newcap = *capacity ? *capacity : 1;
+    while (newcap < minimum) {
+        /* It checks if the new capacity exceeds the maximum size */
+        if (newcap << 1 < newcap) {
+            printf("Program maximum size exceeded.\n");
+            exit(EXIT_FAILURE);
+        }
+        newcap <<= 1;
+    }
+    if (!(storage = realloc(storage, size * newcap))) {
+        printf("Program could not allocate %u elements.\n", newcap);
+        exit(EXIT_FAILURE);
+    }
+    *capacity = newcap;
+    return storage;
+}
+
+/**
+ * It calculates a hash code for the node with the specified fields.
+ * <p>
+ * The key of a number is the bit pattern of its value, such that the
+ * signed zeros are distinct, whereas the key of the other nodes is
+ * their auxiliary value.
+ *
+ * @param op  the node operation
+ * @param lhs the node left operand
+ * @param rhs the node right operand
+ * @param key the node key
+ *
+ * @return the node hash code
+ */
+static uint32_t
+hash(const uint32_t op, const uint32_t lhs, const uint32_t rhs, const uint64_t key) {
+    uint64_t h = 14695981039346656037ull;
+    h = (h ^ op)  * 1099511628211ull;
+    h = (h ^ lhs) * 1099511628211ull;
+    h = (h ^ rhs) * 1099511628211ull;
+    h = (h ^ key) * 1099511628211ull;
+    return (uint32_t)(h ^ h >> 32);
+}
+
+/**
+ * It returns the key of the specified node of the specified program.
+ *
+ * @param program the program
+ * @param node    the node
+ *
+ * @return the node key
+ */
+static uint64_t
+node_key(const struct program *program, const struct ast_node *node) {
+    uint64_t bits;
+    if (node->op != AST_NUMBER)
+        return node->aux;
+    memcpy(&bits, &program->consts[node->aux], sizeof(bits));
+    return bits;
+}
+
+/**
+ * It inserts the node at the specified index into the hash index of
+ * the specified program, doubling the index when it is half full.
+ *
+ * @param program the program
+ * @param index   the index of the node
+ */
+static void
+insert(struct program *program, const uint32_t index) {
+    /* It keeps the hash index at most half full */
+    if (program->count * 2 > program->mask + 1) {
+        const uint32_t capacity = (program->mask + 1) << 1;
+        uint32_t      *table    = malloc(sizeof(uint32_t) * capacity);
+
+        if (!table) {
+            printf("Program could not allocate %u elements.\n", capacity);
+            exit(EXIT_FAILURE);
+        }
+        memset(table, 0xFF, sizeof(uint32_t) * capacity);
+        for (uint32_t i = 0; i <= program->mask; i++) {
+            const uint32_t         n    = program->index[i];
+            const struct ast_node *node = &program->nodes[n];
+            uint32_t               h;
+
+            if (n == AST_NONE)
+                continue;
+            h = hash(node->op, node->lhs, node->rhs, node_key(program, node)) & (capacity - 1);
+            while (table[h] != AST_NONE)
+                h = (h + 1) & (capacity - 1);
+            table[h] = n;
+        }
+        free(program->index);
+        program->index = table;
+        program->mask  = capacity - 1;
+    }
+
+    const struct ast_node *node = &program->nodes[index];
+    uint32_t               h    = hash(node->op, node->lhs, node->rhs, node_key(program, node)) & program->mask;
+    while (program->index[h] != AST_NONE)
+        h = (h + 1) & program->mask;
+    program->index[h] = index;
+}
+
+/**
+ * It removes the node at the specified index from the hash index of
+ * the specified program.
+ * <p>
+ * The entries following the node in its probe are shifted backward
+ * into the freed slot, unless their own probe starts after it, such
+ * that every probe is still closed without a tombstone.
+ *
+ * @param program the program
+ * @param index   the index of the node, which is in the hash index
+ */
+static void
+erase(struct program *program, const uint32_t index) {
+    const struct ast_node *node = &program->nodes[index];
+    uint32_t               hole = hash(node->op, node->lhs, node->rhs, node_key(program, node)) & program->mask;
+    uint32_t               next;
+
+    while (program->index[hole] != index)
+        hole = (hole + 1) & program->mask;
+
+    for (next = (hole + 1) & program->mask; program->index[next] != AST_NONE; next = (next + 1) & program->mask) {
+        const struct ast_node *moved = &program->nodes[program->index[next]];
+        const uint32_t         home  = hash(moved->op, moved->lhs, moved->rhs, node_key(program, moved))
+                                     & program->mask;
+
+        /* It checks if the probe of the entry starts after the hole, */
+        /* in which case the entry stays where it is */
+        if (((next - home) & program->mask) < ((next - hole) & program->mask))
+            continue;
+
+        program->index[hole] = program->index[next];
+        hole                 = next;
+    }
+    program->index[hole] = AST_NONE;
+}
+
+/**
+ * It finds the node with the specified fields in the specified program.
+ * <p>
+ * If the node is found, then it is counted as eliminated, since the
+ * caller shares it instead of appending an equal node.
+ *
+ * @param program the program
+ * @param op      the node operation
+ * @param lhs     the node left operand
+ * @param rhs     the node right operand
+ * @param key     the node key
+ *
+ * @return the index of the node, or AST_NONE if there is none
+ */
+static uint32_t
+find(struct program *program, const uint32_t op, const uint32_t lhs, const uint32_t rhs, const uint64_t key) {
+    uint32_t h = hash(op, lhs, rhs, key) & program->mask;
+    uint32_t n;
+    while ((n = program->index[h]) != AST_NONE) {
+        const struct ast_node *node = &program->nodes[n];
+        if (node->op == op && node->lhs == lhs && node->rhs == rhs && node_key(program, node) == key) {
+            program->eliminated++;
+            return n;
+        }
+        h = (h + 1) & program->mask;
+    }
+    return AST_NONE;
+}
+
+/**
+ * It appends the specified node to the specified program.
+ *
+ * @param program the program
+ * @param op      the node operation
+ * @param lhs     the node left operand
+ * @param rhs     the node right operand
+ * @param aux     the node auxiliary value
+ *
+ * @return the index of the node
+ */
+static uint32_t
+append(struct program *program, const uint32_t op, const uint32_t lhs, const uint32_t rhs, const uint32_t aux) {
+    if (program->count == program->capacity)
+        program->nodes = grow(program->nodes, &program->capacity, sizeof(struct ast_node), program->count + 1);
+    struct ast_node *node = &program->nodes[program->count];
+    node->op  = op;
+    node->lhs = lhs;
+    node->rhs = rhs;
+    node->aux = aux;
+    return program->count++;
+}
+
+/**
+ * It returns the node equal to the specified node in the specified
+ * program, appending the node if there is none.
+ *
+ * @param program the program
+ * @param op      the node operation
+ * @param lhs     the node left operand
+ * @param rhs     the node right operand
+ * @param aux     the node auxiliary value
+ *
+ * @return the index of the node
+ */
+static uint32_t
+cons(struct program *program, const uint32_t op, const uint32_t lhs, const uint32_t rhs, const uint32_t aux) {
+    uint32_t index = find(program, op, lhs, rhs, aux);
+    if (index == AST_NONE)
+        insert(program, index = append(program, op, lhs, rhs, aux));
+    return index;
+}
+
+/**
+ * It returns the statement owning the specified node of the specified
+ * program, which must have been appended by an ended statement.
+ *
+ * @param program the program
+ * @param index   the index of the node
+ *
+ * @return the index of the statement
+ */
+static uint32_t
+owner(const struct program *program, const uint32_t index) {
+    uint32_t lo = 0, hi = program->nstatements;
+
+    /* It finds the first statement ending after the node */
+    while (lo < hi) {
+        const uint32_t mid = lo + (hi - lo) / 2;
+        if (program->statements[mid].end > index)
+            hi = mid;
+        else lo = mid + 1;
+    }
+    return lo;
+}
+
+/**
+ * It adds the statement owning the specified node to the dependencies
+ * of the statement being ended, unless the node is its own.
+ *
+ * @param program the program
+ * @param begin   the first node of the statement being ended
+ * @param index   the index of the node, or AST_NONE
+ */
+static void
+depend(struct program *program, const uint32_t begin, const uint32_t index) {
+    if (index == AST_NONE || index >= begin)
+        return;
+    if (program->ndeps == program->depscap)
+        program->deps = grow(program->deps, &program->depscap, sizeof(uint32_t), program->ndeps + 1);
+    program->deps[program->ndeps++] = owner(program, index);
+}
+
+/**
+ * It compares the specified statement indices.
+ *
+ * @param a the first statement index
+ * @param b the second statement index
+ *
+ * @return a negative value, zero or a positive value if the first
+ *         index is less than, equal to or greater than the second
+ */
+static int
+compare(const void *a, const void *b) {
+    const uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * It ensures the specified slot is addressable in the frame of the
+ * specified program.
+ *
+ * @param program the program
+ * @param slot    the variable slot
+ */
+static void
+use_slot(struct program *program, const uint32_t slot) {
+    if (slot < program->nslots)
+        return;
+    if (slot >= program->slotscap) {
+        uint32_t capacity = program->slotscap;
+        program->stores = grow(program->stores, &program->slotscap, sizeof(uint32_t), slot + 1);
+        program->flags  = grow(program->flags, &capacity, sizeof(uint32_t), program->slotscap);
+    }
+    for (uint32_t s = program->nslots; s <= slot; s++) {
+        program->stores[s] = AST_NONE;
+        program->flags[s]  = 0;
+    }
+    program->nslots = slot + 1;
+}
+
+struct program *
+program_new() {
+    struct program *program = calloc(1, sizeof(struct program));
+    /* It checks if there is not enough memory to allocate a program */
+    if (!program) {
+        printf("A program could not be allocated.\n");
+        exit(EXIT_FAILURE);
+    }
+    program->nodes  = grow(NULL, &program->capacity, sizeof(struct ast_node), AST_INITIAL_NODES);
+    program->consts = grow(NULL, &program->constscap, sizeof(double), AST_INITIAL_CONSTS);
+    program->stores = grow(NULL, &program->slotscap, sizeof(uint32_t), AST_INITIAL_SLOTS);
+    program->flags  = calloc(program->slotscap, sizeof(uint32_t));
+    /* It checks if there is not enough memory to allocate the flags */
+    if (!program->flags) {
+        printf("Program could not allocate %u elements.\n", program->slotscap);
+        exit(EXIT_FAILURE);
+    }
+    program->index  = malloc(sizeof(uint32_t) * AST_INITIAL_INDEX);
+    program->mask   = AST_INITIAL_INDEX - 1;
+    program->result = AST_NONE;
+    /* It checks if there is not enough memory to allocate the index */
+    if (!program->index) {
+        printf("Program could not allocate %u elements.\n", AST_INITIAL_INDEX);
+        exit(EXIT_FAILURE);
+    }
+    memset(program->index, 0xFF, sizeof(uint32_t) * AST_INITIAL_INDEX);
+    return program;
+}
+
+void
+program_free(struct program *program) {
+    free(program->nodes);
+    free(program->consts);
+    free(program->stores);
+    free(program->flags);
+    free(program->index);
+    free(program->statements);
+    free(program->deps);
+    free(program);
+}
+
+size_t
+program_frame_size(const struct program *program) {
+    return (size_t)program->nslots + program->nresults + program->count;
+}
+
+uint32_t
+ast_number(struct program *program, const double value) {
+    uint64_t bits;
+    uint32_t index;
+
+    memcpy(&bits, &value, sizeof(bits));
+    if ((index = find(program, AST_NUMBER, AST_NONE, AST_NONE, bits)) != AST_NONE)
+        return index;
+    if (program->nconsts == program->constscap)
+        program->consts = grow(program->consts, &program->constscap, sizeof(double), program->nconsts + 1);
+    program->consts[program->nconsts] = value;
+    insert(program, index = append(program, AST_NUMBER, AST_NONE, AST_NONE, program->nconsts++));
+    return index;
+}
+
+uint32_t
+ast_load(struct program *program, const uint32_t slot) {
+    use_slot(program, slot);
+    return cons(program, AST_LOAD, AST_NONE, program->stores[slot], slot);
+}
+
+uint32_t
+ast_store(struct program *program, const uint32_t slot, const uint32_t value, const uint32_t flags) {
+    use_slot(program, slot);
+    program->flags[slot] = flags;
+    return program->stores[slot] = append(program, AST_STORE, value, AST_NONE, slot);
+}
+
+void
+ast_discard(struct program *program) {
+    const uint32_t begin = program->nstatements ? program->statements[program->nstatements - 1].end : 0;
+
+    if (program->count == begin)
+        return;
+
+    /* Only the discarded nodes are removed from the hash index, */
+    /* hence, an error costs as much as its own statement */
+    for (uint32_t i = begin; i < program->count; i++)
+        if (program->nodes[i].op != AST_STORE)
+            erase(program, i);
+
+    /* The constants of the discarded numbers are the last ones */
+    for (uint32_t i = begin; i < program->count; i++)
+        if (program->nodes[i].op == AST_NUMBER && program->nodes[i].aux < program->nconsts)
+            program->nconsts = program->nodes[i].aux;
+    program->count = begin;
+}
+
+uint32_t
+ast_unary(struct program *program, const uint32_t op, const uint32_t lhs) {
+    return cons(program, op, lhs, AST_NONE, 0);
+}
+
+uint32_t
+ast_binary(struct program *program, const uint32_t op, const uint32_t lhs, const uint32_t rhs) {
+    /* The operands of the commutative operations are ordered, */
+    /* such that a + b and b + a are the same node */
+    if ((op == AST_ADD || op == AST_MUL) && lhs > rhs)
+        return cons(program, op, rhs, lhs, 0);
+    return cons(program, op, lhs, rhs, 0);
+}
+
+uint32_t
+ast_statement(struct program *program, const uint32_t node, const int result) {
+    const uint32_t        begin = program->nstatements ? program->statements[program->nstatements - 1].end : 0;
+    struct ast_statement *statement;
+
+    if (program->nstatements == program->statementscap)
+        program->statements = grow(program->statements, &program->statementscap, sizeof(struct ast_statement),
+                                   program->nstatements + 1);
+
+    statement        = &program->statements[program->nstatements];
+    statement->end   = program->count;
+    statement->node  = node;
+    statement->deps  = program->ndeps;
+
+    /* The statement depends on the owners of the earlier nodes */
+    /* referred to by its nodes, e.g., the stores read by its loads */
+    depend(program, begin, node);
+    for (uint32_t i = begin; i < program->count; i++) {
+        depend(program, begin, program->nodes[i].lhs);
+        depend(program, begin, program->nodes[i].rhs);
+    }
+
+    /* It removes the repeated dependencies */
+    if (program->ndeps > statement->deps)
+        qsort(program->deps + statement->deps, program->ndeps - statement->deps, sizeof(uint32_t), compare);
+    statement->ndeps = 0;
+    for (uint32_t i = statement->deps; i < program->ndeps; i++)
+        if (statement->ndeps == 0 || program->deps[i] != program->deps[statement->deps + statement->ndeps - 1])
+            program->deps[statement->deps + statement->ndeps++] = program->deps[i];
+    program->ndeps = statement->deps + statement->ndeps;
+
+    statement->output = AST_NONE;
+    if (result) {
+        statement->output = program->nresults++;
+        program->result   = node;
+    }
+
+    return program->nstatements++;
+}
@@ -0,0 +1,278 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Ricardo Fares
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef AST_H
+#define AST_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * It represents the absence of a node index.
+ */
+#define AST_NONE (~(uint32_t)0)
+
+/**
+ * Expression tree node operations definition.
+ * <p>
+ * The operations of the math functions follow the same order
+ * as their lexer tokens.
+ */
+#define AST_NUMBER (0x0)
+#define AST_LOAD   (0x1)
+#define AST_STORE  (0x2)
+#define AST_ADD    (0x3)
+#define AST_SUB    (0x4)
+#define AST_MUL    (0x5)
+#define AST_DIV    (0x6)
+#define AST_POW    (0x7)
+#define AST_FACT   (0x8)
+#define AST_ABS    (0x9)
+#define AST_SIN    (0xA)
+#define AST_COS    (0xB)
+#define AST_TAN    (0xC)
+#define AST_CSC    (0xD)
+#define AST_SEC    (0xE)
+#define AST_COT    (0xF)
+#define AST_FLOOR  (0x10)
+#define AST_CEIL   (0x11)
+#define AST_SQRT   (0x12)
+#define AST_CBRT   (0x13)
+#define AST_LOG10  (0x14)
+#define AST_LOG2   (0x15)
+
+/* Structure Definitions */
+
+/**
+ * An expression tree node.
+ * <p>
+ * The nodes do not point to each other, instead, they refer to
+ * their operands by their 32-bit index in the program nodes.
+ * The meaning of the fields depends on the node operation:
+ *
+ *      AST_NUMBER: aux is the index of the value in the program constants
+ *      AST_LOAD:   aux is the variable slot and rhs is the index of the
+ *                  last node storing into the slot, or AST_NONE
+ *      AST_STORE:  aux is the variable slot and lhs is the stored value
+ *      unary:      lhs is the operand
+ *      binary:     lhs and rhs are the operands
+ */
+struct ast_node {
+    uint32_t op;
+    uint32_t lhs;
+    uint32_t rhs;
+    uint32_t aux;
+};
+
+/**
+ * A statement of a program, either a definition or a result.
+ * <p>
+ * The nodes appended while compiling a statement follow those of the
+ * previous statement, hence, each statement owns a contiguous range of
+ * nodes ending at <em>end</em>. A statement depends on the statements
+ * owning the earlier nodes its own nodes refer to, that is, the stores
+ * read by its variables and the subexpressions shared with them.
+ */
+struct ast_statement {
+    uint32_t end;    /* the end of the nodes of the statement */
+    uint32_t node;   /* the store of a definition, or the value of a result */
+    uint32_t output; /* the index of a result among the results, or AST_NONE */
+    uint32_t deps;   /* the index of the first dependency in program->deps */
+    uint32_t ndeps;  /* the amount of statements the statement depends on */
+};
+
+/**
+ * A compiled program.
+ * <p>
+ * The nodes are stored contiguously in <b>post-order</b>, that is, a
+ * node is always stored after its operands. Therefore, a program is
+ * evaluated by a single forward sweep over its nodes, without recursion
+ * and without chasing pointers.
+ * <p>
+ * The nodes are <em>hash-consed</em>, that is, appending a node equal
+ * to an existing one returns the existing node instead. Therefore, the
+ * program is a DAG in which each distinct subexpression is computed once.
+ * The loads are distinguished by the last store into their slot, hence,
+ * two loads are equal only if they read the same value, whereas the
+ * stores are never shared.
+ * <p>
+ * The variables are addressed by <em>slots</em> in a frame of doubles
+ * provided by the caller of the evaluation. The semantic flags of the
+ * variable in each slot, e.g., whether it is a constant, are kept so
+ * that the optimization passes know which loads may be folded.
+ * <p>
+ * A program has several statements, each result of which produces its
+ * own output. The evaluations leave the value of each result in the
+ * frame, right after the variables, whereas <em>result</em> is the last
+ * one, which the evaluations return.
+ */
+struct program {
+    struct ast_node      *nodes;
+    uint32_t              count;
+    uint32_t              capacity;
+    double               *consts;
+    uint32_t              nconsts;
+    uint32_t              constscap;
+    uint32_t             *stores;
+    uint32_t             *flags;
+    uint32_t              nslots;
+    uint32_t              slotscap;
+    uint32_t             *index;      /* hash index of the shared nodes */
+    uint32_t              mask;
+    uint32_t              eliminated; /* amount of nodes found in the index */
+    struct ast_statement *statements;
+    uint32_t              nstatements;
+    uint32_t              statementscap;
+    uint32_t             *deps;       /* the dependencies of every statement */
+    uint32_t              ndeps;
+    uint32_t              depscap;
+    uint32_t              nresults;
+    uint32_t              result;
+};
+
+/* Program Function Declaration */
+
+/**
+ * It allocates an empty <em>program</em> structure and returns a
+ * pointer to the allocated memory.
+ * <p>
+ * If there is not enough memory to allocate the program, then the
+ * application is immediately terminated.
+ *
+ * @return a pointer to the memory allocated for the <em>program</em>
+ */
+struct program *
+program_new();
+
+/**
+ * It frees the specified program.
+ *
+ * @param program the program
+ */
+void
+program_free(struct program *program);
+
+/**
+ * It returns the amount of doubles the frame of an evaluation of
+ * the specified program must have.
+ * <p>
+ * The frame starts with the <em>program->nslots</em> variables, which
+ * are followed by the <em>program->nresults</em> results.
+ *
+ * @param program the program
+ *
+ * @return the frame size in doubles
+ */
+size_t
+program_frame_size(const struct program *program);
+
+/**
+ * It appends a number node to the specified program.
+ *
+ * @param program the program
+ * @param value   the number value
+ *
+ * @return the index of the node
+ */
+uint32_t
+ast_number(struct program *program, double value);
+
+/**
+ * It appends a node loading the variable in the specified slot to
+ * the specified program.
+ *
+ * @param program the program
+ * @param slot    the variable slot
+ *
+ * @return the index of the node
+ */
+uint32_t
+ast_load(struct program *program, uint32_t slot);
+
+/**
+ * It appends a node storing the specified value into the variable
+ * in the specified slot to the specified program.
+ *
+ * @param program the program
+ * @param slot    the variable slot
+ * @param value   the index of the node computing the value
+ * @param flags   the semantic flags of the variable
+ *
+ * @return the index of the node
+ */
+uint32_t
+ast_store(struct program *program, uint32_t slot, uint32_t value, uint32_t flags);
+
+/**
+ * It ends the statement whose nodes have been appended since the end
+ * of the previous statement, recording the statements it depends on.
+ * <p>
+ * If the statement is a result, then it becomes the last result of
+ * the program.
+ *
+ * @param program the program
+ * @param node    the store of a definition, or the value of a result
+ * @param result  whether the statement is a result
+ *
+ * @return the index of the statement
+ */
+uint32_t
+ast_statement(struct program *program, uint32_t node, int result);
+
+/**
+ * It discards the nodes appended since the end of the last statement,
+ * e.g., those of a statement having an error, such that the statements
+ * appended next do not share them.
+ * @param program the program
+ */
+void
+ast_discard(struct program *program);
+
+/**
+ * It appends a node applying the specified unary operation to the
+ * specified operand to the specified program.
+ *
+ * @param program the program
+ * @param op      the unary operation
+ * @param lhs     the index of the operand node
+ *
+ * @return the index of the node
+ */
+uint32_t
+ast_unary(struct program *program, uint32_t op, uint32_t lhs);
+
+/**
+ * It appends a node applying the specified binary operation to the
+ * specified operands to the specified program.
+ *
+ * @param program the program
+ * @param op      the binary operation
+ * @param lhs     the index of the left operand node
+ * @param rhs     the index of the right operand node
+ *
+ * @return the index of the node
+ */
+uint32_t
+ast_binary(struct program *program, uint32_t op, uint32_t lhs, uint32_t rhs);
+
+#endif // AST_H
@@ -0,0 +1,216 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Ricardo Fares
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "./simd.h"
+#include "./batch.h"
+
+/**
+ * The storage private to each worker evaluating the blocks.
+ */
+struct batch_scratch {
+    const double **values;  /* the values of each node in the block */
+    double        *storage; /* the storage of the node values */
+};
+
+/**
+ * An evaluation of a program over the rows of some columns, whose
+ * chunks of rows are evaluated by the workers of a pool.
+ */
+struct batch {
+    const struct program  *program;
+    simd_kernel            kernel;
+    const double         **bound;   /* the column bound to each slot, or NULL */
+    double                *zeros;   /* the value of the variables never stored */
+    size_t                 block;   /* the amount of rows of a block */
+    size_t                 chunk;   /* the amount of rows of a chunk */
+    size_t                 rows;
+    double *const         *outs;    /* the output of each result */
+    struct batch_scratch  *scratch; /* the storage of each worker */
+};
+
+/**
+ * It returns the storage of the specified worker, allocating it on its
+ * first use, such that its memory is first touched by the worker.
+ * <p>
+ * If there is not enough memory, then the application is immediately
+ * terminated.
+ *
+ * @param batch  the evaluation
+ * @param worker the worker
+ *
+ * @return the storage of the worker
+ */
+static struct batch_scratch *
+scratch_of(const struct batch *batch, const unsigned worker) {
+    const struct program *program = batch->program;
+    struct batch_scratch *scratch = &batch->scratch[worker];
+    const size_t          block   = batch->block;
+
+    if (scratch->values)
+        return scratch;
+
+    scratch->values  = malloc(sizeof(const double *) * (program->count + 1));
+    scratch->storage = malloc(sizeof(double) * block * (program->count + 1));
+
+    /* It checks if the evaluation storage could not be allocated */
+    if (!scratch->values || !scratch->storage) {
+        printf("evaluate_batch: The storage of %u nodes could not be allocated.\n", program->count);
+        exit(EXIT_FAILURE);
+    }
+
+    /* The numbers are the same in every block, hence, */
+    /* they are broadcast only once */
+    for (uint32_t i = 0; i < program->count; i++) {
+        if (program->nodes[i].op != AST_NUMBER)
+            continue;
+        for (size_t j = 0; j < block; j++)
+            scratch->storage[i * block + j] = program->consts[program->nodes[i].aux];
+        scratch->values[i] = &scratch->storage[i * block];
+    }
+
+    return scratch;
+}
+
+/**
+ * It evaluates the rows of the specified chunk, a block at a time.
+ * <p>
+ * Each chunk writes its own rows of the output, hence, the output does
+ * not depend on the worker evaluating it.
+ *
+ * @param arg    the evaluation
+ * @param index  the chunk
+ * @param worker the worker
+ */
+static void
+evaluate_chunk(void *arg, const size_t index, const unsigned worker) {
+    const struct batch     *batch   = arg;
+    const struct ast_node  *nodes   = batch->program->nodes;
+    struct batch_scratch   *scratch = scratch_of(batch, worker);
+    const double          **values  = scratch->values;
+    const size_t            block   = batch->block;
+    const size_t            first   = index * batch->chunk;
+    const size_t            last    = first + batch->chunk < batch->rows ? first + batch->chunk : batch->rows;
+
+    for (size_t base = first; base < last; base += block) {
+        const size_t n = last - base < block ? last - base : block;
+
+        for (uint32_t i = 0; i < batch->program->count; i++) {
+            const struct ast_node *node = &nodes[i];
+
+            switch (node->op) {
+                case AST_NUMBER:
+                    break;
+                case AST_LOAD:
+                    /* A bound variable reads its column, whereas the others read */
+                    /* the values of their last store, without copying them */
+                    if (batch->bound[node->aux])
+                        values[i] = batch->bound[node->aux] + base;
+                    else if (node->rhs != AST_NONE)
+                        values[i] = values[node->rhs];
+                    else values[i] = batch->zeros;
+                    break;
+                case AST_STORE:
+                    values[i] = values[node->lhs];
+                    break;
+                default:
+                    batch->kernel(node->op, n, &scratch->storage[i * block], values[node->lhs],
+                                  node->rhs != AST_NONE ? values[node->rhs] : NULL);
+                    values[i] = &scratch->storage[i * block];
+            }
+        }
+
+        for (uint32_t i = 0; i < batch->program->nstatements; i++) {
+            const struct ast_statement *statement = &batch->program->statements[i];
+            if (statement->output != AST_NONE)
+                memcpy(batch->outs[statement->output] + base, values[statement->node], sizeof(double) * n);
+        }
+    }
+}
+
+/**
+ * It returns the size in bytes of the L2 cache of the processor, or an
+ * estimate if it is unknown.
+ *
+ * @return the size of the L2 cache
+ */
+static size_t
+l2_size() {
+#if defined(_SC_LEVEL2_CACHE_SIZE)
+    const long size = sysconf(_SC_LEVEL2_CACHE_SIZE);
+    if (size > 0)
+        return (size_t)size;
+#endif
+    return 1024 * 1024;
+}
+
+void
+evaluate_batch(const struct program *program, const struct column *columns, const uint32_t ncolumns,
+               const size_t rows, double *const *outs, struct pool *pool) {
+    const unsigned nworkers = pool ? pool->nworkers : 1;
+    struct batch   batch    = { program, simd_select(simd_detect()), NULL, NULL, BATCH_BLOCK, 0, rows, outs, NULL };
+    size_t         nchunks;
+
+    /* It checks if the program is too large for a full block of rows */
+    if ((size_t)program->count * batch.block * sizeof(double) > BATCH_SCRATCH)
+        batch.block = BATCH_SCRATCH / ((size_t)program->count * sizeof(double));
+    batch.block = batch.block < SIMD_LANES ? SIMD_LANES : batch.block - batch.block % SIMD_LANES;
+
+    /* A chunk streams its rows of the columns and of the output through */
+    /* the L2 cache, which also holds the values of a block */
+    batch.chunk = l2_size() / 2 / (sizeof(double) * (ncolumns + 1));
+    batch.chunk = batch.chunk < batch.block ? batch.block : batch.chunk - batch.chunk % batch.block;
+    nchunks     = (rows + batch.chunk - 1) / batch.chunk;
+
+    batch.bound   = calloc(program->nslots + 1, sizeof(const double *));
+    batch.zeros   = calloc(batch.block, sizeof(double));
+    batch.scratch = calloc(nworkers, sizeof(struct batch_scratch));
+
+    /* It checks if the evaluation storage could not be allocated */
+    if (!batch.bound || !batch.zeros || !batch.scratch) {
+        printf("evaluate_batch: The storage of %u nodes could not be allocated.\n", program->count);
+        exit(EXIT_FAILURE);
+    }
+
+    for (uint32_t c = 0; c < ncolumns; c++)
+        batch.bound[columns[c].slot] = columns[c].values;
+
+    if (pool)
+        pool_run(pool, nchunks, evaluate_chunk, &batch);
+    else {
+        for (size_t i = 0; i < nchunks; i++)
+            evaluate_chunk(&batch, i, 0);
+    }
+
+    for (unsigned w = 0; w < nworkers; w++) {
+        free(batch.scratch[w].values);
+        free(batch.scratch[w].storage);
+    }
+    free(batch.bound);
+    free(batch.zeros);
+    free(batch.scratch);
+}
@@ -0,0 +1,93 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Ricardo Fares
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "../ast/ast.h"
+#include "../util/pool.h"
+
+/**
+ * The maximum amount of rows evaluated at a time.
+ */
+#define BATCH_BLOCK (512)
+
+/**
+ * The maximum size in bytes of the scratch storage of the node values
+ * of a block. The larger programs evaluate fewer rows at a time.
+ */
+#define BATCH_SCRATCH (4 * 1024 * 1024)
+
+/* Structure Definitions */
+
+/**
+ * A column of values bound to a variable.
+ */
+struct column {
+    uint32_t      slot;   /* the slot of the bound variable */
+    const double *values; /* the value of the variable in each row */
+};
+
+/* Function Declaration */
+
+/**
+ * It evaluates the specified program once for each row of the specified
+ * columns, writing the value of each program result in each row into the
+ * output of the result.
+ * <p>
+ * The variables bound to a column read the column value in the row being
+ * evaluated, hence, the stores into them are ignored. The other variables
+ * keep their values in the program.
+ * <p>
+ * Rather than sweeping the program once per row, each node is applied to
+ * a block of contiguous rows at a time, such that the dispatch on the node
+ * operation is paid once per block and the inner loops run over arrays.
+ * The blocks are computed by the vectorized kernels of the widest
+ * instruction set of the processor, hence, the math functions may differ
+ * from the other evaluators within the error bounds of the kernels.
+ * <p>
+ * The rows are split into chunks, sized such that the rows of a chunk
+ * stay in the L2 cache, which are evaluated by the workers of the
+ * specified pool. Each chunk writes its own rows of the output, hence,
+ * the output is the same for any amount of workers. The program is only
+ * read, hence, it may be evaluated by several threads at a time.
+ * <p>
+ * If there is not enough memory to evaluate the program, then the
+ * application is immediately terminated.
+ *
+ * @param program  the program to be evaluated
+ * @param columns  the columns bound to variables of the program
+ * @param ncolumns the amount of columns
+ * @param rows     the amount of rows of every column
+ * @param outs     the output of <em>rows</em> doubles of each result
+ * @param pool     the pool evaluating the chunks, or NULL to evaluate
+ *                 them on the calling thread
+ */
+void
+evaluate_batch(const struct program *program, const struct column *columns, uint32_t ncolumns,
+               size_t rows, double *const *outs, struct pool *pool);
+
+#endif // BATCH_H
@@ -0,0 +1,760 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Ricardo Fares
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "../ast/ast.h"
+#include "../eval/eval.h"
+#include "./simd.h"
+
+/*
+ * The kernels rely on the exact rounding of each operation, e.g., to
+ * split a double into two halves, hence, the compiler must not fuse a
+ * multiplication and an addition. Further, the square root must not
+ * set errno, such that it is a single instruction. The build passes
+ * -ffp-contract=off and -fno-math-errno, since GCC ignores the latter
+ * as a pragma.
+ */
+#if defined(__clang__)
+#pragma clang fp contract(off)
+#endif
+
+/*
+ * The vectors are only passed between always inlined functions, hence,
+ * the changes of their calling convention do not matter. The build also
+ * passes -Wno-psabi, since some of those notes cannot be ignored here.
+ */
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wpsabi"
+#endif
+
+#if defined(__GNUC__)
+
+/**
+ * The vectors of the kernels, whose operations are compiled by the
+ * compiler into the instructions of the target instruction set.
+ */
+typedef double   v8d __attribute__((vector_size(SIMD_LANES * sizeof(double))));
+typedef int64_t  v8l __attribute__((vector_size(SIMD_LANES * sizeof(int64_t))));
+
+/**
+ * The halves of the vectors of the kernels, which every instruction
+ * set compares natively.
+ */
+typedef double   v2d __attribute__((vector_size(2 * sizeof(double))));
+typedef int64_t  v2l __attribute__((vector_size(2 * sizeof(int64_t))));
+
+#define INLINE static inline __attribute__((always_inline))
+
+/**
+ * The bit masks of the sign and of the high word of a double.
+ */
+#define SIGN (INT64_MIN)
+#define HIGH ((int64_t)0xFFFFFFFF00000000)
+
+/**
+ * The magic number whose addition rounds a double to an integer,
+ * which is kept in the low bits of the sum.
+ */
+#define ROUND (0x1.8p52)
+
+/**
+ * It broadcasts the specified operand unless it is already a vector.
+ */
+#define VECTOR(x) _Generic((x), v8d: (x), default: (v8d){ 0 } + (x))
+
+/**
+ * It returns the lanes <em>i</em> and <em>i + 1</em> of a vector.
+ */
+#define HALF(v, i) __builtin_shufflevector((v), (v), (i), (i) + 1)
+
+/**
+ * It compares the lanes of two vectors, or of a vector and a double, by
+ * the specified operator, and returns a mask of the lanes in which the
+ * comparison holds.
+ * <p>
+ * GCC compiles a comparison of vectors wider than the instruction set
+ * into a comparison of each lane, hence, it is made of comparisons of
+ * two lanes, which the narrower instruction sets have.
+ */
+#define COMPARE(a, op, b) __extension__ ({                                             \
+    const v8d a_ = VECTOR(a), b_ = VECTOR(b);                                         \
+    join(HALF(a_, 0) op HALF(b_, 0), HALF(a_, 2) op HALF(b_, 2), HALF(a_, 4) op HALF(b_, 4), \
+         HALF(a_, 6) op HALF(b_, 6));                                                  \
+})
+
+/* Vector Helpers */
+
+/**
+ * It loads a vector from the specified unaligned values.
+ *
+ * @param values the values
+ *
+ * @return the vector
+ */
+INLINE v8d
+load(const double *values) {
+    v8d v;
+    memcpy(&v, values, sizeof(v));
+    return v;
+}
+
+/**
+ * It stores the specified vector into the specified unaligned values.
+ *
+ * @param values the values
+ * @param v      the vector
+ */
+INLINE void
+store(double *values, const v8d v) {
+    memcpy(values, &v, sizeof(v));
+}
+
+/**
+ * It joins the specified masks of two lanes into a mask of a vector.
+ *
+ * @param m0 the mask of the lanes 0 and 1
+ * @param m1 the mask of the lanes 2 and 3
+ * @param m2 the mask of the lanes 4 and 5
+ * @param m3 the mask of the lanes 6 and 7
+ *
+ * @return the mask
+ */
+INLINE v8l
+join(const v2l m0, const v2l m1, const v2l m2, const v2l m3) {
+    return __builtin_shufflevector(__builtin_shufflevector(m0, m1, 0, 1, 2, 3),
+                                   __builtin_shufflevector(m2, m3, 0, 1, 2, 3), 0, 1, 2, 3, 4, 5, 6, 7);
+}
+
+/**
+ * It checks if any lane of the specified mask is set.
+ *
+ * @param mask the mask
+ *
+ * @return 1 if any lane is set, 0 otherwise
+ */
+INLINE int
+any(const v8l mask) {
+    const v2l m = HALF(mask, 0) | HALF(mask, 2) | HALF(mask, 4) | HALF(mask, 6);
+    return (m[0] | m[1]) != 0;
+}
+
+/**
+ * It blends the lanes of <em>a</em> in which the specified mask is
+ * set, and the lanes of <em>b</em> otherwise.
+ *
+ * @param mask the mask, whose lanes are either all ones or all zeros
+ * @param a    the vector selected by the set lanes
+ * @param b    the vector selected by the unset lanes
+ *
+ * @return the blended vector
+ */
+INLINE v8d
+blend(const v8l mask, const v8d a, const v8d b) {
+    return (v8d)((mask & (v8l)a) | (~mask & (v8l)b));
+}
+
+/**
+ * It returns the absolute value of each lane.
+ *
+ * @param x the vector
+ *
+ * @return the absolute vector
+ */
+INLINE v8d
+vabs(const v8d x) {
+    return (v8d)((v8l)x & ~SIGN);
+}
+
+/**
+ * It clears the low word of each lane, such that the product of two
+ * such lanes is exact.
+ *
+ * @param x the vector
+ *
+ * @return the vector with the low words cleared
+ */
+INLINE v8d
+high(const v8d x) {
+    return (v8d)((v8l)x & HIGH);
+}
+
+/**
+ * It computes the error of the product of each lane of <em>a</em> and
+ * <em>b</em>, that is, <em>a * b - p</em> exactly, by splitting the
+ * operands into halves (Dekker). The operands must be far from the
+ * overflow.
+ *
+ * @param a the left operand
+ * @param b the right operand
+ * @param p the rounded product of the operands
+ *
+ * @return the error of the product
+ */
+INLINE v8d
+product_error(const v8d a, const v8d b, const v8d p) {
+    const v8d ca = a * 134217729.0, cb = b * 134217729.0;
+    const v8d ah = ca - (ca - a),   bh = cb - (cb - b);
+    const v8d al = a - ah,          bl = b - bh;
+    return ((ah * bh - p) + ah * bl + al * bh) + al * bl;
+}
+
+/* Trigonometric Functions (after FreeBSD msun) */
+
+/**
+ * It reduces each lane of <em>x</em> to <em>y0 + y1</em> in
+ * [-pi/4, pi/4], such that <em>x = n * pi/2 + y0 + y1</em>, by
+ * subtracting n * pi/2 in three parts (Cody and Waite).
+ * <p>
+ * The reduction is accurate for |x| < 2^19 * pi/2.
+ *
+ * @param x  the vector
+ * @param y0 the head of the reduced vector
+ * @param y1 the tail of the reduced vector
+ *
+ * @return the quadrant n of each lane
+ */
+INLINE v8l
+reduce(const v8d x, v8d *y0, v8d *y1) {
+    const v8d rounded = x * 6.36619772367581382433e-01 + ROUND;
+    const v8d fn      = rounded - ROUND;
+    v8d       r, t, w;
+
+    r = x - fn * 1.57079632673412561417e+00;
+    t = r;
+    w = fn * 6.07710050630396597660e-11;
+    r = t - w;
+    w = fn * 2.02226624879595063154e-21 - ((t - r) - w);
+    t = r;
+    w = fn * 2.02226624871116645580e-21;
+    r = t - w;
+    w = fn * 8.47842766036889956997e-32 - ((t - r) - w);
+
+    *y0 = r - w;
+    *y1 = (r - *y0) - w;
+    return (v8l)rounded;
+}
+
+/**
+ * It computes the sine of <em>x + y</em> in [-pi/4, pi/4].
+ *
+ * @param x the head of the argument
+ * @param y the tail of the argument
+ *
+ * @return the sine
+ */
+INLINE v8d
+kernel_sin(const v8d x, const v8d y) {
+    const v8d z = x * x;
+    const v8d v = z * x;
+    const v8d r = 8.33333333332248946124e-03 + z * (-1.98412698298579493134e-04 +
+                  z * (2.75573137070700676789e-06 + z * (-2.50507602534068634195e-08 +
+                  z * 1.58969099521155010221e-10)));
+    return x - ((z * (0.5 * y - v * r) - y) - v * -1.66666666666666324348e-01);
+}
+
+/**
+ * It computes the cosine of <em>x + y</em> in [-pi/4, pi/4].
+ *
+ * @param x the head of the argument
+ * @param y the tail of the argument
+ *
+ * @return the cosine
+ */
+INLINE v8d
+kernel_cos(const v8d x, const v8d y) {
+    const v8d z  = x * x;
+    const v8d w  = z * z;
+    const v8d r  = z * (4.16666666666666019037e-02 + z * (-1.38888888888741095749e-03 +
+                   z * 2.48015872894767294178e-05)) + w * w * (-2.75573143513906633035e-07 +
+                   z * (2.08757232129817482790e-09 + z * -1.13596475577881948265e-11));
+    const v8d hz = 0.5 * z;
+    const v8d u  = 1.0 - hz;
+    return u + (((1.0 - u) - hz) + (z * r - x * y));
+}
+
+/**
+ * It computes the tangent of <em>x + y</em> in [-pi/4, pi/4] if the
+ * lane of <em>odd</em> is zero, otherwise, minus its cotangent.
+ *
+ * @param x   the head of the argument
+ * @param y   the tail of the argument
+ * @param odd the lanes in which the cotangent is computed
+ *
+ * @return the tangent or minus the cotangent
+ */
+INLINE v8d
+kernel_tan(v8d x, v8d y, const v8l odd) {
+    const v8l big  = COMPARE(vabs(x), >=, 0.67434);
+    const v8l neg  = COMPARE(x, <, 0.0);
+    const v8d sign = blend(neg, (v8d){ 0 } - 1.0, (v8d){ 0 } + 1.0);
+    const v8d iy   = blend(odd, (v8d){ 0 } - 1.0, (v8d){ 0 } + 1.0);
+    const v8d xa   = blend(neg, -x, x), ya = blend(neg, -y, y);
+    v8d       z, w, r, v, s, a, t, small;
+
+    /* The arguments near pi/4 are reflected to pi/4 - x */
+    x = blend(big, (7.85398163397448278999e-01 - xa) + (3.06161699786838301793e-17 - ya), x);
+    y = blend(big, (v8d){ 0 }, y);
+
+    z = x * x;
+    w = z * z;
+    r = 1.33333333333201242699e-01 + w * (2.18694882948595424599e-02 + w * (3.59207910759131235356e-03 +
+        w * (5.88041240820264096874e-04 + w * (7.81794442939557092300e-05 + w * -1.85586374855275456654e-05))));
+    v = z * (5.39682539762260521377e-02 + w * (8.86323982359930005737e-03 + w * (1.45620945432529025516e-03 +
+        w * (2.46463134818469906812e-04 + w * (7.14072491382608190305e-05 + w * 2.59073051863633712884e-05)))));
+    s = z * x;
+    r = y + z * (s * (r + v) + y);
+    r = r + 3.33333333333334091986e-01 * s;
+    w = x + r;
+
+    /* It computes -1 / (x + r) accurately for the cotangent */
+    z     = high(w);
+    v     = r - (z - x);
+    a     = -1.0 / w;
+    t     = high(a);
+    s     = 1.0 + t * z;
+    small = blend(odd, t + a * (s + t * v), w);
+
+    return blend(big, sign * (iy - 2.0 * (x - (w * w / (w + iy) - r))), small);
+}
+
+/**
+ * It computes the sine of each lane.
+ *
+ * @param x the vector
+ *
+ * @return the sine vector
+ */
+INLINE v8d
+vsin(const v8d x) {
+    v8d       y0, y1;
+    const v8l n = reduce(x, &y0, &y1);
+    const v8d s = kernel_sin(y0, y1), c = kernel_cos(y0, y1);
+    return (v8d)((v8l)blend(-(n & 1), c, s) ^ (n & 2) << 62);
+}
+
+/**
+ * It computes the cosine of each lane.
+ *
+ * @param x the vector
+ *
+ * @return the cosine vector
+ */
+INLINE v8d
+vcos(const v8d x) {
+    v8d       y0, y1;
+    const v8l n = reduce(x, &y0, &y1);
+    const v8d s = kernel_sin(y0, y1), c = kernel_cos(y0, y1);
+    return (v8d)((v8l)blend(-(n & 1), s, c) ^ ((n + 1) & 2) << 62);
+}
+
+/**
+ * It computes the tangent of each lane.
+ *
+ * @param x the vector
+ *
+ * @return the tangent vector
+ */
+INLINE v8d
+vtan(const v8d x) {
+    v8d       y0, y1;
+    const v8l n = reduce(x, &y0, &y1);
+    return kernel_tan(y0, y1, -(n & 1));
+}
+
+/* Logarithms (after FreeBSD msun) */
+
+/**
+ * It decomposes each lane of <em>x</em>, which must be a positive normal
+ * number, into <em>2^k * (1 + f)</em> with 1 + f in [sqrt(2)/2, sqrt(2)),
+ * and computes log(1 + f) as <em>hi + lo</em>, in which <em>hi</em> has
+ * its low word cleared.
+ *
+ * @param x  the vector
+ * @param hi the head of log(1 + f)
+ * @param lo the tail of log(1 + f)
+ *
+ * @return the exponent k of each lane
+ */
+INLINE v8d
+vlog(const v8d x, v8d *hi, v8d *lo) {
+    const v8l ix = (v8l)x;
+    v8l       hx = ix >> 32;
+    v8l       k  = (hx >> 20) - 1023;
+    v8l       i;
+    v8d       f, s, z, w, r, hfsq;
+
+    hx &= 0x000FFFFF;
+    i   = (hx + 0x95F64) & 0x100000;
+    k  += i >> 20;
+    f   = (v8d)((hx | (i ^ 0x3FF00000)) << 32 | (ix & 0xFFFFFFFF)) - 1.0;
+
+    s    = f / (2.0 + f);
+    z    = s * s;
+    w    = z * z;
+    r    = z * (6.666666666666735130e-01 + w * (2.857142874366239149e-01 + w * (1.818357216161805012e-01 +
+           w * 1.479819860511658591e-01))) + w * (3.999999999940941908e-01 + w * (2.222219843214978396e-01 +
+           w * 1.531383769920937332e-01));
+    hfsq = 0.5 * f * f;
+    r    = s * (hfsq + r);
+
+    *hi = high(f - hfsq);
+    *lo = (f - *hi) - hfsq + r;
+
+    /* The exponent is converted through the low bits of the magic number */
+    return (v8d)(k + (v8l)((v8d){ 0 } + ROUND)) - ROUND;
+}
+
+/**
+ * It computes the base 2 logarithm of each lane, which must be a
+ * positive normal number.
+ *
+ * @param x the vector
+ *
+ * @return the base 2 logarithm vector
+ */
+INLINE v8d
+vlog2(const v8d x) {
+    v8d       hi, lo, w, vhi, vlo;
+    const v8d k = vlog(x, &hi, &lo);
+
+    vhi = hi * 1.44269504072144627571e+00;
+    vlo = (lo + hi) * 1.67517131648865118353e-10 + lo * 1.44269504072144627571e+00;
+    w   = k + vhi;
+    vlo = vlo + ((k - w) + vhi);
+    return vlo + w;
+}
+
+/**
+ * It computes the base 10 logarithm of each lane, which must be a
+ * positive normal number.
+ *
+ * @param x the vector
+ *
+ * @return the base 10 logarithm vector
+ */
+INLINE v8d
+vlog10(const v8d x) {
+    v8d       hi, lo, w, vhi, vlo, y2;
+    const v8d k = vlog(x, &hi, &lo);
+
+    vhi = hi * 4.34294481878168880939e-01;
+    y2  = k * 3.01029995663611771306e-01;
+    vlo = k * 3.69423907715893078616e-13 + (lo + hi) * 2.50829467116452752298e-11 + lo * 4.34294481878168880939e-01;
+    w   = y2 + vhi;
+    vlo = vlo + ((y2 - w) + vhi);
+    return vlo + w;
+}
+
+/* Roots and Powers */
+
+/**
+ * It computes the cube root of each lane, which must be a normal
+ * number (after FreeBSD msun).
+ *
+ * @param x the vector
+ *
+ * @return the cube root vector
+ */
+INLINE v8d
+vcbrt(const v8d x) {
+    const v8l hx = (v8l)x >> 32 & 0x7FFFFFFF;
+    v8d       t, r, s, w;
+
+    /* It estimates the root to 5 bits by dividing the exponent by 3 */
+    t = (v8d)(((v8l)x & SIGN) | ((hx * 0xAAAAAAAB >> 33) + 715094163) << 32);
+
+    /* It refines the estimate to 23 bits with a polynomial */
+    r = (t * t) * (t / x);
+    t = t * ((1.87595182427177009643 + r * (-1.88497979543377169875 + r * 1.621429720105354466140)) +
+        ((r * r) * r) * (-0.758397934778766047437 + r * 0.145996192886612446982));
+
+    /* It rounds the estimate to 21 bits, such that its square is exact */
+    t = (v8d)(((v8l)t + 0x80000000) & (int64_t)0xFFFFFFFFC0000000);
+
+    /* It refines the estimate to 53 bits with a Newton step */
+    s = t * t;
+    r = x / s;
+    w = t + t;
+    r = (r - t) / (w + r);
+    return t + t * r;
+}
+
+/**
+ * It rounds each lane to an integer towards minus infinity.
+ *
+ * @param x the vector
+ *
+ * @return the floor vector
+ */
+INLINE v8d
+vfloor(const v8d x) {
+    const v8d magic = (v8d)(((v8l)x & SIGN) | (v8l)((v8d){ 0 } + 0x1p52));
+    v8d       r     = (x + magic) - magic;
+
+    r = r - blend(COMPARE(r, >, x), (v8d){ 0 } + 1.0, (v8d){ 0 });
+    r = (v8d)(((v8l)r & ~SIGN) | ((v8l)x & SIGN));
+    return blend(COMPARE(vabs(x), <, 0x1p52), r, x);
+}
+
+/**
+ * It rounds each lane to an integer towards plus infinity.
+ *
+ * @param x the vector
+ *
+ * @return the ceiling vector
+ */
+INLINE v8d
+vceil(const v8d x) {
+    const v8d magic = (v8d)(((v8l)x & SIGN) | (v8l)((v8d){ 0 } + 0x1p52));
+    v8d       r     = (x + magic) - magic;
+
+    r = r + blend(COMPARE(r, <, x), (v8d){ 0 } + 1.0, (v8d){ 0 });
+    r = (v8d)(((v8l)r & ~SIGN) | ((v8l)x & SIGN));
+    return blend(COMPARE(vabs(x), <, 0x1p52), r, x);
+}
+
+/**
+ * It computes each lane of <em>x</em> to the power of the integer lane
+ * of <em>y</em> from -4 to 4, keeping the powers in double-double
+ * precision, such that the result is rounded only once.
+ *
+ * @param x the base vector, 2^-200 < |x| < 2^200
+ * @param y the exponent vector
+ *
+ * @return the power vector
+ */
+INLINE v8d
+vpowi(const v8d x, const v8d y) {
+    const v8d m  = vabs(y);
+    const v8d x2 = x * x;
+    const v8d e2 = product_error(x, x, x2);
+    const v8d x3 = x2 * x;
+    const v8d e3 = product_error(x2, x, x3) + e2 * x;
+    const v8d x4 = x2 * x2;
+    const v8d e4 = product_error(x2, x2, x4) + 2.0 * x2 * e2;
+    v8d       h, l, q, p, rem;
+
+    h = blend(COMPARE(m, ==, 0.0), (v8d){ 0 } + 1.0, x);
+    l = (v8d){ 0 };
+    h = blend(COMPARE(m, ==, 2.0), x2, h), l = blend(COMPARE(m, ==, 2.0), e2, l);
+    h = blend(COMPARE(m, ==, 3.0), x3, h), l = blend(COMPARE(m, ==, 3.0), e3, l);
+    h = blend(COMPARE(m, ==, 4.0), x4, h), l = blend(COMPARE(m, ==, 4.0), e4, l);
+
+    /* The negative powers divide the double-double by a Newton step */
+    q   = 1.0 / h;
+    p   = q * h;
+    rem = ((1.0 - p) - product_error(q, h, p)) - q * l;
+
+    return blend(COMPARE(y, <, 0.0), q + q * rem, h + l);
+}
+
+/* Kernels */
+
+/**
+ * It applies the specified operation to the lanes of a vector.
+ * <p>
+ * The lanes out of the domain of a vectorized function are computed by
+ * the math library.
+ *
+ * @param op  the operation
+ * @param out the values of the node
+ * @param lhs the values of the left operand
+ * @param rhs the values of the right operand, or NULL
+ */
+INLINE void
+apply_lanes(const uint32_t op, double *out, const double *lhs, const double *rhs) {
+    const v8d a = load(lhs);
+    v8d       b = { 0 }, r;
+    v8l       scalar; /* the lanes computed by the math library */
+
+    if (rhs)
+        b = load(rhs);
+
+    switch (op) {
+        case AST_ADD:   store(out, a + b); return;
+        case AST_SUB:   store(out, a - b); return;
+        case AST_MUL:   store(out, a * b); return;
+        case AST_DIV:   store(out, a / b); return;
+        case AST_ABS:   store(out, vabs(a)); return;
+        case AST_FLOOR: store(out, vfloor(a)); return;
+        case AST_CEIL:  store(out, vceil(a)); return;
+        case AST_SQRT:
+            for (int j = 0; j < SIMD_LANES; j++)
+                r[j] = __builtin_sqrt(a[j]);
+            store(out, r);
+            return;
+        case AST_FACT:
+            for (int j = 0; j < SIMD_LANES; j++)
+                out[j] = factorial(a[j]);
+            return;
+        case AST_SIN: case AST_COS: case AST_TAN:
+        case AST_CSC: case AST_SEC: case AST_COT:
+            scalar = ~COMPARE(vabs(a), <, 0x1p19 * 1.57079632679489661923);
+            r      = op == AST_SIN || op == AST_CSC ? vsin(a) : op == AST_COS || op == AST_SEC ? vcos(a) : vtan(a);
+            if (op >= AST_CSC)
+                r = 1.0 / r;
+            break;
+        case AST_LOG10: case AST_LOG2:
+            scalar = ~(COMPARE(a, >=, 0x1p-1022) & COMPARE(a, <, __builtin_inf()));
+            r      = op == AST_LOG2 ? vlog2(a) : vlog10(a);
+            break;
+        case AST_CBRT:
+            scalar = ~(COMPARE(vabs(a), >=, 0x1p-1022) & COMPARE(vabs(a), <, __builtin_inf()));
+            r      = vcbrt(a);
+            break;
+        case AST_POW: {
+            const v8l integer = COMPARE((b + ROUND) - ROUND, ==, b) & COMPARE(vabs(b), <=, 4.0);
+            const v8l root    = COMPARE(b, ==, 0.5) & COMPARE(a, >=, 0.0) & COMPARE(a, <, __builtin_inf());
+            const v8l range   = COMPARE(vabs(a), >, 0x1p-200) & COMPARE(vabs(a), <, 0x1p200);
+
+            /* It checks if every lane is computed by the math library, e.g., x ** 1.5 */
+            scalar = ~((integer & range) | root);
+            if (!any(~scalar)) {
+                r = a;
+                break;
+            }
+
+            /* The power 1/2 is the square root, except for -0 */
+            for (int j = 0; j < SIMD_LANES; j++)
+                r[j] = __builtin_sqrt(root[j] ? a[j] : 1.0) + 0.0;
+            r = blend(integer & range, vpowi(a, b), r);
+            break;
+        }
+        default:
+            printf("apply_lanes: Should not reach here!");
+            exit(EXIT_FAILURE);
+    }
+
+    store(out, r);
+    if (any(scalar))
+        for (int j = 0; j < SIMD_LANES; j++)
+            if (scalar[j])
+                out[j] = apply(op, lhs[j], rhs ? rhs[j] : 0.0);
+}
+
+/**
+ * It applies the specified operation to a block of rows, a vector at
+ * a time. The last rows, which do not fill a vector, are padded.
+ *
+ * @param op  the operation
+ * @param n   the amount of rows in the block
+ * @param out the values of the node in the block
+ * @param lhs the values of the left operand in the block
+ * @param rhs the values of the right operand in the block, or NULL
+ */
+INLINE void
+apply_block(const uint32_t op, const size_t n, double *out, const double *lhs, const double *rhs) {
+    double a[SIMD_LANES], b[SIMD_LANES], r[SIMD_LANES];
+    size_t j = 0;
+
+    for (; j + SIMD_LANES <= n; j += SIMD_LANES)
+        apply_lanes(op, out + j, lhs + j, rhs ? rhs + j : NULL);
+
+    /* It checks if there are rows left, which are padded with ones */
+    if (j < n) {
+        for (size_t i = 0; i < SIMD_LANES; i++) {
+            a[i] = j + i < n ? lhs[j + i] : 1.0;
+            b[i] = j + i < n && rhs ? rhs[j + i] : 1.0;
+        }
+        apply_lanes(op, r, a, rhs ? b : NULL);
+        memcpy(out + j, r, sizeof(double) * (n - j));
+    }
+}
+
+#if defined(__x86_64__)
+__attribute__((target("avx512f"))) static void
+apply_avx512(const uint32_t op, const size_t n, double *out, const double *lhs, const double *rhs) {
+    apply_block(op, n, out, lhs, rhs);
+}
+
+__attribute__((target("avx2"))) static void
+apply_avx2(const uint32_t op, const size_t n, double *out, const double *lhs, const double *rhs) {
+    apply_block(op, n, out, lhs, rhs);
+}
+#endif
+
+static void
+apply_baseline(const uint32_t op, const size_t n, double *out, const double *lhs, const double *rhs) {
+    apply_block(op, n, out, lhs, rhs);
+}
+
+#else
+
+/**
+ * It applies the specified operation to a block of rows, a row at a
+ * time, since the compiler has no vector extensions.
+ *
+ * @param op  the operation
+ * @param n   the amount of rows in the block
+ * @param out the values of the node in the block
+ * @param lhs the values of the left operand in the block
+ * @param rhs the values of the right operand in the block, or NULL
+ */
+static void
+apply_baseline(const uint32_t op, const size_t n, double *out, const double *lhs, const double *rhs) {
+    for (size_t j = 0; j < n; j++)
+        out[j] = apply(op, lhs[j], rhs ? rhs[j] : 0.0);
+}
+
+#endif
+
+int
+simd_detect() {
+#if defined(__x86_64__) && defined(__GNUC__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+        return SIMD_AVX512;
+    if (__builtin_cpu_supports("avx2"))
+        return SIMD_AVX2;
+#endif
+    return SIMD_BASELINE;
+}
+
+simd_kernel
+simd_select(const int isa) {
+#if defined(__x86_64__) && defined(__GNUC__)
+    switch (isa) {
+        case SIMD_AVX512: return apply_avx512;
+        case SIMD_AVX2:   return apply_avx2;
+    }
+#endif
+    (void)isa;
+    return apply_baseline;
+}
+
+const char *
+simd_name(const int isa) {
+    switch (isa) {
+        case SIMD_AVX512: return "avx512f";
+        case SIMD_AVX2:   return "avx2";
+    }
+#if defined(__x86_64__)
+    return "sse2";
+#else
+    return "generic";
+#endif
+}
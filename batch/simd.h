@@ -0,0 +1,113 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Ricardo Fares
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef SIMD_H
+#define SIMD_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Instruction sets of the vectorized kernels definition.
+ * <p>
+ * The baseline is SSE2 on x86-64, which every x86-64 processor has,
+ * and the portable vector code of the compiler on the other hosts.
+ */
+#define SIMD_BASELINE (0x0)
+#define SIMD_AVX2     (0x1)
+#define SIMD_AVX512   (0x2)
+
+/**
+ * The amount of doubles processed by a single vector operation of the
+ * kernels. The narrower instruction sets split it into several ones.
+ */
+#define SIMD_LANES (8)
+
+/**
+ * A vectorized kernel, which applies an operation to a block of rows.
+ * <p>
+ * The operation is neither a number, a load nor a store, and the right
+ * operand is ignored by the unary operations.
+ * <p>
+ * The kernels are not correctly rounded, instead, their maximum error
+ * in ULPs (units in the last place) against the math library is:
+ *
+ *      +, -, *, /, |x|, [x], floor, ceil, sqrt    0, i.e., the same value
+ *      sin, cos, log2, x ** y                     1
+ *      tan, log10, csc, sec, cot                  2
+ *      cbrt                                       3
+ *
+ * The bounds of log10 and cbrt are mostly the error of the math library
+ * itself, since their kernels are within 1 ULP of the exact value.
+ * <p>
+ * The trigonometric functions are vectorized for |x| < 2^19 * pi / 2,
+ * the logarithms and the cube root for the normal numbers, and the
+ * power for the integer exponents from -4 to 4 and the exponent 1/2,
+ * as long as 2^-200 < |x| < 2^200. The other lanes are computed by the
+ * math library, hence, they have no error at all.
+ * <p>
+ * Every instruction set computes the very same values, since the
+ * kernels are the same vector code and never contract a multiplication
+ * and an addition into a fused multiply-add.
+ *
+ * @param op  the operation
+ * @param n   the amount of rows in the block
+ * @param out the values of the node in the block
+ * @param lhs the values of the left operand in the block
+ * @param rhs the values of the right operand in the block, or NULL
+ */
+typedef void (*simd_kernel)(uint32_t op, size_t n, double *out, const double *lhs, const double *rhs);
+
+/* Function Declaration */
+
+/**
+ * It detects the widest instruction set supported by the processor,
+ * by querying the CPUID instruction.
+ *
+ * @return the widest supported instruction set
+ */
+int
+simd_detect();
+
+/**
+ * It returns the kernel compiled for the specified instruction set,
+ * which must be supported by the processor.
+ *
+ * @param isa the instruction set
+ *
+ * @return the kernel
+ */
+simd_kernel
+simd_select(int isa);
+
+/**
+ * It returns the name of the specified instruction set.
+ *
+ * @param isa the instruction set
+ *
+ * @return the name of the instruction set
+ */
+const char *
+simd_name(int isa);
+
+#endif // SIMD_H
@@ -0,0 +1,168 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Ricardo Fares
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <string.h>
+#include <math.h>
+
+#include "../lexer/lexer.h"
+#include "../parser/parser.h"
+#include "../eval/eval.h"
+#include "../opt/opt.h"
+#include "../batch/batch.h"
+#include "../batch/simd.h"
+
+/**
+ * It is a benchmark of the per-row latency of a formula evaluated over
+ * columns, a row at a time by the expression tree evaluator and a block
+ * of rows at a time by the batch evaluator, either on a single thread or
+ * on a pool of one thread per core.
+ * <p>
+ * It checks that the evaluators compute the same value in every row, up
+ * to the error of the vectorized math functions, and that the pool
+ * computes the very same output as a single thread.
+ */
+
+#define BENCH_ROWS (1 << 22)
+
+/**
+ * The relative difference allowed between the evaluators, which is far
+ * above the error of the vectorized math functions.
+ */
+#define BENCH_TOLERANCE (1e-12)
+
+/**
+ * The formula being evaluated, whose variables are bound to columns.
+ */
+static const char formula[] =
+    "$price := 120.5;\n"
+    "$A = 0;\n"
+    "$B = 0;\n"
+    "sqrt(A * A + B * B) * price + |A - B| * 0.25 - floor(B / 7) + log2(A * A + 1)\n";
+
+/**
+ * It returns the current time in seconds measured by a
+ * monotonic clock.
+ *
+ * @return the current time in seconds
+ */
+static double
+now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+int main() {
+    struct parser  *parser = parser_new();
+    struct program *parsed, *program;
+    struct column   columns[2];
+    double         *a      = malloc(sizeof(double) * BENCH_ROWS);
+    double         *b      = malloc(sizeof(double) * BENCH_ROWS);
+    double         *scalar = malloc(sizeof(double) * BENCH_ROWS);
+    double         *batch  = malloc(sizeof(double) * BENCH_ROWS);
+    double         *pooled = malloc(sizeof(double) * BENCH_ROWS);
+    struct pool    *pool   = pool_new(0);
+    double         *frame;
+    unsigned        seed   = 12345;
+    double          start, tree, block, parallel;
+
+    init_lexer_buffer(&parser->lexer, formula, sizeof(formula) - 1);
+    parsed  = compile(parser);
+    program = optimize(parsed);
+    frame   = calloc(program_frame_size(program), sizeof(double));
+
+    if (!a || !b || !scalar || !batch || !pooled || !frame) {
+        printf("bench: The columns could not be allocated.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    for (size_t i = 0; i < BENCH_ROWS; i++) {
+        a[i] = (double)(seed = seed * 1103515245u + 12345u) / 4294967296.0 * 200.0 - 100.0;
+        b[i] = (double)(seed = seed * 1103515245u + 12345u) / 4294967296.0 * 200.0 - 100.0;
+    }
+
+    columns[0] = (struct column){ intern_find(parser->lexer.symbols, "A", 1), a };
+    columns[1] = (struct column){ intern_find(parser->lexer.symbols, "B", 1), b };
+
+    /* The scalar evaluation binds the variables by turning their */
+    /* stores into loads, which leave the frame untouched */
+    for (uint32_t i = 0; i < program->count; i++) {
+        struct ast_node *node = &program->nodes[i];
+
+        if (node->op == AST_STORE && (node->aux == columns[0].slot || node->aux == columns[1].slot)) {
+            node->op  = AST_LOAD;
+            node->rhs = AST_NONE;
+        }
+    }
+
+    start = now();
+    for (size_t i = 0; i < BENCH_ROWS; i++) {
+        frame[columns[0].slot] = a[i];
+        frame[columns[1].slot] = b[i];
+        scalar[i] = evaluate(program, frame);
+    }
+    tree = (now() - start) / BENCH_ROWS;
+
+    start = now();
+    evaluate_batch(program, columns, 2, BENCH_ROWS, &batch, NULL);
+    block = (now() - start) / BENCH_ROWS;
+
+    start = now();
+    evaluate_batch(program, columns, 2, BENCH_ROWS, &pooled, pool);
+    parallel = (now() - start) / BENCH_ROWS;
+
+    /* It checks if the evaluators disagree on any row */
+    for (size_t i = 0; i < BENCH_ROWS; i++) {
+        if (fabs(scalar[i] - batch[i]) > BENCH_TOLERANCE * fabs(scalar[i])) {
+            printf("bench: The evaluators disagree on the value of the formula.\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    /* It checks if the output depends on the amount of threads */
+    if (memcmp(batch, pooled, sizeof(double) * BENCH_ROWS)) {
+        printf("bench: The pool disagrees with a single thread on the value of the formula.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    printf("batch: %d rows, %u nodes, %s kernels.\n", BENCH_ROWS, program->count, simd_name(simd_detect()));
+    printf("batch: tree  %6.2f ns/row.\n", tree * 1e9);
+    printf("batch: block %6.2f ns/row (%.1fx).\n", block * 1e9, tree / block);
+    printf("batch: pool  %6.2f ns/row (%.1fx) on %u threads.\n", parallel * 1e9, tree / parallel, pool->nworkers);
+
+    free(a);
+    free(b);
+    free(scalar);
+    free(batch);
+    free(pooled);
+    pool_free(pool);
+    free(frame);
+    program_free(parsed);
+    program_free(program);
+    parser_free(parser);
+
+    return 0;
+}
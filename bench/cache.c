@@ -0,0 +1,287 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Ricardo Fares
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../rdpc/rdpc.h"
+
+/**
+ * It is a benchmark of the cache of the embeddable library, replaying
+ * a stream of requests of which BENCH_REPEATS percent repeat one of the
+ * last BENCH_WINDOW requests, as the traffic of a server does, whereas
+ * the others evaluate one of BENCH_FORMULAS formulas for a new value of
+ * its variable. The formulas are written with and without blanks.
+ * <p>
+ * Before measuring, it checks that the cached results are the same as
+ * the ones of compiling and evaluating every request, also when the
+ * caches are too small to keep the stream, and that an expression
+ * defining a variable is evaluated anew every time.
+ */
+
+#define BENCH_REQUESTS (200000)
+#define BENCH_FORMULAS (2000)
+#define BENCH_WINDOW   (4096)
+#define BENCH_REPEATS  (60)
+
+/**
+ * A request of the stream.
+ */
+struct request {
+    unsigned formula; /* the formula evaluated */
+    unsigned spaced;  /* whether the formula is written with blanks */
+    double   x;       /* the value of its variable */
+};
+
+/**
+ * The formulas, written without and with blanks.
+ */
+static char *formulas[BENCH_FORMULAS][2];
+
+/**
+ * It returns the current time in seconds measured by a
+ * monotonic clock.
+ *
+ * @return the current time in seconds
+ */
+static double
+now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/**
+ * It writes a random formula of the specified depth over the variable
+ * `x` into the specified buffer.
+ *
+ * @param buf    the buffer
+ * @param depth  the depth left
+ * @param spaced whether the operators are surrounded by blanks
+ *
+ * @return the amount of characters written
+ */
+static int
+formula(char *buf, const int depth, const int spaced) {
+    static const char *const functions[] = { "sqrt", "log2", "sin", "floor" };
+    const char *const        blank       = spaced ? " " : "";
+    int                      n;
+
+    if (depth == 0)
+        return rand() % 3 ? sprintf(buf, "x") : sprintf(buf, "%d.25", rand() % 100);
+
+    if (rand() % 4 == 0) {
+        n = sprintf(buf, "%s(|", functions[rand() % 4]);
+        n += formula(buf + n, depth - 1, spaced);
+        return n + sprintf(buf + n, "| + 1)");
+    }
+
+    n = sprintf(buf, "(");
+    n += formula(buf + n, depth - 1, spaced);
+    n += sprintf(buf + n, "%s%c%s", blank, "+-*"[rand() % 3], blank);
+    n += formula(buf + n, depth - 1, spaced);
+    return n + sprintf(buf + n, ")");
+}
+
+/**
+ * It evaluates the specified request on the specified cache, or by
+ * compiling it on the specified context if the cache is NULL.
+ *
+ * @param ctx     the context
+ * @param cache   the cache, or NULL
+ * @param request the request
+ *
+ * @return its result
+ */
+static double
+evaluate(struct rdpc_ctx *ctx, struct rdpc_cache *cache, const struct request *request) {
+    const char       *source = formulas[request->formula][request->spaced];
+    const double     *results;
+    struct rdpc_expr *expr;
+    size_t            nresults;
+    double            value;
+
+    rdpc_set_var(ctx, "x", request->x);
+
+    if (cache) {
+        if (!(results = rdpc_cache_eval(cache, source, strlen(source), &nresults)) || nresults != 1) {
+            printf("bench: The formula %u could not be evaluated (%s).\n", request->formula, rdpc_error(ctx));
+            exit(EXIT_FAILURE);
+        }
+        return results[0];
+    }
+
+    if (!(expr = rdpc_compile(ctx, source, strlen(source)))) {
+        printf("bench: The formula %u could not be compiled (%s).\n", request->formula, rdpc_error(ctx));
+        exit(EXIT_FAILURE);
+    }
+    rdpc_eval(ctx, expr, &value);
+    rdpc_expr_free(expr);
+
+    return value;
+}
+
+/**
+ * It replays the specified stream on a cache bounded by the specified
+ * amounts of memory, checking its results against the expected ones.
+ *
+ * @param stream      the stream
+ * @param expected    the expected result of each request
+ * @param expressions the bytes of the cached expressions
+ * @param results     the bytes of the cached results
+ * @param stats       the placeholder for the counters of the cache
+ *
+ * @return the elapsed time in seconds
+ */
+static double
+replay(const struct request *stream, const double *expected, const size_t expressions, const size_t results,
+       struct rdpc_cache_stats *stats) {
+    struct rdpc_ctx   *ctx   = rdpc_ctx_new();
+    struct rdpc_cache *cache = rdpc_cache_new(ctx, expressions, results);
+    double             start = now(), elapsed;
+
+    for (size_t i = 0; i < BENCH_REQUESTS; i++) {
+        const double value = evaluate(ctx, cache, &stream[i]);
+
+        if (memcmp(&value, &expected[i], sizeof(double))) {
+            printf("bench: The request %zu differs from its compilation (%.17g, %.17g).\n", i, value, expected[i]);
+            exit(EXIT_FAILURE);
+        }
+    }
+    elapsed = now() - start;
+
+    rdpc_cache_stats(cache, stats);
+    rdpc_cache_free(cache);
+    rdpc_ctx_free(ctx);
+
+    return elapsed;
+}
+
+/**
+ * It checks that an expression defining a variable stores it on every
+ * evaluation, and that an error is reported through the cache.
+ */
+static void
+check_definitions() {
+    static const char        source[] = "$t = x * 2; t + 1";
+    struct rdpc_ctx         *ctx      = rdpc_ctx_new();
+    struct rdpc_cache       *cache    = rdpc_cache_new(ctx, 1 << 20, 1 << 20);
+    struct rdpc_cache_stats  stats;
+    const double            *results;
+    size_t                   nresults;
+    double                   t;
+
+    for (int i = 0; i < 4; i++) {
+        rdpc_set_var(ctx, "x", (double)(i % 2));
+        results = rdpc_cache_eval(cache, source, sizeof(source) - 1, &nresults);
+        if (!results || nresults != 1 || results[0] != (i % 2) * 2.0 + 1.0
+                || rdpc_get_var(ctx, "t", &t) || t != (i % 2) * 2.0) {
+            printf("bench: The definition has not been evaluated anew.\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    if (rdpc_cache_eval(cache, "1 + @", 5, &nresults) || rdpc_cache_eval(cache, "1 +", 3, &nresults)
+            || !*rdpc_error(ctx)) {
+        printf("bench: The error of a source has not been reported.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    rdpc_cache_stats(cache, &stats);
+    if (stats.hits != 3 || stats.result_hits + stats.result_misses != 0) {
+        printf("bench: The definition has been cached as a result.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    rdpc_cache_free(cache);
+    rdpc_ctx_free(ctx);
+}
+
+int main() {
+    struct request          *stream   = malloc(sizeof(struct request) * BENCH_REQUESTS);
+    double                  *expected = malloc(sizeof(double) * BENCH_REQUESTS);
+    struct rdpc_ctx         *ctx      = rdpc_ctx_new();
+    struct rdpc_cache_stats  stats;
+    char                     buf[4096];
+    double                   start, uncached, cached;
+
+    if (!stream || !expected) {
+        printf("bench: The stream could not be allocated.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    check_definitions();
+
+    /* Each formula is written twice from the same random choices */
+    for (unsigned f = 0; f < BENCH_FORMULAS; f++) {
+        for (int spaced = 0; spaced < 2; spaced++) {
+            srand(f + 1);
+            formula(buf, 6, spaced);
+            formulas[f][spaced] = strdup(buf);
+        }
+    }
+
+    srand(42);
+    for (size_t i = 0; i < BENCH_REQUESTS; i++) {
+        if (i > 0 && rand() % 100 < BENCH_REPEATS)
+            stream[i] = stream[i - 1 - (size_t)rand() % (i < BENCH_WINDOW ? i : BENCH_WINDOW)];
+        else {
+            stream[i].formula = (unsigned)rand() % BENCH_FORMULAS;
+            stream[i].x       = (double)(rand() % 100000) / 8.0;
+        }
+        stream[i].spaced = (unsigned)rand() % 2;
+    }
+
+    start = now();
+    for (size_t i = 0; i < BENCH_REQUESTS; i++)
+        expected[i] = evaluate(ctx, NULL, &stream[i]);
+    uncached = now() - start;
+
+    /* The small caches evict most of the stream */
+    replay(stream, expected, 64 * 1024, 16 * 1024, &stats);
+    if (!stats.evictions || !stats.result_evictions) {
+        printf("bench: The small caches have not evicted anything.\n");
+        exit(EXIT_FAILURE);
+    }
+    printf("cache: small  %6.1f%% expression hits, %6.1f%% result hits, %llu + %llu evictions.\n",
+           100.0 * stats.hits / BENCH_REQUESTS, 100.0 * stats.result_hits / BENCH_REQUESTS, stats.evictions,
+           stats.result_evictions);
+
+    cached = replay(stream, expected, 64 << 20, 16 << 20, &stats);
+    printf("cache: large  %6.1f%% expression hits, %6.1f%% result hits, %zu + %zu bytes.\n",
+           100.0 * stats.hits / BENCH_REQUESTS, 100.0 * stats.result_hits / BENCH_REQUESTS, stats.expression_bytes,
+           stats.result_bytes);
+    printf("cache: compiled every request %8.2f us/request.\n", uncached * 1e6 / BENCH_REQUESTS);
+    printf("cache: cached                 %8.2f us/request (%.1fx).\n", cached * 1e6 / BENCH_REQUESTS,
+           uncached / cached);
+
+    for (unsigned f = 0; f < BENCH_FORMULAS; f++)
+        free(formulas[f][0]), free(formulas[f][1]);
+    free(stream);
+    free(expected);
+    rdpc_ctx_free(ctx);
+
+    return 0;
+}
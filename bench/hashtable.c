@@ -0,0 +1,369 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Ricardo Fares
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <malloc.h>
+
+#include "../util/hashtable.h"
+
+/**
+ * It is a benchmark of the hash table, which inserts BENCH_DEFINITIONS
+ * definitions and then finds each of them, as well as as many missing
+ * keys, comparing it against the chained hash table it has replaced.
+ * <p>
+ * The keys are accessed both in the order of their names and in a
+ * random order, since the DJB2 hash code of the chained table maps
+ * consecutive names to consecutive buckets, which favours it when
+ * the keys are accessed in order.
+ * <p>
+ * The memory of each table is the growth of the heap while it is
+ * built, hence, it includes the overhead of each allocation.
+ */
+
+#define BENCH_DEFINITIONS (1000000)
+
+/**
+ * A singly-linked hash table node of the chained hash table.
+ */
+struct chained_node {
+    const char              *key;
+    struct var_descriptor_t  descriptor;
+    struct chained_node     *next;
+};
+
+/**
+ * The chained hash table, as it was before being replaced, except
+ * that its buckets are cleared when allocated.
+ */
+struct chained {
+    struct chained_node **table;
+    size_t                size;
+    size_t                capacity;
+    float                 lf;
+};
+
+/**
+ * The operations of a benchmarked hash table.
+ */
+struct table {
+    const char              *name;
+    void                    *(*new)(size_t initial_capacity);
+    void                     (*insert)(void *table, const char *key, struct var_descriptor_t *value);
+    struct var_descriptor_t *(*find)(void *table, const char *key);
+    void                     (*free)(void *table);
+};
+
+/**
+ * It returns the current time in seconds measured by a
+ * monotonic clock.
+ *
+ * @return the current time in seconds
+ */
+static double
+now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/**
+ * It returns the amount of bytes in use by the heap.
+ *
+ * @return the amount of bytes in use by the heap
+ */
+static size_t
+heap() {
+    const struct mallinfo2 info = mallinfo2();
+    return info.uordblks + info.hblkhd;
+}
+
+/**
+ * It calculates a hash code for the specified key, as the chained
+ * hash table did, i.e., with the DJB2 Hash Algorithm.
+ *
+ * @param ht_cap the hash table capacity
+ * @param key    the key to be hashed
+ *
+ * @return the key hash code
+ */
+static size_t
+chained_hash(const size_t ht_cap, const char *key) {
+    size_t hash = 5381;
+    char c;
+    while ((c = *key++))
+        hash = ((hash << 5) + hash) + c;
+    return hash % ht_cap;
+}
+
+static void *
+chained_new(size_t initial_capacity) {
+    struct chained *ht = malloc(sizeof(struct chained));
+    if (!ht || !(ht->table = calloc(initial_capacity, sizeof(struct chained_node *)))) {
+        printf("bench: The chained hash table could not be allocated.\n");
+        exit(EXIT_FAILURE);
+    }
+    ht->size     = 0;
+    ht->capacity = initial_capacity;
+    ht->lf       = 0.0f;
+    return ht;
+}
+
+static void
+chained_resize(struct chained *ht) {
+    size_t                new_cap   = ht->capacity << 1;
+    struct chained_node **new_table = calloc(new_cap, sizeof(struct chained_node *));
+    if (!new_table) {
+        printf("bench: The chained hash table could not be resized.\n");
+        exit(EXIT_FAILURE);
+    }
+    for (size_t i = 0; i < ht->capacity; i++) {
+        struct chained_node *curr = ht->table[i];
+        while (curr) {
+            ht->table[i] = curr->next;
+            size_t new_h = chained_hash(new_cap, curr->key);
+            curr->next = new_table[new_h];
+            new_table[new_h] = curr;
+            curr = ht->table[i];
+        }
+    }
+    free(ht->table);
+    ht->table    = new_table;
+    ht->capacity = new_cap;
+    ht->lf       = (float)ht->size / ht->capacity;
+}
+
+static void
+chained_insert(void *table, const char *key, struct var_descriptor_t *value) {
+    struct chained      *ht       = table;
+    struct chained_node *new_node = malloc(sizeof(struct chained_node));
+    if (!new_node) {
+        printf("bench: A chained hash table node could not be allocated.\n");
+        exit(EXIT_FAILURE);
+    }
+    if (ht->lf >= 0.75f)
+        chained_resize(ht);
+    size_t h = chained_hash(ht->capacity, key);
+    new_node->key        = key;
+    new_node->descriptor = *value;
+    new_node->next       = ht->table[h];
+    ht->table[h]         = new_node;
+    ht->size++;
+    ht->lf               = (float)ht->size / ht->capacity;
+}
+
+static struct var_descriptor_t *
+chained_find(void *table, const char *key) {
+    struct chained      *ht   = table;
+    struct chained_node *curr = ht->table[chained_hash(ht->capacity, key)];
+    while (curr) {
+        if (0 == strcmp(curr->key, key))
+            return &curr->descriptor;
+        curr = curr->next;
+    }
+    return NULL;
+}
+
+static void
+chained_free(void *table) {
+    struct chained *ht = table;
+    for (size_t i = 0; i < ht->capacity; i++) {
+        while (ht->table[i]) {
+            struct chained_node *next = ht->table[i]->next;
+            free(ht->table[i]);
+            ht->table[i] = next;
+        }
+    }
+    free(ht->table);
+    free(ht);
+}
+
+static void *
+open_new(size_t initial_capacity) {
+    return hashtable_new(initial_capacity);
+}
+
+static void
+open_insert(void *table, const char *key, struct var_descriptor_t *value) {
+    hashtable_insert(table, key, value);
+}
+
+static struct var_descriptor_t *
+open_find(void *table, const char *key) {
+    return hashtable_find(table, key);
+}
+
+static void
+open_free(void *table) {
+    hashtable_free(table);
+}
+
+/**
+ * It benchmarks the specified table, checking that it finds every
+ * definition with its value and none of the missing keys.
+ *
+ * @param table   the table
+ * @param keys    the keys of the definitions
+ * @param missing the missing keys
+ * @param order   the order in which the keys are accessed
+ * @param name    the name of the order
+ */
+static void
+run(const struct table *table, const char **keys, const char **missing, const unsigned *order, const char *name) {
+    const size_t before = heap();
+    void        *ht     = table->new(16);
+    size_t       memory;
+    double       start, insert, hit, miss;
+
+    start = now();
+    for (unsigned i = 0; i < BENCH_DEFINITIONS; i++) {
+        struct var_descriptor_t descriptor = { (double)order[i], IS_DEFINED };
+        table->insert(ht, keys[order[i]], &descriptor);
+    }
+    insert = now() - start;
+    memory = heap() - before;
+
+    start = now();
+    for (unsigned i = 0; i < BENCH_DEFINITIONS; i++) {
+        const struct var_descriptor_t *descriptor = table->find(ht, keys[order[i]]);
+
+        /* It checks if a definition is lost */
+        if (!descriptor || descriptor->value != (double)order[i]) {
+            printf("bench: The %s table has lost the definition of %s.\n", table->name, keys[order[i]]);
+            exit(EXIT_FAILURE);
+        }
+    }
+    hit = now() - start;
+
+    start = now();
+    for (unsigned i = 0; i < BENCH_DEFINITIONS; i++) {
+        /* It checks if a missing key is found */
+        if (table->find(ht, missing[order[i]])) {
+            printf("bench: The %s table has found the missing key %s.\n", table->name, missing[order[i]]);
+            exit(EXIT_FAILURE);
+        }
+    }
+    miss = now() - start;
+
+    table->free(ht);
+
+    printf("hashtable: %-7s %-8s insert %6.1f ns, find %6.1f ns, miss %6.1f ns, %6.1f MB.\n", table->name, name,
+           insert * 1e9 / BENCH_DEFINITIONS, hit * 1e9 / BENCH_DEFINITIONS, miss * 1e9 / BENCH_DEFINITIONS,
+           (double)memory / (1 << 20));
+}
+
+/**
+ * It checks that the removed keys are no longer found by the hash
+ * table while the others are, and that a removed key can be inserted
+ * again.
+ *
+ * @param keys the keys
+ */
+static void
+check_remove(const char **keys) {
+    struct hashtable        *ht = hashtable_new(0);
+    struct var_descriptor_t  placeholder;
+
+    for (unsigned i = 0; i < BENCH_DEFINITIONS; i++) {
+        struct var_descriptor_t descriptor = { (double)i, IS_DEFINED };
+        hashtable_insert(ht, keys[i], &descriptor);
+    }
+    for (unsigned i = 0; i < BENCH_DEFINITIONS; i += 2) {
+        hashtable_remove(ht, keys[i], &placeholder);
+        if (placeholder.value != (double)i) {
+            printf("bench: The hash table has removed a wrong value.\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    /* The deleted slots are reused or dropped while inserting again */
+    for (unsigned i = 0; i < BENCH_DEFINITIONS; i += 4) {
+        struct var_descriptor_t descriptor = { -(double)i, IS_CONSTANT };
+        hashtable_insert(ht, keys[i], &descriptor);
+    }
+    for (unsigned i = 0; i < BENCH_DEFINITIONS; i++) {
+        const struct var_descriptor_t *descriptor = hashtable_find(ht, keys[i]);
+        const int                      removed    = i % 2 == 0 && i % 4 != 0;
+
+        if (removed ? descriptor != NULL
+                    : !descriptor || descriptor->value != (i % 4 == 0 ? -(double)i : (double)i)) {
+            printf("bench: The hash table has not removed %s.\n", keys[i]);
+            exit(EXIT_FAILURE);
+        }
+    }
+    if (ht->size != BENCH_DEFINITIONS / 2 + BENCH_DEFINITIONS / 4) {
+        printf("bench: The hash table has a wrong size.\n");
+        exit(EXIT_FAILURE);
+    }
+    hashtable_free(ht);
+}
+
+int main() {
+    static const struct table tables[] = {
+        { "chained", chained_new, chained_insert, chained_find, chained_free },
+        { "open",    open_new,    open_insert,    open_find,    open_free    },
+    };
+    char        *chars   = malloc((size_t)BENCH_DEFINITIONS * 2 * 10);
+    const char **keys    = malloc(sizeof(char *) * BENCH_DEFINITIONS);
+    const char **missing = malloc(sizeof(char *) * BENCH_DEFINITIONS);
+    unsigned    *ordered = malloc(sizeof(unsigned) * BENCH_DEFINITIONS);
+    unsigned    *order   = malloc(sizeof(unsigned) * BENCH_DEFINITIONS);
+    unsigned     seed    = 12345;
+    size_t       len     = 0;
+
+    if (!chars || !keys || !missing || !ordered || !order) {
+        printf("bench: The keys could not be allocated.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    /* The keys are named as the variables of a large program */
+    for (unsigned i = 0; i < BENCH_DEFINITIONS; i++) {
+        keys[i]  = chars + len;
+        len     += (size_t)sprintf(chars + len, "var%u", i) + 1;
+        missing[i] = chars + len;
+        len       += (size_t)sprintf(chars + len, "tmp%u", i) + 1;
+        ordered[i] = order[i] = i;
+    }
+    /* The random order is a shuffle of the order of the names */
+    for (unsigned i = BENCH_DEFINITIONS - 1; i > 0; i--) {
+        const unsigned j = (seed = seed * 1103515245u + 12345u) % (i + 1);
+        const unsigned t = order[i];
+        order[i] = order[j];
+        order[j] = t;
+    }
+
+    check_remove(keys);
+    for (size_t i = 0; i < sizeof(tables) / sizeof(tables[0]); i++) {
+        run(&tables[i], keys, missing, ordered, "ordered");
+        run(&tables[i], keys, missing, order, "random");
+    }
+
+    free(chars);
+    free(keys);
+    free(missing);
+    free(ordered);
+    free(order);
+
+    return 0;
+}
@@ -0,0 +1,160 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Ricardo Fares
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../rdpc/rdpc.h"
+
+/**
+ * It is a benchmark of the incremental evaluation of the embeddable
+ * library, as a spreadsheet would use it, i.e., a long program of
+ * definitions of which one input changes at a time.
+ * <p>
+ * The program has BENCH_CHAINS independent chains of definitions, each
+ * one reading its own input, and every BENCH_STRIDE-th definition is a
+ * result as well. Before measuring, it checks that the updated results
+ * are the same as the ones of a full evaluation.
+ */
+
+#define BENCH_DEFINITIONS (100000)
+#define BENCH_CHAINS      (100)
+#define BENCH_STRIDE      (100)
+#define BENCH_CHANGES     (1000)
+
+/**
+ * It returns the current time in seconds measured by a
+ * monotonic clock.
+ *
+ * @return the current time in seconds
+ */
+static double
+now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/**
+ * It sets the specified input of the specified context.
+ *
+ * @param ctx   the context
+ * @param input the input
+ * @param value the value
+ */
+static void
+set_input(struct rdpc_ctx *ctx, const unsigned input, const double value) {
+    char name[32];
+
+    sprintf(name, "x%u", input);
+    rdpc_set_var(ctx, name, value);
+}
+
+int main() {
+    char             *source  = malloc((size_t)BENCH_DEFINITIONS * 64);
+    struct rdpc_ctx  *full    = rdpc_ctx_new();
+    struct rdpc_ctx  *ctx     = rdpc_ctx_new();
+    struct rdpc_expr *reference, *expr;
+    double           *expected, *results;
+    size_t           *changed;
+    size_t            len = 0, nresults, nchanged, total = 0;
+    double            start, eval, update;
+
+    if (!source) {
+        printf("bench: The source could not be allocated.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    for (unsigned c = 0; c < BENCH_CHAINS; c++) {
+        set_input(full, c, c + 1.0);
+        set_input(ctx, c, c + 1.0);
+    }
+    for (unsigned i = 0; i < BENCH_DEFINITIONS; i++) {
+        if (i < BENCH_CHAINS)
+            len += (size_t)sprintf(source + len, "$v%u = sqrt(x%u) + 1;\n", i, i);
+        else len += (size_t)sprintf(source + len, "$v%u = v%u * 0.5 + sqrt(x%u);\n", i, i - BENCH_CHAINS,
+                                    i % BENCH_CHAINS);
+        if (i % BENCH_STRIDE == BENCH_STRIDE - 1)
+            len += (size_t)sprintf(source + len, "v%u;\n", i);
+    }
+
+    if (!(reference = rdpc_compile(full, source, len)) || !(expr = rdpc_compile(ctx, source, len))) {
+        printf("bench: The program could not be compiled (%s).\n", rdpc_error(full));
+        exit(EXIT_FAILURE);
+    }
+
+    nresults = rdpc_results(expr);
+    expected = malloc(sizeof(double) * nresults);
+    results  = malloc(sizeof(double) * nresults);
+    changed  = malloc(sizeof(size_t) * nresults);
+    if (!expected || !results || !changed) {
+        printf("bench: The results could not be allocated.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    /* The first update evaluates the whole program */
+    rdpc_update(ctx, expr, results, changed, &nchanged);
+    if (nchanged != nresults) {
+        printf("bench: The first update has not evaluated every result.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    start = now();
+    for (unsigned i = 0; i < BENCH_CHANGES; i++) {
+        set_input(full, i % BENCH_CHAINS, i * 0.25);
+        rdpc_eval(full, reference, expected);
+    }
+    eval = (now() - start) / BENCH_CHANGES;
+
+    start = now();
+    for (unsigned i = 0; i < BENCH_CHANGES; i++) {
+        set_input(ctx, i % BENCH_CHAINS, i * 0.25);
+        rdpc_update(ctx, expr, results, changed, &nchanged);
+        total += nchanged;
+    }
+    update = (now() - start) / BENCH_CHANGES;
+
+    /* It checks if the updated results differ from the full evaluation */
+    if (memcmp(expected, results, sizeof(double) * nresults)) {
+        printf("bench: The updated results differ from the evaluated ones.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    printf("incremental: %u definitions, %zu results, %zu changed per update.\n", BENCH_DEFINITIONS, nresults,
+           total / BENCH_CHANGES);
+    printf("incremental: eval   %10.1f us/change.\n", eval * 1e6);
+    printf("incremental: update %10.1f us/change (%.1fx).\n", update * 1e6, eval / update);
+
+    free(expected);
+    free(results);
+    free(changed);
+    free(source);
+    rdpc_expr_free(reference);
+    rdpc_expr_free(expr);
+    rdpc_ctx_free(full);
+    rdpc_ctx_free(ctx);
+
+    return 0;
+}
@@ -0,0 +1,106 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Ricardo Fares
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../lexer/lexer.h"
+
+/**
+ * It is a microbenchmark for the recognition of identifiers by the lexer.
+ * <p>
+ * The input is identifier-heavy, mixing the keywords, the math constants
+ * and user identifiers that share a length and a first character with the
+ * keywords, which is the worst case for the keyword recognition.
+ */
+
+#define BENCH_TOKENS      (1000000)
+#define BENCH_REPETITIONS (10)
+
+/**
+ * The names the input is generated from.
+ */
+static const char *names[] = {
+    "sin", "cos", "tan", "csc", "sec", "cot", "floor", "ceil", "sqrt", "cbrt", "log10", "log2", "pi", "e",
+    "sig", "cop", "tax", "csv", "set", "cov", "flood", "cell", "sqr2", "cbr3", "log1x", "logx", "px", "x",
+    "rate", "price", "total", "discount", "alpha", "beta", "gamma", "delta",
+};
+
+/**
+ * It returns the current time in seconds measured by a
+ * monotonic clock.
+ *
+ * @return the current time in seconds
+ */
+static double
+now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+int main() {
+    const size_t nnames = sizeof(names) / sizeof(names[0]);
+    size_t       len    = 0;
+    char        *input  = malloc((size_t)BENCH_TOKENS * 9);
+    unsigned     seed   = 12345;
+    double       best   = 1e30;
+    unsigned     ids    = 0;
+    struct lexer lexer  = { 0 };
+
+    if (!input) {
+        printf("bench: The input could not be allocated.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    for (size_t i = 0; i < BENCH_TOKENS; i++) {
+        const char *name = names[(seed = seed * 1103515245u + 12345u) % nnames];
+        const size_t n   = strlen(name);
+
+        memcpy(input + len, name, n);
+        len += n;
+        input[len++] = ' ';
+    }
+
+    for (int r = 0; r < BENCH_REPETITIONS; r++) {
+        const double start = now();
+
+        ids = 0;
+        init_lexer_buffer(&lexer, input, len);
+        while (next_token(&lexer)->type != LEXER_TOKEN_EOF)
+            ids++;
+
+        const double elapsed = now() - start;
+        if (elapsed < best) best = elapsed;
+    }
+
+    printf("keywords: %u identifiers in %.6f s (%.2f Mtokens/s, %.2f ns/token).\n",
+           ids, best, ids / best / 1e6, best * 1e9 / ids);
+
+    free(input);
+    lexer_free(&lexer);
+
+    return 0;
+}
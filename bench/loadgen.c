@@ -0,0 +1,255 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Ricardo Fares
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+/**
+ * It is a load generator for the server of <em>rdp_calc --serve</em>,
+ * measuring the latency of each request as seen by its client.
+ * <p>
+ * Each connection sends a request, waits for its response and sends
+ * the next one, and every connection is multiplexed by an epoll event
+ * loop, such that the server sees as many concurrent clients as there
+ * are connections. It prints the percentiles of the latencies and the
+ * throughput, and fails if any response is an error.
+ * <p>
+ * Usage: bench_loadgen socket [connections [requests per connection]]
+ */
+
+#define BENCH_CONNECTIONS (64)
+#define BENCH_REQUESTS    (10000)
+#define BENCH_EVENTS      (256)
+#define BENCH_BUFLEN      (4096)
+
+/**
+ * The definitions sent once before the measured requests, which are
+ * kept by the server for every client.
+ */
+static const char definitions[] = "$base = 120.5; $qty = 17; $rate = 0.0825; $discount = 0.15\n";
+
+/**
+ * The requests sent by the clients in turn.
+ */
+static const char *const requests[] = {
+    "base * qty * (1 - discount) * (1 + rate)\n",
+    "(base * qty * (1 - discount) + sqrt(base) * log2(qty + 1)) * (1 + rate) - floor(base / 7)\n",
+    "sin(base) ** 2 + cos(base) ** 2; |rate - discount| * 100\n",
+    "base * base / (qty * rate); cbrt(base * qty); [5] / qty\n",
+};
+
+#define BENCH_NREQUESTS (sizeof(requests) / sizeof(requests[0]))
+
+/**
+ * A connection of the load generator.
+ */
+struct client {
+    int      fd;
+    unsigned sent;     /* the amount of requests sent */
+    uint64_t start;    /* the time the outstanding request was sent */
+    char     buf[BENCH_BUFLEN];
+    size_t   len;
+};
+
+/**
+ * It returns the current time in nanoseconds measured by a
+ * monotonic clock.
+ *
+ * @return the current time in nanoseconds
+ */
+static uint64_t
+now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * It compares the specified latencies.
+ *
+ * @param a the first latency
+ * @param b the second latency
+ *
+ * @return a negative value, zero or a positive value if the first
+ *         latency is less than, equal to or greater than the second
+ */
+static int
+compare(const void *a, const void *b) {
+    const uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * It connects to the socket at the specified path.
+ * <p>
+ * If the socket could not be connected, then the program is exited.
+ *
+ * @param path the path of the socket
+ *
+ * @return the connected socket
+ */
+static int
+connect_to(const char *path) {
+    struct sockaddr_un address = { .sun_family = AF_UNIX };
+    int                fd;
+
+    strncpy(address.sun_path, path, sizeof(address.sun_path) - 1);
+    if ((fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0)) < 0 ||
+        connect(fd, (struct sockaddr *)&address, sizeof(address)) < 0) {
+        printf("loadgen: The socket %s could not be connected (%s).\n", path, strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+    return fd;
+}
+
+/**
+ * It sends the specified request through the specified client.
+ * <p>
+ * The requests are short, hence, they fit in the socket buffer of a
+ * client waiting for its previous response.
+ *
+ * @param c       the client
+ * @param request the request
+ */
+static void
+send_request(struct client *c, const char *request) {
+    const size_t len = strlen(request);
+
+    c->start = now();
+    if (send(c->fd, request, len, MSG_NOSIGNAL) != (ssize_t)len) {
+        printf("loadgen: A request could not be sent (%s).\n", strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+    c->sent++;
+}
+
+int main(int argc, char **argv) {
+    const unsigned     nclients  = argc > 2 ? (unsigned)strtoul(argv[2], NULL, 10) : BENCH_CONNECTIONS;
+    const unsigned     nrequests = argc > 3 ? (unsigned)strtoul(argv[3], NULL, 10) : BENCH_REQUESTS;
+    struct client     *clients;
+    uint64_t          *latencies;
+    size_t             nlatencies = 0, total;
+    struct epoll_event events[BENCH_EVENTS];
+    unsigned long      errors     = 0;
+    unsigned           active;
+    uint64_t           start, elapsed;
+    char               reply[BENCH_BUFLEN];
+    int                epoll, fd;
+    ssize_t            n;
+
+    if (argc < 2 || nclients == 0 || nrequests == 0) {
+        printf("Usage: bench_loadgen socket [connections [requests per connection]]\n");
+        exit(EXIT_FAILURE);
+    }
+
+    total     = (size_t)nclients * nrequests;
+    clients   = calloc(nclients, sizeof(struct client));
+    latencies = malloc(sizeof(uint64_t) * total);
+    if (!clients || !latencies || (epoll = epoll_create1(EPOLL_CLOEXEC)) < 0) {
+        printf("loadgen: The state of %u connections could not be allocated.\n", nclients);
+        exit(EXIT_FAILURE);
+    }
+
+    /* It defines the variables the requests use, once for every client */
+    fd = connect_to(argv[1]);
+    if (send(fd, definitions, sizeof(definitions) - 1, MSG_NOSIGNAL) < 0 ||
+        (n = recv(fd, reply, sizeof(reply) - 1, 0)) <= 0 || strncmp(reply, "ok", 2) != 0) {
+        printf("loadgen: The definitions have been refused by the server.\n");
+        exit(EXIT_FAILURE);
+    }
+    close(fd);
+
+    for (unsigned i = 0; i < nclients; i++) {
+        struct epoll_event event = { .events = EPOLLIN, .data.ptr = &clients[i] };
+
+        clients[i].fd = connect_to(argv[1]);
+        if (epoll_ctl(epoll, EPOLL_CTL_ADD, clients[i].fd, &event) < 0) {
+            printf("loadgen: The connection %u could not be watched (%s).\n", i, strerror(errno));
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    start = now();
+    for (unsigned i = 0; i < nclients; i++)
+        send_request(&clients[i], requests[i % BENCH_NREQUESTS]);
+    active = nclients;
+
+    while (active > 0) {
+        const int ready = epoll_wait(epoll, events, BENCH_EVENTS, -1);
+
+        for (int e = 0; e < ready; e++) {
+            struct client *c = events[e].data.ptr;
+            char          *end;
+
+            if ((n = recv(c->fd, c->buf + c->len, sizeof(c->buf) - c->len, 0)) <= 0) {
+                printf("loadgen: The server has closed a connection.\n");
+                exit(EXIT_FAILURE);
+            }
+            c->len += (size_t)n;
+
+            /* A client has a single request outstanding, */
+            /* hence, a whole line is its response */
+            if (!(end = memchr(c->buf, '\n', c->len)))
+                continue;
+
+            latencies[nlatencies++] = now() - c->start;
+            if (strncmp(c->buf, "ok", 2) != 0 && errors++ == 0)
+                printf("loadgen: %.*s\n", (int)(end - c->buf), c->buf);
+            c->len = 0;
+
+            if (c->sent < nrequests)
+                send_request(c, requests[(c - clients + c->sent) % BENCH_NREQUESTS]);
+            else active--;
+        }
+    }
+    elapsed = now() - start;
+
+    qsort(latencies, nlatencies, sizeof(uint64_t), compare);
+    printf("loadgen: %zu requests on %u connections in %.3f s (%.0f requests/s).\n", nlatencies, nclients,
+           elapsed * 1e-9, nlatencies / (elapsed * 1e-9));
+    printf("loadgen: p50 %8.1f us, p99 %8.1f us, p999 %8.1f us, max %8.1f us.\n",
+           latencies[nlatencies / 2] * 1e-3, latencies[nlatencies * 99 / 100] * 1e-3,
+           latencies[nlatencies * 999 / 1000] * 1e-3, latencies[nlatencies - 1] * 1e-3);
+
+    for (unsigned i = 0; i < nclients; i++)
+        close(clients[i].fd);
+    close(epoll);
+    free(clients);
+    free(latencies);
+
+    if (errors) {
+        printf("loadgen: %lu responses are errors.\n", errors);
+        exit(EXIT_FAILURE);
+    }
+
+    return 0;
+}
@@ -0,0 +1,153 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Ricardo Fares
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../lexer/lexer.h"
+
+/**
+ * It is a microbenchmark for the recognition of numbers by the lexer.
+ * <p>
+ * The input is number-dense, as a data file is: integers, decimals with
+ * up to 17 significant digits and numbers in scientific notation, each
+ * one followed by an operator. Before measuring, it checks that every
+ * number is the double <em>strtod</em> rounds it to, and it compares the
+ * lexer with copying each number out and converting it by <em>atof</em>,
+ * as the lexer used to.
+ */
+
+#define BENCH_NUMBERS     (1000000)
+#define BENCH_REPETITIONS (10)
+
+/**
+ * It returns the current time in seconds measured by a
+ * monotonic clock.
+ *
+ * @return the current time in seconds
+ */
+static double
+now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/**
+ * It converts every number of the specified input by copying it out
+ * and calling <em>atof</em>, returning their sum.
+ *
+ * @param input the input
+ * @param len   the input length
+ *
+ * @return the sum of the numbers
+ */
+static double
+convert_by_atof(const char *input, const size_t len) {
+    char   number[64];
+    double sum = 0.0;
+
+    for (size_t i = 0; i < len;) {
+        size_t n = strspn(input + i, "0123456789.eE-");
+
+        memcpy(number, input + i, n);
+        number[n] = '\0';
+        sum += atof(number); // NOLINT(cert-err34-c)
+        i += n + 3;
+    }
+
+    return sum;
+}
+
+int main() {
+    char        *input  = malloc((size_t)BENCH_NUMBERS * 32);
+    double      *values = malloc(sizeof(double) * BENCH_NUMBERS);
+    size_t       len    = 0;
+    unsigned     seed   = 12345;
+    double       best   = 1e30, baseline = 1e30, sum = 0.0;
+    struct lexer lexer  = { 0 };
+    size_t       n;
+
+    if (!input || !values) {
+        printf("bench: The input could not be allocated.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    for (size_t i = 0; i < BENCH_NUMBERS; i++) {
+        const unsigned kind   = (seed = seed * 1103515245u + 12345u) >> 16 & 3;
+        const unsigned digits = 1 + ((seed = seed * 1103515245u + 12345u) >> 16) % 17;
+        const char    *start  = input + len;
+
+        for (unsigned d = 0; d < digits; d++) {
+            input[len++] = (char)('0' + ((seed = seed * 1103515245u + 12345u) >> 16) % 10);
+            if (d == 0 && kind != 0 && digits > 1)
+                input[len++] = '.';
+        }
+        if (kind == 3)
+            len += (size_t)sprintf(input + len, "e-%u", ((seed = seed * 1103515245u + 12345u) >> 16) % 300);
+        values[i] = strtod(start, NULL);
+        len += (size_t)sprintf(input + len, " + ");
+    }
+
+    /* It checks that every number is rounded as strtod rounds it */
+    init_lexer_buffer(&lexer, input, len);
+    for (n = 0; n < BENCH_NUMBERS; n++) {
+        const struct token *token = next_token(&lexer);
+
+        if (token->type != LEXER_TOKEN_NUMBER || memcmp(&token->metadata.value, &values[n], sizeof(double))) {
+            printf("bench: The number %zu has not been rounded correctly.\n", n);
+            exit(EXIT_FAILURE);
+        }
+        next_token(&lexer);
+    }
+
+    for (int r = 0; r < BENCH_REPETITIONS; r++) {
+        double start = now(), elapsed;
+
+        init_lexer_buffer(&lexer, input, len);
+        for (const struct token *token; (token = next_token(&lexer))->type != LEXER_TOKEN_EOF;)
+            sum += token->metadata.value;
+        if ((elapsed = now() - start) < best) best = elapsed;
+
+        start = now();
+        sum  += convert_by_atof(input, len);
+        if ((elapsed = now() - start) < baseline) baseline = elapsed;
+    }
+
+    printf("numbers: %d numbers in %.6f s (%.2f MB/s, %.2f ns/number).\n", BENCH_NUMBERS, best,
+           len / best / 1e6, best * 1e9 / BENCH_NUMBERS);
+    printf("numbers: copied out and converted by atof in %.6f s (%.2f ns/number, %.1fx).\n", baseline,
+           baseline * 1e9 / BENCH_NUMBERS, baseline / best);
+
+    /* The sum keeps the conversions from being optimized away */
+    if (sum != sum)
+        printf("numbers: the sum is not a number.\n");
+
+    free(input);
+    free(values);
+    lexer_free(&lexer);
+
+    return 0;
+}
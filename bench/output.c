@@ -0,0 +1,161 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Ricardo Fares
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "../output/output.h"
+
+/**
+ * It is a microbenchmark for the formatting of the results.
+ * <p>
+ * The values are random doubles of every magnitude. Before measuring,
+ * it checks that every value is read back by <em>strtod</em> as the
+ * same double, and that no shorter representation is, by comparing it
+ * with the shortest precision of the <em>%g</em> conversion that
+ * round-trips. It then compares the formatter with <em>%.17g</em>, and
+ * the buffered output with <em>printf</em>, both written to /dev/null.
+ */
+
+#define BENCH_VALUES      (1000000)
+#define BENCH_CHECKED     (100000)
+#define BENCH_REPETITIONS (5)
+
+/**
+ * It returns the current time in seconds measured by a
+ * monotonic clock.
+ *
+ * @return the current time in seconds
+ */
+static double
+now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/**
+ * It returns the length of the shortest representation of the
+ * specified double by the <em>%g</em> conversion which is read back
+ * as the same double.
+ *
+ * @param value the double
+ *
+ * @return the length of the shortest representation
+ */
+static size_t
+shortest_printf(const double value) {
+    char buf[OUTPUT_DOUBLE_MAX];
+
+    for (int precision = 1;; precision++) {
+        const int len = snprintf(buf, sizeof(buf), "%.*g", precision, value);
+
+        if (strtod(buf, NULL) == value || precision == 17)
+            return (size_t)len;
+    }
+}
+
+int main() {
+    double       *values = malloc(sizeof(double) * BENCH_VALUES);
+    const int     fd     = open("/dev/null", O_WRONLY);
+    FILE         *null   = fdopen(dup(fd), "w");
+    uint64_t      seed   = 12345;
+    double        best   = 1e30, baseline = 1e30, buffered = 1e30, stdio = 1e30;
+    size_t        sum    = 0;
+    struct output output;
+    char          buf[OUTPUT_DOUBLE_MAX + 1];
+
+    if (!values || fd < 0 || !null) {
+        printf("bench: The values could not be allocated.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    for (size_t i = 0; i < BENCH_VALUES; i++) {
+        uint64_t bits;
+
+        /* The exponents of infinities and NaNs are skipped */
+        do {
+            seed = seed * 6364136223846793005u + 1442695040888963407u;
+            bits = seed ^ seed >> 29;
+        } while ((bits >> 52 & 0x7ff) == 0x7ff);
+        memcpy(&values[i], &bits, sizeof(double));
+    }
+
+    /* It checks that every value round-trips at the shortest length */
+    for (size_t i = 0; i < BENCH_CHECKED; i++) {
+        const size_t len = format_double(values[i], buf);
+
+        buf[len] = '\0';
+        if (strtod(buf, NULL) != values[i] || len > shortest_printf(values[i])) {
+            printf("bench: The value %.17g has been formatted as %s.\n", values[i], buf);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    for (int r = 0; r < BENCH_REPETITIONS; r++) {
+        double start = now(), elapsed;
+
+        for (size_t i = 0; i < BENCH_VALUES; i++)
+            sum += format_double(values[i], buf);
+        if ((elapsed = now() - start) < best) best = elapsed;
+
+        start = now();
+        for (size_t i = 0; i < BENCH_VALUES; i++)
+            sum += (size_t)snprintf(buf, sizeof(buf), "%.17g", values[i]);
+        if ((elapsed = now() - start) < baseline) baseline = elapsed;
+
+        start = now();
+        init_output(&output, fd, OUTPUT_PLAIN);
+        output_row(&output, values, BENCH_VALUES);
+        output_free(&output);
+        if ((elapsed = now() - start) < buffered) buffered = elapsed;
+
+        start = now();
+        for (size_t i = 0; i < BENCH_VALUES; i++)
+            fprintf(null, "Value: %lf.\n", values[i]);
+        fflush(null);
+        if ((elapsed = now() - start) < stdio) stdio = elapsed;
+    }
+
+    printf("output: %d values formatted in %.6f s (%.2f ns/value).\n", BENCH_VALUES, best,
+           best * 1e9 / BENCH_VALUES);
+    printf("output: formatted by %%.17g in %.6f s (%.2f ns/value, %.1fx).\n", baseline,
+           baseline * 1e9 / BENCH_VALUES, baseline / best);
+    printf("output: %d values written in %.6f s, by printf in %.6f s (%.1fx).\n", BENCH_VALUES, buffered, stdio,
+           stdio / buffered);
+
+    /* The sum keeps the formatting from being optimized away */
+    if (!sum)
+        printf("output: nothing has been formatted.\n");
+
+    fclose(null);
+    close(fd);
+    free(values);
+
+    return 0;
+}
@@ -0,0 +1,168 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Ricardo Fares
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <math.h>
+#include <float.h>
+
+#include "../lexer/lexer.h"
+#include "../parser/parser.h"
+#include "../eval/eval.h"
+#include "../opt/opt.h"
+#include "../util/intern.h"
+
+/**
+ * It is a microbenchmark of the powers whose exponent is a small integer
+ * and of the factorial.
+ * <p>
+ * Before measuring, it checks that the powers lowered into
+ * multiplications are within a few ULPs of <em>pow</em>, and that the
+ * factorials of the table are the products of the integers up to them.
+ * It then compares the formula before and after its powers are lowered,
+ * and the factorial with the product computed at each call, as it used
+ * to be.
+ */
+
+#define BENCH_EVALUATIONS (1000000)
+#define BENCH_FACTORIALS  (1000000)
+
+/**
+ * The formula being evaluated, whose variable `x` is declared by the
+ * benchmark and set before each evaluation.
+ */
+static const char formula[] = "x ** 2 + 3 * x ** 3 - x ** 4 / 7 + x ** -1 + [|x| * 50]";
+
+/**
+ * It returns the current time in seconds measured by a
+ * monotonic clock.
+ *
+ * @return the current time in seconds
+ */
+static double
+now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/**
+ * It calculates the factorial of the specified number by multiplying
+ * the integers up to it.
+ *
+ * @param x the number to calculate its factorial
+ *
+ * @return the factorial of x
+ */
+static double
+product(const double x) {
+    double i = 0.0;
+    double f = 1.0;
+    while ((++i) <= x) f *= i;
+    return f;
+}
+
+int main() {
+    struct parser  *parser  = parser_new();
+    struct program *program;
+    struct program *lowered;
+    double         *frame;
+    volatile double sink    = 0.0;
+    double          start, tree, folded, table, loop;
+    unsigned        x; /* the slot of x */
+
+    init_lexer_buffer(&parser->lexer, formula, sizeof(formula) - 1);
+    x = intern(parser->lexer.symbols, "x", 1);
+    declare(parser, x);
+    program = compile_resident(parser);
+    lowered = optimize(program);
+
+    if (!(frame = calloc(program_frame_size(program) + program_frame_size(lowered), sizeof(double)))) {
+        printf("bench: The evaluation frame could not be allocated.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    /* It checks that the lowered powers are within a few ULPs of pow */
+    for (int i = 1; i <= 1000; i++) {
+        double expected, value;
+
+        frame[x] = (double)(i - 500) / 97.0;
+        expected = evaluate(program, frame);
+        value    = evaluate(lowered, frame);
+        if (fabs(value - expected) > 8 * DBL_EPSILON * fabs(expected)) {
+            printf("bench: The powers of %.17g have been lowered into %.17g, not %.17g.\n", frame[x], value,
+                   expected);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    /* It checks the factorials of the table, which are rounded once */
+    for (int n = -2; n <= FACTORIAL_MAX + 2; n++) {
+        const double expected = product(n), value = factorial(n + 0.5);
+
+        if (value != factorial(n) || (isinf(expected) ? !isinf(value)
+                                                      : fabs(value - expected) > 1e-13 * expected)) {
+            printf("bench: The factorial of %d is %.17g, not %.17g.\n", n, value, expected);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    start = now();
+    for (int i = 0; i < BENCH_EVALUATIONS; i++) {
+        frame[x] = (double)(i & 1023) / 256.0 + 0.5;
+        sink    += evaluate(program, frame);
+    }
+    tree = now() - start;
+
+    start = now();
+    for (int i = 0; i < BENCH_EVALUATIONS; i++) {
+        frame[x] = (double)(i & 1023) / 256.0 + 0.5;
+        sink    += evaluate(lowered, frame);
+    }
+    folded = now() - start;
+
+    start = now();
+    for (int i = 0; i < BENCH_FACTORIALS; i++)
+        sink += factorial((double)(i % (FACTORIAL_MAX + 1)));
+    table = now() - start;
+
+    start = now();
+    for (int i = 0; i < BENCH_FACTORIALS; i++)
+        sink += product((double)(i % (FACTORIAL_MAX + 1)));
+    loop = now() - start;
+
+    printf("power: %u nodes, %u lowered.\n", program->count, lowered->count);
+    printf("power: pow     %8.1f ns/evaluation.\n", tree * 1e9 / BENCH_EVALUATIONS);
+    printf("power: lowered %8.1f ns/evaluation (%.1fx).\n", folded * 1e9 / BENCH_EVALUATIONS, tree / folded);
+    printf("power: factorial by product %6.1f ns, by table %6.1f ns (%.1fx).\n", loop * 1e9 / BENCH_FACTORIALS,
+           table * 1e9 / BENCH_FACTORIALS, loop / table);
+
+    free(frame);
+    program_free(lowered);
+    program_free(program);
+    parser_free(parser);
+
+    return 0;
+}
@@ -0,0 +1,194 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Ricardo Fares
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <math.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "../rdpc/rdpc.h"
+
+/**
+ * It is a benchmark of the embeddable library, in which each thread
+ * compiles a formula on its own context and evaluates it over its own
+ * variables, as an application embedding the calculator would.
+ * <p>
+ * Before measuring, it checks that the errors of a context are reported
+ * rather than exiting, and that every thread computes the same values as
+ * a single thread does.
+ */
+
+#define BENCH_EVALUATIONS (1000000)
+#define BENCH_THREADS     (64)
+
+/**
+ * The formula being evaluated, whose variable `x` is set before each
+ * evaluation.
+ */
+static const char formula[] =
+    "$rate := 0.0825; $total = x * (1 + rate); sqrt(total * total + 1) - floor(total / 7); log2(|x| + 1)";
+
+/**
+ * The work of a thread.
+ */
+struct work {
+    pthread_t thread;
+    double    sum; /* the sum of the results of every evaluation */
+};
+
+/**
+ * It returns the current time in seconds measured by a
+ * monotonic clock.
+ *
+ * @return the current time in seconds
+ */
+static double
+now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/**
+ * It compiles the formula on a context of its own and evaluates it
+ * BENCH_EVALUATIONS times, summing up its results.
+ *
+ * @param arg the work of the thread
+ *
+ * @return NULL
+ */
+static void *
+work(void *arg) {
+    struct work      *w   = arg;
+    struct rdpc_ctx  *ctx = rdpc_ctx_new();
+    struct rdpc_expr *expr;
+    double            results[2];
+
+    rdpc_set_var(ctx, "x", 0.0);
+    if (!(expr = rdpc_compile(ctx, formula, sizeof(formula) - 1))) {
+        printf("bench: The formula could not be compiled (%s).\n", rdpc_error(ctx));
+        exit(EXIT_FAILURE);
+    }
+
+    w->sum = 0.0;
+    for (int i = 0; i < BENCH_EVALUATIONS; i++) {
+        rdpc_set_var(ctx, "x", (double)(i % 1000) - 500.0);
+        rdpc_eval(ctx, expr, results);
+        w->sum += results[0] + results[1];
+    }
+
+    rdpc_expr_free(expr);
+    rdpc_ctx_free(ctx);
+
+    return NULL;
+}
+
+/**
+ * It checks that the errors of a context are reported to the caller,
+ * and that the context is still usable afterwards.
+ */
+static void
+check_errors() {
+    struct rdpc_ctx   *ctx = rdpc_ctx_new();
+    struct rdpc_expr  *expr;
+    struct rdpc_status errors[4];
+    double             value;
+
+    if (rdpc_compile(ctx, "1 +", 3) || !*rdpc_error(ctx) || rdpc_compile(ctx, "y", 1)
+            || rdpc_set_var(ctx, "sin", 1.0) == 0 || rdpc_set_var(ctx, "2", 1.0) == 0
+            || rdpc_set_var(ctx, "#", 1.0) == 0 || rdpc_get_var(ctx, "y", &value) == 0) {
+        printf("bench: An error of the context has not been reported.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    /* The definitions of a source with an error are forgotten */
+    if (rdpc_compile(ctx, "$k := 2; k +", 12) || rdpc_get_var(ctx, "k", &value) == 0) {
+        printf("bench: The definitions of a failed compilation have been kept.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    /* Every statement with an error is reported at its position */
+    if (rdpc_compile(ctx, "1 +;\n2 @ 2;\nz", 13) || rdpc_errors(ctx, errors, 4) != 3
+            || errors[0].code != RDPC_ERROR_SYNTAX || errors[0].line != 1 || errors[0].column != 4
+            || errors[1].code != RDPC_ERROR_LEXICAL || errors[1].line != 2 || errors[1].column != 3
+            || errors[2].code != RDPC_ERROR_SEMANTIC || errors[2].line != 3 || errors[2].statement != 2) {
+        printf("bench: The errors of the statements have not been reported.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    expr = rdpc_compile(ctx, "$k := 2; $y = 3; k * y", 22);
+    if (!expr || rdpc_eval(ctx, expr, &value) || value != 6.0 || rdpc_set_var(ctx, "k", 1.0) == 0
+            || rdpc_set_var(ctx, "y", 4.0) || rdpc_get_var(ctx, "y", &value) || value != 4.0) {
+        printf("bench: The context has not evaluated the expression.\n");
+        exit(EXIT_FAILURE);
+    }
+    rdpc_expr_free(expr);
+    rdpc_ctx_free(ctx);
+}
+
+int main() {
+    struct work *works   = calloc(BENCH_THREADS, sizeof(struct work));
+    const long   cores   = sysconf(_SC_NPROCESSORS_ONLN);
+    const int    maximum = cores > BENCH_THREADS ? BENCH_THREADS : (cores < 1 ? 1 : (int)cores);
+    double       start, single = 0.0, elapsed;
+
+    if (!works) {
+        printf("bench: The threads could not be allocated.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    check_errors();
+
+    /* The threads are doubled up to one per core */
+    for (int threads = 1;; threads = threads << 1 > maximum ? maximum : threads << 1) {
+        start = now();
+        for (int t = 0; t < threads; t++)
+            pthread_create(&works[t].thread, NULL, work, &works[t]);
+        for (int t = 0; t < threads; t++)
+            pthread_join(works[t].thread, NULL);
+        elapsed = now() - start;
+
+        /* It checks if a thread disagrees with the single thread */
+        if (threads == 1) single = elapsed;
+        for (int t = 0; t < threads; t++) {
+            if (works[t].sum != works[0].sum || !isfinite(works[t].sum)) {
+                printf("bench: The thread %d disagrees on the value of the formula.\n", t);
+                exit(EXIT_FAILURE);
+            }
+        }
+
+        printf("rdpc: %2d threads %8.1f ns/evaluation, %7.2f Mevaluations/s (%.1fx).\n", threads,
+               elapsed * 1e9 / BENCH_EVALUATIONS, threads * BENCH_EVALUATIONS / elapsed / 1e6,
+               threads * single / elapsed);
+
+        if (threads == maximum)
+            break;
+    }
+
+    free(works);
+
+    return 0;
+}
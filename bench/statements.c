@@ -0,0 +1,190 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Ricardo Fares
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../lexer/lexer.h"
+#include "../parser/parser.h"
+#include "../eval/eval.h"
+#include "../eval/parallel.h"
+#include "../opt/opt.h"
+#include "../vm/vm.h"
+#include "../jit/jit.h"
+
+/**
+ * It is a benchmark of the latency of a program of thousands of
+ * independent formulas, evaluated one statement after another by the
+ * expression tree evaluator, the virtual machine and the JIT, and level
+ * by level on a pool of one thread per core.
+ * <p>
+ * The formulas read a variable which is redefined every so often, such
+ * that the statements form a few levels. Before measuring, it checks
+ * that every engine computes the same value of every result.
+ */
+
+#define BENCH_FORMULAS    (4096)
+#define BENCH_REDEFINE    (1024)
+#define BENCH_EVALUATIONS (200)
+
+/**
+ * It returns the current time in seconds measured by a
+ * monotonic clock.
+ *
+ * @return the current time in seconds
+ */
+static double
+now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/**
+ * It generates the text of the program, a formula per line interleaved
+ * with the redefinitions of the variable they read.
+ *
+ * @param len the length of the text, which is set
+ *
+ * @return the text, which must be freed by the caller
+ */
+static char *
+generate(size_t *len) {
+    const size_t capacity = (size_t)BENCH_FORMULAS * 160 + 64;
+    char        *text     = malloc(capacity);
+
+    if (!text) {
+        printf("bench: The program text could not be allocated.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    *len = (size_t)snprintf(text, capacity, "$x := 0.5;\n$y = 1.25;\n");
+    for (int i = 0; i < BENCH_FORMULAS; i++) {
+        if (i > 0 && i % BENCH_REDEFINE == 0)
+            *len += (size_t)snprintf(text + *len, capacity - *len, "$y = y * 1.5 + x;\n");
+        *len += (size_t)snprintf(text + *len, capacity - *len,
+                                 "sin(y * %d.5) * cos(y + %d) + sqrt(y * y + %d) / cbrt(y + %d) - |y - %d| * x"
+                                 " + log2(y + %d) ** 2;\n", i, i, i, i, i, i);
+    }
+
+    return text;
+}
+
+int main() {
+    size_t           len;
+    char            *text     = generate(&len);
+    struct parser   *parser   = parser_new();
+    struct program  *program;
+    struct bytecode *bytecode;
+    struct jit      *jit;
+    struct pool     *pool     = pool_new(0);
+    double          *expected;
+    double          *frame;
+    size_t           size;
+    volatile double  sink     = 0.0;
+    double           start, tree, parallel, vm, native = 0.0;
+
+    init_lexer_buffer(&parser->lexer, text, len);
+    program  = compile(parser);
+    bytecode = vm_compile(program);
+    jit      = jit_compile(bytecode);
+    size     = program_frame_size(program);
+    expected = calloc(size, sizeof(double));
+    frame    = calloc(size, sizeof(double));
+
+    if (!expected || !frame) {
+        printf("bench: The evaluation frame could not be allocated.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    /* It checks if the engines disagree on the value of any result, */
+    /* the results following the variables in the frame */
+    size = program->nslots + program->nresults;
+    evaluate(program, expected);
+    evaluate_parallel(program, frame, pool);
+    if (memcmp(frame, expected, sizeof(double) * size)) {
+        printf("bench: The parallel evaluation disagrees with the sequential one.\n");
+        exit(EXIT_FAILURE);
+    }
+    memset(frame, 0, sizeof(double) * size);
+    vm_run(bytecode, frame);
+    if (memcmp(frame + program->nslots, expected + program->nslots, sizeof(double) * program->nresults)) {
+        printf("bench: The virtual machine disagrees with the tree evaluator.\n");
+        exit(EXIT_FAILURE);
+    }
+    if (jit) {
+        memset(frame, 0, sizeof(double) * size);
+        jit->fn(frame);
+        if (memcmp(frame + program->nslots, expected + program->nslots, sizeof(double) * program->nresults)) {
+            printf("bench: The JIT disagrees with the tree evaluator.\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    start = now();
+    for (int i = 0; i < BENCH_EVALUATIONS; i++)
+        sink += evaluate(program, frame);
+    tree = (now() - start) / BENCH_EVALUATIONS;
+
+    start = now();
+    for (int i = 0; i < BENCH_EVALUATIONS; i++)
+        sink += evaluate_parallel(program, frame, pool);
+    parallel = (now() - start) / BENCH_EVALUATIONS;
+
+    start = now();
+    for (int i = 0; i < BENCH_EVALUATIONS; i++)
+        sink += vm_run(bytecode, frame);
+    vm = (now() - start) / BENCH_EVALUATIONS;
+
+    if (jit) {
+        start = now();
+        for (int i = 0; i < BENCH_EVALUATIONS; i++)
+            sink += jit->fn(frame);
+        native = (now() - start) / BENCH_EVALUATIONS;
+    }
+
+    printf("statements: %u statements, %u results, %u nodes.\n", program->nstatements, program->nresults,
+           program->count);
+    printf("statements: tree     %10.1f us/evaluation.\n", tree * 1e6);
+    printf("statements: parallel %10.1f us/evaluation (%.1fx) on %u threads.\n", parallel * 1e6, tree / parallel,
+           pool->nworkers);
+    printf("statements: vm       %10.1f us/evaluation (%.1fx).\n", vm * 1e6, tree / vm);
+    if (jit)
+        printf("statements: jit      %10.1f us/evaluation (%.1fx).\n", native * 1e6, tree / native);
+    else
+        printf("statements: jit      unsupported on this host.\n");
+
+    free(expected);
+    free(frame);
+    if (jit)
+        jit_free(jit);
+    bytecode_free(bytecode);
+    program_free(program);
+    pool_free(pool);
+    free(text);
+    parser_free(parser);
+
+    return 0;
+}
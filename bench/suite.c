@@ -0,0 +1,404 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Ricardo Fares
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+#include "../lexer/lexer.h"
+#include "../parser/parser.h"
+#include "../eval/eval.h"
+#include "../opt/opt.h"
+
+/**
+ * It is the benchmark suite of the calculator, run by the <em>bench</em>
+ * target, whose results are printed as JSON to be compared between
+ * releases.
+ * <p>
+ * Each workload is a large synthetic input: deeply nested parentheses,
+ * long sums, chains of definitions of long-named variables, nested calls
+ * of the math functions, and number-dense arithmetic. For each one, it
+ * measures the tokens recognized per second by the lexer, the nodes
+ * compiled per second by the parser, the evaluations per second of the
+ * optimized program and the peak resident set size, running the
+ * workload in a process of its own such that their peaks are apart.
+ * <p>
+ * Usage: <em>bench_suite [--output path] [bytes]</em> runs every workload
+ * of about the given size, writing the results to the standard output
+ * or to the file at the given path, whereas <em>bench_suite --generate
+ * name [bytes]</em> writes the input of the named workload to the
+ * standard output.
+ */
+
+#define BENCH_BYTES   (4 * 1024 * 1024)
+#define BENCH_SECONDS (0.5)
+#define BENCH_DEPTH   (500)
+
+/**
+ * A growable text.
+ */
+struct text {
+    char  *buf;
+    size_t len;
+    size_t cap;
+};
+
+/**
+ * A workload, which appends its input of about the specified size to
+ * the specified text.
+ */
+struct workload {
+    const char *name;
+    void      (*generate)(struct text *text, size_t bytes);
+};
+
+/**
+ * The state of the pseudo-random generator, such that the inputs are
+ * the same on every run.
+ */
+static unsigned long long seed = 12345;
+
+/**
+ * It returns the current time in seconds measured by a
+ * monotonic clock.
+ *
+ * @return the current time in seconds
+ */
+static double
+now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/**
+ * It returns a pseudo-random integer from 0 to n - 1.
+ *
+ * @param n the amount of integers
+ *
+ * @return the pseudo-random integer
+ */
+static unsigned
+next(const unsigned n) {
+    seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+    return (unsigned)(seed >> 33) % n;
+}
+
+/**
+ * It appends the formatted string to the specified text, growing it as
+ * needed.
+ *
+ * @param text   the text
+ * @param format the format of the string
+ */
+static void
+append(struct text *text, const char *format, ...) {
+    va_list args;
+    int     n;
+
+    for (;;) {
+        va_start(args, format);
+        n = vsnprintf(text->buf + text->len, text->cap - text->len, format, args);
+        va_end(args);
+
+        /* It checks if the string has fit in the text */
+        if (n >= 0 && (size_t)n < text->cap - text->len) {
+            text->len += (size_t)n;
+            return;
+        }
+
+        text->cap = text->cap * 2 + (size_t)n + 1;
+        if (n < 0 || !(text->buf = realloc(text->buf, text->cap))) {
+            printf("bench: A text of %zu characters could not be allocated.\n", text->cap);
+            exit(EXIT_FAILURE);
+        }
+    }
+}
+
+/**
+ * It generates statements whose expressions are nested BENCH_DEPTH
+ * parentheses deep, e.g., <em>((x + 1.5) * 0.75 - 2) / 1.25</em>.
+ *
+ * @param text  the text
+ * @param bytes the approximate size of the input
+ */
+static void
+generate_nesting(struct text *text, const size_t bytes) {
+    static const char ops[] = "+-*/";
+
+    append(text, "$x = 1.5;\n");
+    while (text->len < bytes) {
+        for (int d = 0; d < BENCH_DEPTH; d++)
+            append(text, "(");
+        append(text, "x");
+        for (int d = 0; d < BENCH_DEPTH; d++)
+            append(text, " %c %u.%02u)", ops[next(4)], 1 + next(9), next(100));
+        append(text, ";\n");
+    }
+    append(text, "x\n");
+}
+
+/**
+ * It generates statements which are sums of thousands of terms, e.g.,
+ * <em>x + 12.5 + y - 3 + ...</em>.
+ *
+ * @param text  the text
+ * @param bytes the approximate size of the input
+ */
+static void
+generate_sums(struct text *text, const size_t bytes) {
+    append(text, "$x = 0.5;\n$y = 2;\n");
+    while (text->len < bytes) {
+        append(text, "x");
+        for (int t = 0; t < 10000; t++) {
+            const unsigned kind = next(4);
+
+            if (kind == 0)
+                append(text, " + x");
+            else if (kind == 1)
+                append(text, " - y");
+            else append(text, " %c %u.%u", kind == 2 ? '+' : '-', next(1000), next(10));
+        }
+        append(text, ";\n");
+    }
+}
+
+/**
+ * It generates a chain of definitions of long-named variables, each one
+ * defined by the previous ones, e.g., <em>$accountBalance00002 =
+ * accountBalance00001 * 1.01 + accountBalance00000</em>.
+ *
+ * @param text  the text
+ * @param bytes the approximate size of the input
+ */
+static void
+generate_definitions(struct text *text, const size_t bytes) {
+    unsigned n = 2;
+
+    append(text, "$accountBalance00000 = 1;\n$accountBalance00001 := 1.25;\n");
+    for (; text->len < bytes; n++)
+        append(text, "$accountBalance%05u %s= accountBalance%05u * 0.5 + accountBalance%05u / 2;\n", n,
+               next(4) ? "" : ":", n - 1, next(n));
+    append(text, "accountBalance%05u\n", n - 1);
+}
+
+/**
+ * It generates statements of nested calls of the math functions, e.g.,
+ * <em>sin(x) * cos(y / 2) + sqrt(|x - y| + 1)</em>.
+ *
+ * @param text  the text
+ * @param bytes the approximate size of the input
+ */
+static void
+generate_functions(struct text *text, const size_t bytes) {
+    static const char *const names[] = { "sin", "cos", "tan", "floor", "ceil", "sqrt", "cbrt", "log10", "log2" };
+
+    append(text, "$x = 0.75;\n$y = 3;\n");
+    while (text->len < bytes) {
+        for (int t = 0; t < 100; t++) {
+            const char *outer = names[next(9)], *inner = names[next(9)];
+
+            append(text, "%s%s(|%s(x * %u) - y| + %u) * %s(y / %u)", t ? " + " : "", outer, inner, 1 + next(9),
+                   1 + next(9), names[next(9)], 1 + next(9));
+        }
+        append(text, ";\n");
+    }
+}
+
+/**
+ * It generates number-dense statements, in which integers, decimals and
+ * numbers in scientific notation are the most of the input, e.g.,
+ * <em>1.2345e-3 * 42 + 0.125 - 7.5e10 / x</em>.
+ *
+ * @param text  the text
+ * @param bytes the approximate size of the input
+ */
+static void
+generate_numbers(struct text *text, const size_t bytes) {
+    static const char ops[] = "+-*/";
+
+    append(text, "$x = 3;\n");
+    while (text->len < bytes) {
+        append(text, "x");
+        for (int t = 0; t < 1000; t++) {
+            switch (next(3)) {
+                case 0:  append(text, " %c %u", ops[next(4)], next(100000));                             break;
+                case 1:  append(text, " %c %u.%06u", ops[next(4)], next(1000), next(1000000));           break;
+                default: append(text, " %c %u.%03ue-%u", ops[next(4)], 1 + next(9), next(1000), next(20));
+            }
+        }
+        append(text, ";\n");
+    }
+}
+
+/**
+ * The workloads of the suite.
+ */
+static const struct workload workloads[] = {
+    { "nesting",     generate_nesting     },
+    { "sums",        generate_sums        },
+    { "definitions", generate_definitions },
+    { "functions",   generate_functions   },
+    { "numbers",     generate_numbers     }
+};
+
+#define BENCH_WORKLOADS (sizeof(workloads) / sizeof(workloads[0]))
+
+/**
+ * It runs the specified workload and prints its results as a JSON
+ * object.
+ *
+ * @param workload the workload
+ * @param bytes    the approximate size of its input
+ */
+static void
+run(const struct workload *workload, const size_t bytes) {
+    struct text     text   = { 0 };
+    struct lexer    lexer  = { 0 };
+    struct parser  *parser = parser_new();
+    struct program *program;
+    struct program *optimized;
+    struct rusage   usage;
+    double         *frame;
+    volatile double sink   = 0.0;
+    size_t          tokens = 0, evaluations = 0;
+    uint32_t        nodes;
+    double          lexing = 1e30, parsing = 1e30, start, elapsed;
+
+    workload->generate(&text, bytes);
+
+    /* The lexer and the parser are measured by their best of three runs */
+    for (int r = 0; r < 3; r++) {
+        start = now();
+        init_lexer_buffer(&lexer, text.buf, text.len);
+        for (tokens = 0; next_token(&lexer)->type != LEXER_TOKEN_EOF; tokens++);
+        if ((elapsed = now() - start) < lexing) lexing = elapsed;
+
+        start = now();
+        init_lexer_buffer(&parser->lexer, text.buf, text.len);
+        program = compile(parser);
+        if ((elapsed = now() - start) < parsing) parsing = elapsed;
+
+        /* It checks if the workload has generated an invalid input */
+        if (parser->nerrors) {
+            print_errors(parser);
+            exit(EXIT_FAILURE);
+        }
+        if (r < 2)
+            program_free(program);
+    }
+
+    nodes     = program->count;
+    optimized = optimize(program);
+    if (!(frame = calloc(program_frame_size(optimized), sizeof(double)))) {
+        printf("bench: An evaluation frame of %zu values could not be allocated.\n", program_frame_size(optimized));
+        exit(EXIT_FAILURE);
+    }
+
+    start = now();
+    do {
+        sink += evaluate(optimized, frame);
+        evaluations++;
+    } while ((elapsed = now() - start) < BENCH_SECONDS);
+
+    getrusage(RUSAGE_SELF, &usage);
+
+    printf("    {\"name\": \"%s\", \"bytes\": %zu, \"tokens\": %zu, \"tokens_per_second\": %.0f, \"nodes\": %u, "
+           "\"nodes_per_second\": %.0f, \"optimized_nodes\": %u, \"evaluations_per_second\": %.1f, "
+           "\"peak_rss_kb\": %ld}", workload->name, text.len, tokens, tokens / lexing, nodes, nodes / parsing,
+           optimized->count, evaluations / elapsed, usage.ru_maxrss);
+    fflush(stdout);
+
+    free(frame);
+    program_free(optimized);
+    program_free(program);
+    parser_free(parser);
+    lexer_free(&lexer);
+    free(text.buf);
+}
+
+int main(int argc, char **argv) {
+    size_t bytes = BENCH_BYTES;
+
+    /* It checks if the input of a workload is to be generated */
+    if (argc > 2 && 0 == strcmp(argv[1], "--generate")) {
+        struct text text = { 0 };
+
+        if (argc > 3)
+            bytes = strtoul(argv[3], NULL, 10);
+        for (size_t w = 0; w < BENCH_WORKLOADS; w++) {
+            if (0 == strcmp(workloads[w].name, argv[2])) {
+                workloads[w].generate(&text, bytes);
+                fwrite(text.buf, 1, text.len, stdout);
+                free(text.buf);
+                return 0;
+            }
+        }
+        printf("bench: The workload %s does not exist.\n", argv[2]);
+        exit(EXIT_FAILURE);
+    }
+
+    /* It checks if the results are written to a file */
+    if (argc > 2 && 0 == strcmp(argv[1], "--output")) {
+        if (!freopen(argv[2], "w", stdout)) {
+            fprintf(stderr, "bench: The results could not be written to %s.\n", argv[2]);
+            exit(EXIT_FAILURE);
+        }
+        argc -= 2, argv += 2;
+    }
+
+    if (argc > 1)
+        bytes = strtoul(argv[1], NULL, 10);
+
+    /* The output is flushed before each fork, such that it is not */
+    /* written again by the workload */
+    printf("{\n  \"bytes\": %zu,\n  \"workloads\": [\n", bytes);
+    fflush(stdout);
+
+    /* Each workload runs in a process of its own */
+    for (size_t w = 0; w < BENCH_WORKLOADS; w++) {
+        const pid_t pid = fork();
+        int         status;
+
+        if (pid == 0) {
+            run(&workloads[w], bytes);
+            exit(EXIT_SUCCESS);
+        }
+
+        if (pid < 0 || waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status)) {
+            fprintf(stderr, "bench: The workload %s has failed.\n", workloads[w].name);
+            exit(EXIT_FAILURE);
+        }
+        printf(w + 1 < BENCH_WORKLOADS ? ",\n" : "\n");
+        fflush(stdout);
+    }
+
+    printf("  ]\n}\n");
+
+    return 0;
+}
@@ -0,0 +1,240 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Ricardo Fares
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <math.h>
+
+#include "../ast/ast.h"
+#include "../eval/eval.h"
+#include "../batch/simd.h"
+
+/**
+ * It is a check of the accuracy of the vectorized kernels against the
+ * math library over dense grids of samples, and a benchmark of their
+ * throughput against calling the math library once per value.
+ * <p>
+ * For each operation, it measures the maximum error in ULPs of every
+ * instruction set supported by the processor, checks that it is within
+ * the documented bound and that every instruction set computes the very
+ * same values. If a check fails, then it exits with a failure status.
+ */
+
+#define BENCH_SAMPLES (1 << 21)
+
+/**
+ * An operation checked against the math library.
+ */
+struct check {
+    uint32_t    op;
+    const char *name;
+    double      bound; /* the documented maximum error in ULPs */
+    double      lo;    /* the range of the samples */
+    double      hi;
+    int         logarithmic;
+};
+
+/**
+ * The operations being checked.
+ * <p>
+ * The samples of the logarithmic ranges are evenly spaced in the
+ * exponent, either positive or negative if the range low is negative.
+ */
+static const struct check checks[] = {
+    { AST_SIN,   "sin",   1.0, -10.0,    10.0,     0 },
+    { AST_SIN,   "sin",   1.0, -823549., 823549.,  0 },
+    { AST_COS,   "cos",   1.0, -10.0,    10.0,     0 },
+    { AST_COS,   "cos",   1.0, -823549., 823549.,  0 },
+    { AST_TAN,   "tan",   2.0, -10.0,    10.0,     0 },
+    { AST_TAN,   "tan",   2.0, -823549., 823549.,  0 },
+    { AST_CSC,   "csc",   2.0, -10.0,    10.0,     0 },
+    { AST_SEC,   "sec",   2.0, -10.0,    10.0,     0 },
+    { AST_COT,   "cot",   2.0, -10.0,    10.0,     0 },
+    { AST_SIN,   "sin",   1.0, 1e-30,    1e30,     1 },
+    { AST_TAN,   "tan",   2.0, 1e-30,    1e30,     1 },
+    { AST_LOG2,  "log2",  1.0, 0.5,      2.0,      0 },
+    { AST_LOG2,  "log2",  1.0, 1e-320,   1e308,    1 },
+    { AST_LOG10, "log10", 2.0, 0.5,      2.0,      0 },
+    { AST_LOG10, "log10", 2.0, 1e-320,   1e308,    1 },
+    { AST_CBRT,  "cbrt",  3.0, -1e308,   1e308,    1 },
+    { AST_CBRT,  "cbrt",  3.0, -10.0,    10.0,     0 },
+    { AST_SQRT,  "sqrt",  0.0, 1e-320,   1e308,    1 },
+    { AST_FLOOR, "floor", 0.0, -1e6,     1e6,      0 },
+    { AST_FLOOR, "floor", 0.0, -1e17,    1e17,     1 },
+    { AST_CEIL,  "ceil",  0.0, -1e6,     1e6,      0 },
+    { AST_CEIL,  "ceil",  0.0, -1e17,    1e17,     1 },
+    { AST_ABS,   "abs",   0.0, -1e300,   1e300,    1 },
+    { AST_POW,   "pow",   1.0, -1e70,    1e70,     1 },
+    { AST_POW,   "pow",   1.0, -10.0,    10.0,     0 },
+};
+
+/**
+ * The exponents of the power samples, which are used in turn.
+ */
+static const double exponents[] = { -4.0, -3.0, -2.0, -1.0, 0.0, 1.0, 2.0, 3.0, 4.0, 0.5, 1.5, -0.5, 2.75 };
+
+/**
+ * It returns the current time in seconds measured by a
+ * monotonic clock.
+ *
+ * @return the current time in seconds
+ */
+static double
+now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/**
+ * It maps the specified double to an integer, such that the integers of
+ * two doubles differ by the amount of doubles between them.
+ *
+ * @param x the double
+ *
+ * @return the ordered integer
+ */
+static int64_t
+ordered(const double x) {
+    int64_t i;
+    memcpy(&i, &x, sizeof(i));
+    return i < 0 ? INT64_MIN - i : i;
+}
+
+/**
+ * It returns the distance in ULPs between the specified value and
+ * the specified expected value.
+ *
+ * @param value    the value
+ * @param expected the expected value
+ *
+ * @return the distance in ULPs, or infinity if only one is NaN
+ */
+static double
+ulps(const double value, const double expected) {
+    if (isnan(value) || isnan(expected))
+        return isnan(value) && isnan(expected) ? 0.0 : INFINITY;
+    const int64_t a = ordered(value), b = ordered(expected);
+    return (double)(a > b ? (uint64_t)a - (uint64_t)b : (uint64_t)b - (uint64_t)a);
+}
+
+/**
+ * It fills the samples of the specified check.
+ *
+ * @param check the check
+ * @param x     the left operands
+ * @param y     the right operands
+ */
+static void
+sample(const struct check *check, double *x, double *y) {
+    for (size_t i = 0; i < BENCH_SAMPLES; i++) {
+        const double t = (double)i / (BENCH_SAMPLES - 1);
+
+        if (check->logarithmic) {
+            /* It checks if the samples are either positive or negative */
+            const double lo   = check->lo < 0.0 ? fabs(check->hi) * 1e-300 : check->lo;
+            const double sign = check->lo < 0.0 && (i & 1) ? -1.0 : 1.0;
+            x[i] = sign * exp2(log2(lo) + t * (log2(fabs(check->hi)) - log2(lo)));
+        } else x[i] = check->lo + t * (check->hi - check->lo);
+
+        /* It changes the exponent every block, as a formula usually has a constant one */
+        y[i] = exponents[i / 4096 % (sizeof(exponents) / sizeof(exponents[0]))];
+    }
+}
+
+int main() {
+    const int  widest   = simd_detect();
+    double    *x        = malloc(sizeof(double) * BENCH_SAMPLES);
+    double    *y        = malloc(sizeof(double) * BENCH_SAMPLES);
+    double    *expected = malloc(sizeof(double) * BENCH_SAMPLES);
+    double    *baseline = malloc(sizeof(double) * BENCH_SAMPLES);
+    double    *out      = malloc(sizeof(double) * BENCH_SAMPLES);
+    int        failed   = 0;
+
+    if (!x || !y || !expected || !baseline || !out) {
+        printf("bench: The samples could not be allocated.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    printf("ulp: %d samples per range, widest instruction set %s.\n", BENCH_SAMPLES, simd_name(widest));
+
+    for (size_t c = 0; c < sizeof(checks) / sizeof(checks[0]); c++) {
+        const struct check *check = &checks[c];
+        const double       *rhs   = check->op == AST_POW ? y : NULL;
+        double              start, libm, worst = 0.0;
+        double              vector[SIMD_AVX512 + 1] = { 0 };
+
+        sample(check, x, y);
+
+        start = now();
+        for (size_t i = 0; i < BENCH_SAMPLES; i++)
+            expected[i] = apply(check->op, x[i], rhs ? y[i] : 0.0);
+        libm = (now() - start) / BENCH_SAMPLES;
+
+        for (int isa = SIMD_BASELINE; isa <= widest; isa++) {
+            const simd_kernel kernel = simd_select(isa);
+
+            start = now();
+            kernel(check->op, BENCH_SAMPLES, out, x, rhs);
+            vector[isa] = (now() - start) / BENCH_SAMPLES;
+
+            for (size_t i = 0; i < BENCH_SAMPLES; i++) {
+                const double error = ulps(out[i], expected[i]);
+
+                if (error > worst)
+                    worst = error;
+                if (error > check->bound && !failed++)
+                    printf("ulp: %s(%a, %a) is %a instead of %a.\n", check->name, x[i], rhs ? y[i] : 0.0,
+                           out[i], expected[i]);
+            }
+
+            /* It checks if the instruction set disagrees with the baseline */
+            if (isa == SIMD_BASELINE)
+                memcpy(baseline, out, sizeof(double) * BENCH_SAMPLES);
+            else if (memcmp(baseline, out, sizeof(double) * BENCH_SAMPLES)) {
+                printf("ulp: %s disagrees between %s and %s.\n", check->name, simd_name(isa),
+                       simd_name(SIMD_BASELINE));
+                failed++;
+            }
+        }
+
+        printf("ulp: %-5s [%9.3g, %9.3g] %g ulp (bound %g), libm %5.2f ns, %s %5.2f ns, %s %5.2f ns.\n",
+               check->name, check->lo, check->hi, worst, check->bound, libm * 1e9,
+               simd_name(SIMD_BASELINE), vector[SIMD_BASELINE] * 1e9, simd_name(widest), vector[widest] * 1e9);
+    }
+
+    free(x);
+    free(y);
+    free(expected);
+    free(baseline);
+    free(out);
+
+    if (failed) {
+        printf("ulp: %d checks failed.\n", failed);
+        exit(EXIT_FAILURE);
+    }
+
+    return 0;
+}
@@ -0,0 +1,164 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Ricardo Fares
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../lexer/lexer.h"
+#include "../parser/parser.h"
+#include "../eval/eval.h"
+#include "../opt/opt.h"
+#include "../vm/vm.h"
+#include "../jit/jit.h"
+
+/**
+ * It is a benchmark of the per-evaluation latency of a formula by the
+ * recursive descent parser re-run on the text, by the expression tree
+ * evaluator, before and after its constants are folded, by the bytecode
+ * virtual machine and by the machine code compiled by the JIT.
+ * <p>
+ * Before measuring, it checks that every engine computes the same value.
+ */
+
+#define BENCH_EVALUATIONS (1000000)
+#define BENCH_REPARSES    (100000)
+
+/**
+ * The formula being evaluated.
+ */
+static const char formula[] =
+    "$base     = 120.5;\n"
+    "$qty      = 17;\n"
+    "$rate     := 0.0825;\n"
+    "$discount := 0.15;\n"
+    "$gross    := base * qty;\n"
+    "(gross * (1 - discount) + sqrt(base) * log2(qty + 1)) * (1 + rate)\n"
+    "    - floor(base / 7) + |rate - discount| * 100 + gross * base / (qty * qty * rate)\n";
+
+/**
+ * It returns the current time in seconds measured by a
+ * monotonic clock.
+ *
+ * @return the current time in seconds
+ */
+static double
+now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/**
+ * It compiles the formula.
+ *
+ * @param parser the parser
+ *
+ * @return the compiled formula
+ */
+static struct program *
+compile_formula(struct parser *parser) {
+    init_lexer_buffer(&parser->lexer, formula, sizeof(formula) - 1);
+    return compile(parser);
+}
+
+int main() {
+    struct parser   *parser   = parser_new();
+    struct program  *program  = compile_formula(parser);
+    struct program  *folded   = optimize(program);
+    struct bytecode *bytecode = vm_compile(program);
+    struct jit      *jit      = jit_compile(bytecode);
+    const size_t     size     = program_frame_size(program) > program_frame_size(folded)
+                              ? program_frame_size(program) : program_frame_size(folded);
+    double          *frame    = calloc(size, sizeof(double));
+    volatile double  sink     = 0.0;
+    double           start, reparse, tree, opt, vm, native = 0.0;
+
+    if (!frame) {
+        printf("bench: The evaluation frame could not be allocated.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    /* It checks if the engines disagree on the formula value */
+    const double expected = evaluate(program, frame);
+    if (vm_run(bytecode, frame) != expected || (jit && jit->fn(frame) != expected)
+            || evaluate(folded, frame) != expected) {
+        printf("bench: The engines disagree on the value of the formula.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    start = now();
+    for (int i = 0; i < BENCH_REPARSES; i++) {
+        struct program *reparsed = compile_formula(parser);
+        double         *reframe  = calloc(program_frame_size(reparsed), sizeof(double));
+
+        sink += evaluate(reparsed, reframe);
+
+        free(reframe);
+        program_free(reparsed);
+    }
+    reparse = (now() - start) / BENCH_REPARSES;
+
+    start = now();
+    for (int i = 0; i < BENCH_EVALUATIONS; i++)
+        sink += evaluate(program, frame);
+    tree = (now() - start) / BENCH_EVALUATIONS;
+
+    start = now();
+    for (int i = 0; i < BENCH_EVALUATIONS; i++)
+        sink += evaluate(folded, frame);
+    opt = (now() - start) / BENCH_EVALUATIONS;
+
+    start = now();
+    for (int i = 0; i < BENCH_EVALUATIONS; i++)
+        sink += vm_run(bytecode, frame);
+    vm = (now() - start) / BENCH_EVALUATIONS;
+
+    if (jit) {
+        start = now();
+        for (int i = 0; i < BENCH_EVALUATIONS; i++)
+            sink += jit->fn(frame);
+        native = (now() - start) / BENCH_EVALUATIONS;
+    }
+
+    printf("vm: %u nodes (%u folded), %u bytecode words.\n", program->count, folded->count, bytecode->len);
+    printf("vm: reparse %8.1f ns/evaluation.\n", reparse * 1e9);
+    printf("vm: tree    %8.1f ns/evaluation (%.1fx).\n", tree * 1e9, reparse / tree);
+    printf("vm: folded  %8.1f ns/evaluation (%.1fx).\n", opt * 1e9, reparse / opt);
+    printf("vm: vm      %8.1f ns/evaluation (%.1fx).\n", vm * 1e9, reparse / vm);
+    if (jit)
+        printf("vm: jit     %8.1f ns/evaluation (%.1fx).\n", native * 1e9, reparse / native);
+    else
+        printf("vm: jit     unsupported on this host.\n");
+
+    free(frame);
+    if (jit)
+        jit_free(jit);
+    bytecode_free(bytecode);
+    program_free(folded);
+    program_free(program);
+    parser_free(parser);
+
+    return 0;
+}
@@ -0,0 +1,96 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Ricardo Fares
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "./factorials.h"
+#include "./eval.h"
+
+double
+evaluate(const struct program *program, double *vars) {
+    const struct ast_node *nodes = program->nodes;
+    double                *t     = vars + program->nslots + program->nresults; /* node values */
+
+    for (uint32_t i = 0; i < program->count; i++) {
+        const struct ast_node *node = &nodes[i];
+
+        switch (node->op) {
+            case AST_NUMBER: t[i] = program->consts[node->aux];       break;
+            case AST_LOAD:   t[i] = vars[node->aux];                  break;
+            case AST_STORE:  t[i] = vars[node->aux] = t[node->lhs];   break;
+            case AST_ADD:    t[i] = t[node->lhs] + t[node->rhs];      break;
+            case AST_SUB:    t[i] = t[node->lhs] - t[node->rhs];      break;
+            case AST_MUL:    t[i] = t[node->lhs] * t[node->rhs];      break;
+            case AST_DIV:    t[i] = t[node->lhs] / t[node->rhs];      break;
+            case AST_POW:    t[i] = pow(t[node->lhs], t[node->rhs]);  break;
+            default:         t[i] = apply(node->op, t[node->lhs], 0.0);
+        }
+    }
+
+    for (uint32_t i = 0; i < program->nstatements; i++) {
+        const struct ast_statement *statement = &program->statements[i];
+        if (statement->output != AST_NONE)
+            vars[program->nslots + statement->output] = t[statement->node];
+    }
+
+    return program->nresults ? t[program->result] : NAN;
+}
+
+double
+apply(const uint32_t op, const double lhs, const double rhs) {
+    switch (op) {
+        case AST_ADD:   return lhs + rhs;
+        case AST_SUB:   return lhs - rhs;
+        case AST_MUL:   return lhs * rhs;
+        case AST_DIV:   return lhs / rhs;
+        case AST_POW:   return pow(lhs, rhs);
+        case AST_FACT:  return factorial(lhs);
+        case AST_ABS:   return fabs(lhs);
+        case AST_SIN:   return sin(lhs);
+        case AST_COS:   return cos(lhs);
+        case AST_TAN:   return tan(lhs);
+        case AST_CSC:   return 1.0 / sin(lhs);
+        case AST_SEC:   return 1.0 / cos(lhs);
+        case AST_COT:   return 1.0 / tan(lhs);
+        case AST_FLOOR: return floor(lhs);
+        case AST_CEIL:  return ceil(lhs);
+        case AST_SQRT:  return sqrt(lhs);
+        case AST_CBRT:  return cbrt(lhs);
+        case AST_LOG10: return log10(lhs);
+        case AST_LOG2:  return log2(lhs);
+    }
+
+    printf("apply: Should not reach here!");
+    exit(EXIT_FAILURE);
+}
+
+double
+factorial(const double x) {
+    /* It checks if the factorial is the empty product, also of NaN */
+    if (!(x >= 1.0))
+        return 1.0;
+
+    return x < FACTORIAL_MAX + 1 ? factorials[(int)x] : INFINITY;
+}
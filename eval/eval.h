@@ -0,0 +1,91 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Ricardo Fares
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef EVAL_H
+#define EVAL_H
+
+#include <stdint.h>
+
+#include "../ast/ast.h"
+
+/**
+ * The greatest integer whose factorial is a finite double.
+ */
+#define FACTORIAL_MAX (170)
+
+/* Function Declaration */
+
+/**
+ * It evaluates the specified program.
+ * <p>
+ * The frame must have <em>program_frame_size(program)</em> doubles.
+ * Its first <em>program->nslots</em> doubles are the variables, which
+ * are read by the loads and written by the stores of the program, the
+ * next <em>program->nresults</em> doubles receive the value of each
+ * result, and the remaining doubles are the scratch storage for the
+ * node values.
+ * <p>
+ * The program is not modified, hence, it may be evaluated any amount
+ * of times, and concurrently as long as each evaluation has its own
+ * frame.
+ *
+ * @param program the program to be evaluated
+ * @param vars    the evaluation frame
+ *
+ * @return the value of the last program result, or NaN if the program
+ *         has no result
+ */
+double
+evaluate(const struct program *program, double *vars);
+
+/**
+ * It applies the specified operation to the specified operands.
+ * <p>
+ * The right operand is ignored by the unary operations.
+ *
+ * @param op  the operation, neither a number, a load nor a store
+ * @param lhs the left operand
+ * @param rhs the right operand
+ *
+ * @return the result of the operation
+ */
+double
+apply(uint32_t op, double lhs, double rhs);
+
+/**
+ * It calculates the factorial of the specified double
+ * floating-point number x, that is, x!.
+ * <p>
+ * The factorial of a number is the product of the integers from
+ * 1 to the number, hence, it is the factorial of its integer part,
+ * and 1 below 1. It is looked up in a table of the factorials up to
+ * FACTORIAL_MAX!, beyond which it is the infinity.
+ *
+ * @param x the number to calculate its factorial
+ *
+ * @return the factorial of x, that is, x!
+ */
+double
+factorial(double x);
+
+#endif // EVAL_H
@@ -0,0 +1,257 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Ricardo Fares
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "./eval.h"
+#include "./incremental.h"
+
+/**
+ * It allocates the specified amount of zeroed words.
+ * <p>
+ * If there is not enough memory, then the application is immediately
+ * terminated.
+ *
+ * @param n    the amount of words
+ * @param size the size of a word
+ *
+ * @return the allocated words
+ */
+static void *
+allocate(const size_t n, const size_t size) {
+    void *words = calloc(n ? n : 1, size);
+
+    /* It checks if there is not enough memory to allocate the words */
+    if (!words) {
+        printf("incremental: %zu words could not be allocated.\n", n);
+        exit(EXIT_FAILURE);
+    }
+    return words;
+}
+
+/**
+ * It evaluates the nodes of the specified statement, as the parallel
+ * evaluation does, that is, the loads read either the values of their
+ * stores or the inputs.
+ *
+ * @param incremental the evaluation
+ * @param statement   the statement
+ *
+ * @return a non-zero value if the value of one of its nodes has changed,
+ *         otherwise, zero
+ */
+static int
+evaluate_statement(const struct incremental *incremental, const uint32_t statement) {
+    const struct program  *program = incremental->program;
+    const struct ast_node *nodes   = program->nodes;
+    const double          *vars    = incremental->frame;
+    double                *t       = incremental->frame + program->nslots + program->nresults;
+    const uint32_t         end     = program->statements[statement].end;
+    int                    changed = 0;
+
+    for (uint32_t i = statement ? program->statements[statement - 1].end : 0; i < end; i++) {
+        const struct ast_node *node = &nodes[i];
+        double                 value;
+
+        switch (node->op) {
+            case AST_NUMBER: value = program->consts[node->aux];                          break;
+            case AST_LOAD:   value = node->rhs != AST_NONE ? t[node->rhs] : vars[node->aux]; break;
+            case AST_STORE:  value = t[node->lhs];                                        break;
+            case AST_ADD:    value = t[node->lhs] + t[node->rhs];                         break;
+            case AST_SUB:    value = t[node->lhs] - t[node->rhs];                         break;
+            case AST_MUL:    value = t[node->lhs] * t[node->rhs];                         break;
+            case AST_DIV:    value = t[node->lhs] / t[node->rhs];                         break;
+            case AST_POW:    value = pow(t[node->lhs], t[node->rhs]);                     break;
+            default:         value = apply(node->op, t[node->lhs], 0.0);
+        }
+
+        changed |= memcmp(&value, &t[i], sizeof(double)) != 0;
+        t[i]     = value;
+    }
+
+    return changed;
+}
+
+struct incremental *
+incremental_new(const struct program *program) {
+    const uint32_t      n           = program->nstatements;
+    struct incremental *incremental = allocate(1, sizeof(struct incremental));
+    uint32_t           *input       = allocate(program->nslots, sizeof(uint32_t));
+
+    incremental->program    = program;
+    incremental->frame      = allocate(program_frame_size(program), sizeof(double));
+    incremental->firsts     = allocate((size_t)n + 1, sizeof(uint32_t));
+    incremental->dependents = allocate(program->ndeps, sizeof(uint32_t));
+    incremental->dirty      = allocate(((size_t)n + 63) / 64, sizeof(uint64_t));
+
+    /* The dependents are the dependencies of the program reversed, */
+    /* which are counted before being placed */
+    for (uint32_t i = 0; i < n; i++)
+        for (uint32_t d = 0; d < program->statements[i].ndeps; d++)
+            incremental->firsts[program->deps[program->statements[i].deps + d] + 1]++;
+    for (uint32_t i = 0; i < n; i++)
+        incremental->firsts[i + 1] += incremental->firsts[i];
+    for (uint32_t i = 0; i < n; i++)
+        for (uint32_t d = 0; d < program->statements[i].ndeps; d++)
+            incremental->dependents[incremental->firsts[program->deps[program->statements[i].deps + d]]++] = i;
+    for (uint32_t i = n; i > 0; i--)
+        incremental->firsts[i] = incremental->firsts[i - 1];
+    incremental->firsts[0] = 0;
+
+    /* The readers are the statements having the loads without a store, */
+    /* which are numbered by input, counted and then placed likewise */
+    memset(input, 0xFF, sizeof(uint32_t) * program->nslots);
+    for (uint32_t i = 0; i < program->count; i++)
+        if (program->nodes[i].op == AST_LOAD && program->nodes[i].rhs == AST_NONE
+                && input[program->nodes[i].aux] == AST_NONE)
+            input[program->nodes[i].aux] = incremental->ninputs++;
+
+    incremental->inputs  = allocate(incremental->ninputs, sizeof(uint32_t));
+    incremental->starts  = allocate((size_t)incremental->ninputs + 1, sizeof(uint32_t));
+    for (uint32_t s = 0; s < program->nslots; s++)
+        if (input[s] != AST_NONE)
+            incremental->inputs[input[s]] = s;
+
+    for (uint32_t i = 0; i < program->count; i++)
+        if (program->nodes[i].op == AST_LOAD && program->nodes[i].rhs == AST_NONE)
+            incremental->starts[input[program->nodes[i].aux] + 1]++;
+    for (uint32_t k = 0; k < incremental->ninputs; k++)
+        incremental->starts[k + 1] += incremental->starts[k];
+    incremental->readers = allocate(incremental->starts[incremental->ninputs], sizeof(uint32_t));
+    for (uint32_t i = 0, statement = 0; i < program->count; i++) {
+        while (statement < program->nstatements && program->statements[statement].end <= i)
+            statement++;
+        if (program->nodes[i].op == AST_LOAD && program->nodes[i].rhs == AST_NONE)
+            incremental->readers[incremental->starts[input[program->nodes[i].aux]]++] = statement;
+    }
+    for (uint32_t k = incremental->ninputs; k > 0; k--)
+        incremental->starts[k] = incremental->starts[k - 1];
+    incremental->starts[0] = 0;
+
+    free(input);
+
+    return incremental;
+}
+
+uint32_t
+incremental_update(struct incremental *incremental, double *vars, uint32_t *changed) {
+    const struct program *program  = incremental->program;
+    const uint32_t        nwords   = (program->nstatements + 63) / 64;
+    double               *t        = incremental->frame + program->nslots + program->nresults;
+    const int             all      = !incremental->evaluated;
+    uint32_t              nchanged = 0;
+    uint32_t              first    = nwords;
+
+    /* It checks if the program has not been evaluated yet. If so, */
+    /* every statement is evaluated and every result has changed */
+    if (all) {
+        memcpy(incremental->frame, vars, sizeof(double) * program->nslots);
+        memset(incremental->dirty, 0xFF, sizeof(uint64_t) * nwords);
+        if (program->nstatements % 64)
+            incremental->dirty[nwords - 1] = (1ull << (program->nstatements % 64)) - 1;
+        incremental->evaluated = 1;
+        first = 0;
+    }
+
+    /* The readers of the inputs which have changed are evaluated again */
+    for (uint32_t k = 0; k < incremental->ninputs && !all; k++) {
+        const uint32_t slot = incremental->inputs[k];
+
+        if (memcmp(&incremental->frame[slot], &vars[slot], sizeof(double)) == 0)
+            continue;
+        incremental->frame[slot] = vars[slot];
+        for (uint32_t r = incremental->starts[k]; r < incremental->starts[k + 1]; r++) {
+            const uint32_t reader = incremental->readers[r];
+
+            incremental->dirty[reader / 64] |= 1ull << (reader % 64);
+            if (reader / 64 < first)
+                first = reader / 64;
+        }
+    }
+
+    /* A statement only has later dependents, hence, the statements */
+    /* are evaluated in their order while their dependents are marked */
+    for (uint32_t w = first; w < nwords; w++) {
+        while (incremental->dirty[w]) {
+            const uint32_t              s         = w * 64 + (uint32_t)__builtin_ctzll(incremental->dirty[w]);
+            const struct ast_statement *statement = &program->statements[s];
+            double                     *result;
+
+            incremental->dirty[w] &= incremental->dirty[w] - 1;
+
+            /* It checks if the value of one of its nodes has changed. If so, */
+            /* its dependents, which refer to its nodes, are evaluated again */
+            if (evaluate_statement(incremental, s) || all) {
+                for (uint32_t d = incremental->firsts[s]; d < incremental->firsts[s + 1]; d++)
+                    incremental->dirty[incremental->dependents[d] / 64] |= 1ull << (incremental->dependents[d] % 64);
+
+                if (statement->output == AST_NONE
+                        && program->stores[program->nodes[statement->node].aux] == statement->node)
+                    vars[program->nodes[statement->node].aux] = t[statement->node];
+            }
+
+            /* The node of a result may belong to one of its dependencies, */
+            /* hence, it is compared with the value the result last had */
+            if (statement->output != AST_NONE) {
+                result = &incremental->frame[program->nslots + statement->output];
+                if (all || memcmp(result, &t[statement->node], sizeof(double))) {
+                    *result = t[statement->node];
+                    if (changed)
+                        changed[nchanged] = statement->output;
+                    nchanged++;
+                }
+            }
+        }
+    }
+
+    /* An input stored by the program holds its stored value, even if */
+    /* it has been set since, as it is read by the next evaluation */
+    for (uint32_t k = 0; k < incremental->ninputs; k++) {
+        const uint32_t slot = incremental->inputs[k];
+
+        if (program->stores[slot] != AST_NONE)
+            vars[slot] = t[program->stores[slot]];
+    }
+
+    return nchanged;
+}
+
+const double *
+incremental_frame(const struct incremental *incremental) {
+    return incremental->frame;
+}
+
+void
+incremental_free(struct incremental *incremental) {
+    free(incremental->frame);
+    free(incremental->firsts);
+    free(incremental->dependents);
+    free(incremental->inputs);
+    free(incremental->starts);
+    free(incremental->readers);
+    free(incremental->dirty);
+    free(incremental);
+}
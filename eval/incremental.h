@@ -0,0 +1,122 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Ricardo Fares
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef INCREMENTAL_H
+#define INCREMENTAL_H
+
+#include <stdint.h>
+
+#include "../ast/ast.h"
+
+/**
+ * An incremental evaluation of a program.
+ * <p>
+ * It keeps the frame of the last evaluation of the program, as well as
+ * the graph of its statements, in which each statement points to the
+ * statements depending on it, i.e., referring to its nodes, and each
+ * variable points to the statements reading the value it had before
+ * the program stored it, that is, to its readers.
+ * <p>
+ * The variables of its frame are the inputs of the last evaluation,
+ * rather than the values stored by the program, such that an input
+ * which has changed since then is told apart. The values stored by the
+ * program are the values of its stores, in the node values.
+ */
+struct incremental {
+    const struct program *program;
+    double               *frame;
+    uint32_t             *dependents; /* the dependents of every statement */
+    uint32_t             *firsts;     /* the first dependent of each statement, and the last end */
+    uint32_t             *inputs;     /* the variables read before being stored */
+    uint32_t              ninputs;
+    uint32_t             *readers;    /* the readers of every input */
+    uint32_t             *starts;     /* the first reader of each input, and the last end */
+    uint64_t             *dirty;      /* the statements to be evaluated again */
+    int                   evaluated;
+};
+
+/* Function Declaration */
+
+/**
+ * It allocates the incremental evaluation of the specified program,
+ * which has not been evaluated yet.
+ * <p>
+ * If there is not enough memory to allocate the evaluation, then the
+ * application is immediately terminated.
+ *
+ * @param program the program, which must outlive the evaluation
+ *
+ * @return the evaluation, which must be freed by <em>incremental_free</em>
+ */
+struct incremental *
+incremental_new(const struct program *program);
+
+/**
+ * It evaluates the statements of the specified program depending on
+ * the variables whose values differ from the inputs of its last
+ * evaluation, that is, their transitive dependents, or every statement
+ * if it has not been evaluated yet.
+ * <p>
+ * A statement is evaluated again only if one of its dependencies has
+ * a node whose value has changed, hence, an input changing a value that
+ * is then discarded does not reach the whole graph. The values are
+ * compared bit by bit, such that NaN is unchanged.
+ * <p>
+ * The variables are read from the specified values, in which each
+ * statement evaluated again writes its variable if it is the last store
+ * of the variable, hence, the variables stored by the program hold their
+ * last stored values, as <em>evaluate</em> leaves them. The frame of the
+ * evaluation holds the value of each result after its variables.
+ *
+ * @param incremental the evaluation
+ * @param vars        the values of the variables, which has
+ *                    <em>program->nslots</em> doubles
+ * @param changed     the placeholder for the outputs of the results
+ *                    whose value has changed, in ascending order, which
+ *                    has <em>program->nresults</em> indices, or NULL
+ *
+ * @return the amount of results whose value has changed
+ */
+uint32_t
+incremental_update(struct incremental *incremental, double *vars, uint32_t *changed);
+
+/**
+ * It returns the frame of the last evaluation of the specified
+ * incremental evaluation, whose results follow its variables.
+ *
+ * @param incremental the evaluation
+ *
+ * @return the frame of the last evaluation
+ */
+const double *
+incremental_frame(const struct incremental *incremental);
+
+/**
+ * It frees the specified incremental evaluation.
+ *
+ * @param incremental the evaluation
+ */
+void
+incremental_free(struct incremental *incremental);
+
+#endif // INCREMENTAL_H
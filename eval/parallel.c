@@ -0,0 +1,176 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Ricardo Fares
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "./eval.h"
+#include "./parallel.h"
+
+/**
+ * The amount of tasks each worker is given for a level, such that the
+ * claims are amortized over several statements, whereas the workers
+ * still have tasks to steal from each other.
+ */
+#define PARALLEL_TASKS (16)
+
+/**
+ * An evaluation of a program whose statements of a level are run by
+ * the workers of a pool.
+ */
+struct parallel {
+    const struct program *program;
+    const double         *vars;  /* the variables, which are only read */
+    double               *t;     /* the node values */
+    const uint32_t       *level; /* the statements of the level being run */
+    uint32_t              count; /* the amount of statements of the level */
+    uint32_t              grain; /* the amount of statements of a task */
+};
+
+/**
+ * It evaluates the nodes of the specified statement.
+ * <p>
+ * The nodes of the other statements it refers to have already been
+ * evaluated, since they belong to its dependencies.
+ *
+ * @param parallel  the evaluation
+ * @param statement the statement
+ */
+static void
+evaluate_statement(const struct parallel *parallel, const uint32_t statement) {
+    const struct program  *program = parallel->program;
+    const struct ast_node *nodes   = program->nodes;
+    double                *t       = parallel->t;
+    const uint32_t         end     = program->statements[statement].end;
+
+    for (uint32_t i = statement ? program->statements[statement - 1].end : 0; i < end; i++) {
+        const struct ast_node *node = &nodes[i];
+
+        switch (node->op) {
+            case AST_NUMBER: t[i] = program->consts[node->aux];                                    break;
+            case AST_LOAD:   t[i] = node->rhs != AST_NONE ? t[node->rhs] : parallel->vars[node->aux]; break;
+            case AST_STORE:  t[i] = t[node->lhs];                                                  break;
+            case AST_ADD:    t[i] = t[node->lhs] + t[node->rhs];                                   break;
+            case AST_SUB:    t[i] = t[node->lhs] - t[node->rhs];                                   break;
+            case AST_MUL:    t[i] = t[node->lhs] * t[node->rhs];                                   break;
+            case AST_DIV:    t[i] = t[node->lhs] / t[node->rhs];                                   break;
+            case AST_POW:    t[i] = pow(t[node->lhs], t[node->rhs]);                               break;
+            default:         t[i] = apply(node->op, t[node->lhs], 0.0);
+        }
+    }
+}
+
+/**
+ * It evaluates the statements of the specified task of the level being
+ * run.
+ *
+ * @param arg    the evaluation
+ * @param index  the task
+ * @param worker the worker
+ */
+static void
+evaluate_task(void *arg, const size_t index, const unsigned worker) {
+    const struct parallel *parallel = arg;
+    const uint32_t         first    = (uint32_t)index * parallel->grain;
+    const uint32_t         last     = parallel->count - first < parallel->grain ? parallel->count
+                                                                               : first + parallel->grain;
+
+    (void)worker;
+
+    for (uint32_t i = first; i < last; i++)
+        evaluate_statement(parallel, parallel->level[i]);
+}
+
+double
+evaluate_parallel(const struct program *program, double *vars, struct pool *pool) {
+    const uint32_t  n        = program->nstatements;
+    uint32_t       *levels   = malloc(sizeof(uint32_t) * (n + 1));
+    uint32_t       *order    = malloc(sizeof(uint32_t) * (n + 1));
+    uint32_t       *starts;
+    uint32_t        depth    = 0;
+    struct parallel parallel = { program, vars, vars + program->nslots + program->nresults, NULL, 0, 1 };
+
+    /* It checks if the schedule could not be allocated */
+    if (!levels || !order) {
+        printf("evaluate_parallel: The schedule of %u statements could not be allocated.\n", n);
+        exit(EXIT_FAILURE);
+    }
+
+    /* A statement only depends on earlier statements, */
+    /* hence, their levels are already known */
+    for (uint32_t i = 0; i < n; i++) {
+        const struct ast_statement *statement = &program->statements[i];
+
+        levels[i] = 0;
+        for (uint32_t d = 0; d < statement->ndeps; d++)
+            if (levels[program->deps[statement->deps + d]] + 1 > levels[i])
+                levels[i] = levels[program->deps[statement->deps + d]] + 1;
+        if (levels[i] + 1 > depth)
+            depth = levels[i] + 1;
+    }
+
+    /* It sorts the statements by level, keeping their order within a level */
+    if (!(starts = calloc(depth + 1, sizeof(uint32_t)))) {
+        printf("evaluate_parallel: The schedule of %u statements could not be allocated.\n", n);
+        exit(EXIT_FAILURE);
+    }
+    for (uint32_t i = 0; i < n; i++)
+        starts[levels[i] + 1]++;
+    for (uint32_t l = 0; l < depth; l++)
+        starts[l + 1] += starts[l];
+    for (uint32_t i = 0; i < n; i++)
+        order[starts[levels[i]]++] = i;
+
+    /* The starts now hold the end of each level */
+    for (uint32_t l = 0, begin = 0; l < depth; begin = starts[l++]) {
+        parallel.level = &order[begin];
+        parallel.count = starts[l] - begin;
+
+        /* It checks if the level is worth sharing among the workers */
+        if (pool->nworkers > 1 && parallel.count > 1) {
+            parallel.grain = parallel.count / (pool->nworkers * PARALLEL_TASKS) + 1;
+            pool_run(pool, (parallel.count + parallel.grain - 1) / parallel.grain, evaluate_task, &parallel);
+        } else {
+            parallel.grain = parallel.count;
+            evaluate_task(&parallel, 0, 0);
+        }
+    }
+
+    /* The variables keep the value of their last store */
+    for (uint32_t s = 0; s < program->nslots; s++)
+        if (program->stores[s] != AST_NONE)
+            vars[s] = parallel.t[program->stores[s]];
+
+    for (uint32_t i = 0; i < n; i++) {
+        const struct ast_statement *statement = &program->statements[i];
+        if (statement->output != AST_NONE)
+            vars[program->nslots + statement->output] = parallel.t[statement->node];
+    }
+
+    free(levels);
+    free(order);
+    free(starts);
+
+    return program->nresults ? parallel.t[program->result] : NAN;
+}
@@ -0,0 +1,63 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Ricardo Fares
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include "../ast/ast.h"
+#include "../util/pool.h"
+
+/* Function Declaration */
+
+/**
+ * It evaluates the statements of the specified program on the workers
+ * of the specified pool, running at a time the statements whose
+ * dependencies have already been evaluated.
+ * <p>
+ * The statements are grouped into levels, the level of a statement
+ * being one past the deepest level of its dependencies, such that the
+ * statements of a level are independent and run concurrently, whereas
+ * the levels run in order. Hence, a program of many independent results
+ * scales with the workers, whereas a chain of definitions runs as the
+ * sequential evaluation does.
+ * <p>
+ * The frame is the same as the one of <em>evaluate</em>, which it
+ * leaves the same as <em>evaluate</em> does, that is, the variables
+ * hold their last stored values and the results follow them. The
+ * stores write the variables only after every statement has run, since
+ * the loads read the values of the stores they refer to.
+ * <p>
+ * If there is not enough memory to schedule the statements, then the
+ * application is immediately terminated.
+ *
+ * @param program the program to be evaluated
+ * @param vars    the evaluation frame
+ * @param pool    the pool evaluating the statements
+ *
+ * @return the value of the last program result, or NaN if the program
+ *         has no result
+ */
+double
+evaluate_parallel(const struct program *program, double *vars, struct pool *pool);
+
+#endif // PARALLEL_H
@@ -0,0 +1,509 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Ricardo Fares
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "./jit.h"
+
+#if defined(__x86_64__) && defined(__unix__)
+
+#include <math.h>
+#include <sys/mman.h>
+
+#include "../eval/eval.h"
+
+/**
+ * The maximum size of the native stack frame of a compiled program.
+ * Larger programs are left to the interpreters.
+ */
+#define JIT_MAX_FRAME (256 * 1024)
+
+/**
+ * Registers definition.
+ */
+#define REG_XMM0 (0x0)
+#define REG_XMM1 (0x1)
+#define REG_RBX  (0x3)
+#define REG_RSP  (0x4)
+
+/**
+ * Scalar double SSE2 opcodes definition, all prefixed by F2 0F.
+ */
+#define SSE_MOVSD_LOAD  (0x10)
+#define SSE_MOVSD_STORE (0x11)
+#define SSE_SQRTSD      (0x51)
+#define SSE_ADDSD       (0x58)
+#define SSE_MULSD       (0x59)
+#define SSE_SUBSD       (0x5C)
+#define SSE_DIVSD       (0x5E)
+
+/**
+ * A memory operand, that is, a base register plus a displacement.
+ */
+struct mem {
+    uint8_t base;
+    int32_t disp;
+};
+
+/**
+ * A machine code assembler.
+ * <p>
+ * The code is assembled to be placed right after the constant pool in
+ * the executable mapping, therefore, the constants are addressed
+ * relative to the instruction pointer.
+ */
+struct assembler {
+    uint8_t *code;
+    size_t   len;
+    size_t   capacity;
+    size_t   base;   /* offset of the code in the mapping */
+    uint32_t depth;  /* stack entries in the native frame */
+    uint32_t *local;  /* local index of each stored slot, or AST_NONE */
+    uint32_t  nlocals;
+    uint8_t  *stored; /* whether each slot has been stored so far */
+    int      sse41;
+};
+
+/**
+ * It appends the specified bytes to the code being assembled.
+ * <p>
+ * If there is not enough memory, then the application is immediately
+ * terminated.
+ *
+ * @param a     the assembler
+ * @param bytes the bytes
+ * @param n     the amount of bytes
+ */
+static void
+emit(struct assembler *a, const void *bytes, const size_t n) {
+    if (a->len + n > a->capacity) {
+        while (a->len + n > a->capacity)
+            a->capacity = a->capacity ? a->capacity << 1 : 256;
+        if (!(a->code = realloc(a->code, a->capacity))) {
+            printf("The machine code could not allocate %zu bytes.\n", a->capacity);
+            exit(EXIT_FAILURE);
+        }
+    }
+    memcpy(a->code + a->len, bytes, n);
+    a->len += n;
+}
+
+/**
+ * It appends the specified byte to the code being assembled.
+ *
+ * @param a    the assembler
+ * @param byte the byte
+ */
+static void
+emit8(struct assembler *a, const uint8_t byte) {
+    emit(a, &byte, 1);
+}
+
+/**
+ * It appends the specified 32-bit little-endian word to the code
+ * being assembled.
+ *
+ * @param a    the assembler
+ * @param word the word
+ */
+static void
+emit32(struct assembler *a, const uint32_t word) {
+    const uint8_t bytes[4] = { word, word >> 8, word >> 16, word >> 24 };
+    emit(a, bytes, 4);
+}
+
+/**
+ * It appends the ModRM byte, and the SIB byte and the displacement
+ * if any, encoding the specified register and memory operand.
+ *
+ * @param a   the assembler
+ * @param reg the register operand
+ * @param m   the memory operand
+ */
+static void
+emit_modrm(struct assembler *a, const uint8_t reg, const struct mem m) {
+    const int short_disp = m.disp >= -128 && m.disp <= 127;
+
+    emit8(a, (short_disp ? 0x40 : 0x80) | reg << 3 | m.base);
+    if (m.base == REG_RSP)
+        emit8(a, 0x24); /* SIB: base rsp, no index */
+    if (short_disp)
+        emit8(a, (uint8_t)m.disp);
+    else emit32(a, (uint32_t)m.disp);
+}
+
+/**
+ * It assembles a scalar double instruction between the specified
+ * register and memory operand.
+ *
+ * @param a   the assembler
+ * @param op  the instruction opcode
+ * @param reg the register operand
+ * @param m   the memory operand
+ */
+static void
+sse_mem(struct assembler *a, const uint8_t op, const uint8_t reg, const struct mem m) {
+    const uint8_t prefix[3] = { 0xF2, 0x0F, op };
+    emit(a, prefix, 3);
+    emit_modrm(a, reg, m);
+}
+
+/**
+ * It assembles a scalar double instruction between the specified
+ * register and the specified constant of the pool.
+ *
+ * @param a   the assembler
+ * @param op  the instruction opcode
+ * @param reg the register operand
+ * @param k   the index of the constant in the pool
+ */
+static void
+sse_const(struct assembler *a, const uint8_t op, const uint8_t reg, const uint32_t k) {
+    const uint8_t prefix[4] = { 0xF2, 0x0F, op, 0x05 | reg << 3 }; /* [rip + disp32] */
+    emit(a, prefix, 4);
+    /* The displacement is relative to the end of the instruction */
+    emit32(a, (uint32_t)((int64_t)k * 8 - (int64_t)(a->base + a->len + 4)));
+}
+
+/**
+ * It assembles a scalar double instruction between the specified
+ * registers.
+ *
+ * @param a   the assembler
+ * @param op  the instruction opcode
+ * @param dst the destination register
+ * @param src the source register
+ */
+static void
+sse_reg(struct assembler *a, const uint8_t op, const uint8_t dst, const uint8_t src) {
+    const uint8_t bytes[4] = { 0xF2, 0x0F, op, 0xC0 | dst << 3 | src };
+    emit(a, bytes, 4);
+}
+
+/**
+ * It assembles a call to the specified function, which receives and
+ * returns a double in xmm0.
+ *
+ * @param a  the assembler
+ * @param fn the function
+ */
+static void
+call(struct assembler *a, const void *fn) {
+    const uint64_t address = (uint64_t)(uintptr_t)fn;
+    const uint8_t  movabs[2] = { 0x48, 0xB8 };           /* mov rax, imm64 */
+    const uint8_t  callrax[2] = { 0xFF, 0xD0 };          /* call rax */
+
+    emit(a, movabs, 2);
+    emit32(a, (uint32_t)address);
+    emit32(a, (uint32_t)(address >> 32));
+    emit(a, callrax, 2);
+}
+
+/**
+ * It assembles the move of the top of the stack, cached in xmm0,
+ * to xmm1, and of the entry below it to xmm0.
+ *
+ * @param a   the assembler
+ * @param top the index of the top of the stack
+ */
+static void
+swap_operands(struct assembler *a, const uint32_t top) {
+    const uint8_t movapd[4] = { 0x66, 0x0F, 0x28, 0xC8 }; /* movapd xmm1, xmm0 */
+    emit(a, movapd, 4);
+    sse_mem(a, SSE_MOVSD_LOAD, REG_XMM0, (struct mem){ REG_RSP, (int32_t)(top - 1) * 8 });
+}
+
+/**
+ * It returns the memory operand of the stack entry with the specified
+ * index.
+ *
+ * @param index the index of the stack entry
+ *
+ * @return the memory operand of the stack entry
+ */
+static struct mem
+entry(const uint32_t index) {
+    return (struct mem){ REG_RSP, (int32_t)index * 8 };
+}
+
+/**
+ * It returns the memory operand of the variable in the specified slot.
+ * <p>
+ * The variables that have been stored by the program live in the native
+ * frame, since the variables passed to the compiled program are read-only,
+ * whereas the others are read from the variables.
+ *
+ * @param a    the assembler
+ * @param slot the variable slot
+ *
+ * @return the memory operand of the variable
+ */
+static struct mem
+variable(const struct assembler *a, const uint32_t slot) {
+    if (a->stored[slot])
+        return (struct mem){ REG_RSP, (int32_t)(a->depth + a->local[slot]) * 8 };
+    return (struct mem){ REG_RBX, (int32_t)slot * 8 };
+}
+
+/**
+ * It assigns a local in the native frame to each variable stored by
+ * the specified bytecode.
+ *
+ * @param a        the assembler
+ * @param bytecode the bytecode
+ */
+static void
+allocate_locals(struct assembler *a, const struct bytecode *bytecode) {
+    for (uint32_t i = 0; i < bytecode->len; i++) {
+        const uint32_t op = bytecode->code[i];
+
+        /* It checks if the instruction has an operand */
+        if (op == VM_CONST || op == VM_LOAD || op == VM_STORE || op >= VM_LOAD_ADD) {
+            const uint32_t operand = bytecode->code[++i];
+
+            if ((op == VM_STORE || op == VM_TEE) && a->local[operand] == AST_NONE)
+                a->local[operand] = a->nlocals++;
+        }
+    }
+}
+
+/**
+ * It assembles the specified bytecode.
+ * <p>
+ * The stack of the bytecode lives in the native frame, except for its
+ * top which is kept in xmm0. Hence, the math library calls take their
+ * argument and leave their result in place.
+ *
+ * @param a        the assembler
+ * @param bytecode the bytecode
+ * @param one      the index of the constant 1.0 in the pool
+ */
+static void
+assemble(struct assembler *a, const struct bytecode *bytecode, const uint32_t one) {
+    const uint8_t prologue[] = { 0x53, 0x48, 0x89, 0xFB, 0x48, 0x81, 0xEC }; /* push rbx; mov rbx, rdi; sub rsp, */
+    const uint8_t epilogue[] = { 0x48, 0x81, 0xC4 };                         /* add rsp, */
+    const uint8_t absolute[] = { 0x66, 0x48, 0x0F, 0x7E, 0xC0,               /* movq rax, xmm0 */
+                                 0x48, 0x0F, 0xBA, 0xF0, 0x3F,               /* btr rax, 63 */
+                                 0x66, 0x48, 0x0F, 0x6E, 0xC0 };             /* movq xmm0, rax */
+    const uint8_t invert[]   = { 0x66, 0x0F, 0x28, 0xC8 };                   /* movapd xmm1, xmm0 */
+    const uint32_t *pc       = bytecode->code;
+    uint32_t        sp       = 0; /* amount of entries in the stack */
+    uint32_t        frame;
+
+    /* The frame keeps rsp 16-byte aligned at the calls, since the */
+    /* return address and rbx have already been pushed */
+    frame = ((a->depth + a->nlocals) * 8 + 15) & ~15u;
+
+    emit(a, prologue, sizeof(prologue));
+    emit32(a, frame);
+
+    for (;;) {
+        const uint32_t op = *pc++;
+
+        /* It checks if the instruction pushes a value, which requires */
+        /* the current top of the stack to be spilled to the frame */
+        if ((op == VM_CONST || op == VM_LOAD) && sp > 0)
+            sse_mem(a, SSE_MOVSD_STORE, REG_XMM0, entry(sp - 1));
+
+        switch (op) {
+            case VM_CONST:
+                sse_const(a, SSE_MOVSD_LOAD, REG_XMM0, *pc++);
+                sp++;
+                break;
+            case VM_LOAD:
+                sse_mem(a, SSE_MOVSD_LOAD, REG_XMM0, variable(a, *pc++));
+                sp++;
+                break;
+            case VM_STORE: {
+                const uint32_t slot = *pc++;
+
+                a->stored[slot] = 1;
+
+                sse_mem(a, SSE_MOVSD_STORE, REG_XMM0, variable(a, slot));
+                if (--sp > 0)
+                    sse_mem(a, SSE_MOVSD_LOAD, REG_XMM0, entry(sp - 1));
+                break;
+            }
+            case VM_TEE: {
+                const uint32_t slot = *pc++;
+
+                a->stored[slot] = 1;
+
+                sse_mem(a, SSE_MOVSD_STORE, REG_XMM0, variable(a, slot));
+                break;
+            }
+            case VM_OUT:
+                /* The results are written to the caller frame */
+                sse_mem(a, SSE_MOVSD_STORE, REG_XMM0, (struct mem){ REG_RBX, (int32_t)*pc++ * 8 });
+                if (--sp > 0)
+                    sse_mem(a, SSE_MOVSD_LOAD, REG_XMM0, entry(sp - 1));
+                break;
+            case VM_ADD:
+                sse_mem(a, SSE_ADDSD, REG_XMM0, entry(--sp - 1));
+                break;
+            case VM_MUL:
+                sse_mem(a, SSE_MULSD, REG_XMM0, entry(--sp - 1));
+                break;
+            case VM_SUB:
+                swap_operands(a, --sp);
+                sse_reg(a, SSE_SUBSD, REG_XMM0, REG_XMM1);
+                break;
+            case VM_DIV:
+                swap_operands(a, --sp);
+                sse_reg(a, SSE_DIVSD, REG_XMM0, REG_XMM1);
+                break;
+            case VM_POW:
+                swap_operands(a, --sp);
+                call(a, (const void *)pow);
+                break;
+            case VM_LOAD_ADD: sse_mem(a, SSE_ADDSD, REG_XMM0, variable(a, *pc++)); break;
+            case VM_LOAD_SUB: sse_mem(a, SSE_SUBSD, REG_XMM0, variable(a, *pc++)); break;
+            case VM_LOAD_MUL: sse_mem(a, SSE_MULSD, REG_XMM0, variable(a, *pc++)); break;
+            case VM_LOAD_DIV: sse_mem(a, SSE_DIVSD, REG_XMM0, variable(a, *pc++)); break;
+            case VM_CONST_ADD: sse_const(a, SSE_ADDSD, REG_XMM0, *pc++); break;
+            case VM_CONST_SUB: sse_const(a, SSE_SUBSD, REG_XMM0, *pc++); break;
+            case VM_CONST_MUL: sse_const(a, SSE_MULSD, REG_XMM0, *pc++); break;
+            case VM_CONST_DIV: sse_const(a, SSE_DIVSD, REG_XMM0, *pc++); break;
+            case VM_ABS:
+                emit(a, absolute, sizeof(absolute));
+                break;
+            case VM_SQRT:
+                sse_reg(a, SSE_SQRTSD, REG_XMM0, REG_XMM0);
+                break;
+            case VM_FLOOR:
+            case VM_CEIL:
+                /* It checks if SSE4.1 rounding is available */
+                if (a->sse41) {
+                    const uint8_t roundsd[6] = { 0x66, 0x0F, 0x3A, 0x0B, 0xC0, op == VM_FLOOR ? 0x09 : 0x0A };
+                    emit(a, roundsd, sizeof(roundsd));
+                } else call(a, op == VM_FLOOR ? (const void *)floor : (const void *)ceil);
+                break;
+            case VM_FACT:  call(a, (const void *)factorial); break;
+            case VM_SIN:   call(a, (const void *)sin);       break;
+            case VM_COS:   call(a, (const void *)cos);       break;
+            case VM_TAN:   call(a, (const void *)tan);       break;
+            case VM_CBRT:  call(a, (const void *)cbrt);      break;
+            case VM_LOG10: call(a, (const void *)log10);     break;
+            case VM_LOG2:  call(a, (const void *)log2);      break;
+            case VM_CSC:
+            case VM_SEC:
+            case VM_COT:
+                call(a, op == VM_CSC ? (const void *)sin : op == VM_SEC ? (const void *)cos : (const void *)tan);
+                emit(a, invert, sizeof(invert));
+                sse_const(a, SSE_MOVSD_LOAD, REG_XMM0, one);
+                sse_reg(a, SSE_DIVSD, REG_XMM0, REG_XMM1);
+                break;
+            case VM_RET:
+                emit(a, epilogue, sizeof(epilogue));
+                emit32(a, frame);
+                emit8(a, 0x5B); /* pop rbx */
+                emit8(a, 0xC3); /* ret */
+                return;
+            default:
+                printf("assemble: Should not reach here!");
+                exit(EXIT_FAILURE);
+        }
+    }
+}
+
+struct jit *
+jit_compile(const struct bytecode *bytecode) {
+    struct assembler a    = { 0 };
+    struct jit      *jit;
+    const uint32_t   one  = bytecode->nconsts; /* the constant 1.0 follows the bytecode constants */
+    uint8_t         *map;
+
+    /* It checks if the native frame would be too large */
+    if (((size_t)bytecode->depth + bytecode->nslots) * 8 > JIT_MAX_FRAME)
+        return NULL;
+
+    if (!(a.local = malloc(sizeof(uint32_t) * (bytecode->nslots ? bytecode->nslots : 1))) ||
+        !(a.stored = calloc(bytecode->nslots ? bytecode->nslots : 1, sizeof(uint8_t))) ||
+        !(jit = malloc(sizeof(struct jit)))) {
+        printf("A compiled program could not be allocated.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    memset(a.local, 0xFF, sizeof(uint32_t) * bytecode->nslots);
+    a.base  = (((size_t)one + 1) * 8 + 15) & ~(size_t)15;
+    a.depth = bytecode->depth;
+    a.sse41 = __builtin_cpu_supports("sse4.1");
+
+    allocate_locals(&a, bytecode);
+    assemble(&a, bytecode, one);
+
+    free(a.local);
+    free(a.stored);
+
+    jit->len = a.base + a.len;
+    map      = mmap(NULL, jit->len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    /* It checks if the executable mapping could not be created */
+    if (map == MAP_FAILED) {
+        free(a.code);
+        free(jit);
+        return NULL;
+    }
+
+    memcpy(map, bytecode->consts, sizeof(double) * bytecode->nconsts);
+    memcpy(map + one * 8, &(double){ 1.0 }, sizeof(double));
+    memcpy(map + a.base, a.code, a.len);
+
+    free(a.code);
+
+    /* The mapping is never writable and executable at the same time */
+    if (mprotect(map, jit->len, PROT_READ | PROT_EXEC)) {
+        munmap(map, jit->len);
+        free(jit);
+        return NULL;
+    }
+
+    jit->map = map;
+    jit->fn  = (jit_fn)(void *)(map + a.base);
+
+    return jit;
+}
+
+void
+jit_free(struct jit *jit) {
+    munmap(jit->map, jit->len);
+    free(jit);
+}
+
+#else
+
+struct jit *
+jit_compile(const struct bytecode *bytecode) {
+    (void)bytecode;
+    return NULL;
+}
+
+void
+jit_free(struct jit *jit) {
+    free(jit);
+}
+
+#endif
@@ -0,0 +1,92 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Ricardo Fares
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef JIT_H
+#define JIT_H
+
+#include <stddef.h>
+
+#include "../vm/vm.h"
+
+/**
+ * A compiled native function.
+ * <p>
+ * It receives the frame of the program, whose variables are never
+ * written, and which receives the value of each result following the
+ * variables, and returns the value of the last program result.
+ */
+typedef double (*jit_fn)(double *vars);
+
+/* Structure Definitions */
+
+/**
+ * A natively compiled program.
+ */
+struct jit {
+    /**
+     * It represents the executable mapping holding the constants
+     * and the machine code.
+     */
+    void  *map;
+
+    /**
+     * It represents the mapping length.
+     */
+    size_t len;
+
+    /**
+     * It represents the entry point of the machine code.
+     */
+    jit_fn fn;
+};
+
+/* Function Declaration */
+
+/**
+ * It compiles the specified bytecode into x86-64 machine code.
+ * <p>
+ * The values are computed with scalar SSE2 instructions, except for
+ * the math functions that have no instruction, which are called
+ * from the C math library.
+ * <p>
+ * If the host is not a x86-64 System V host, or the program does not
+ * fit in the native stack frame, then NULL is returned and the caller
+ * is expected to fall back to an interpreter.
+ *
+ * @param bytecode the bytecode to be compiled
+ *
+ * @return the compiled program, which must be freed by the caller,
+ *         or NULL if the bytecode could not be compiled
+ */
+struct jit *
+jit_compile(const struct bytecode *bytecode);
+
+/**
+ * It frees the specified compiled program.
+ *
+ * @param jit the compiled program
+ */
+void
+jit_free(struct jit *jit);
+
+#endif // JIT_H
@@ -26,22 +26,10 @@
 #include <string.h>
 #include <ctype.h>
 #include <math.h>
+#include <stdint.h>
 
 #include "./lexer.h"
-
-/* Global Variables */
-
-/**
- * It stores the lexer structure that is used
- * to perform the lexical analysis in the buffer.
- */
-DEFINE_LEXER();
-
-/**
- * It stores the current token that has been
- * identified by the lexical analyzer.
- */
-DEFINE_CURRENT_TOKEN();
+#include "./powers.h"
 
 /* Function Declaration */
 
@@ -49,223 +37,604 @@ DEFINE_CURRENT_TOKEN();
  * It retrieves the next character to be analyzed from the buffer,
  * without incrementing the character position in the buffer.
  *
+ * @param lexer the lexer
+ *
  * @return the next character to be analyzed in the buffer without
  *         incrementing the character position
  */
 static char
-peek_char();
+peek_char(struct lexer *lexer);
 
 /**
  * It skips `n` characters from the buffer.
  *
- * @param n the amount of characters to be skipped
- *          in the buffer
+ * @param lexer the lexer
+ * @param n     the amount of characters to be skipped
+ *              in the buffer
  */
 static void
-skip(unsigned n);
+skip(struct lexer *lexer, unsigned n);
 
 /**
  * It marks the current character position in the buffer.
+ * <p>
+ * The characters before the marked position are no longer
+ * needed by the lexer and may be discarded by a refill.
+ *
+ * @param lexer the lexer
  */
 static void
-mark();
+mark(struct lexer *lexer);
 
 /**
- * It allocates a token structure containing the
- * specified token type.
+ * It refills the buffer with the next characters from the stream.
  * <p>
- * Further, if the token could not be allocated,
+ * The characters from the marked position onwards are moved to
+ * the beginning of the buffer, therefore, a token that spans a
+ * refill is kept contiguous in the buffer.
+ * <p>
+ * Further, if the token being analyzed does not fit in the buffer,
  * then the program is exited.
  *
- * @param type the token type
+ * @param lexer the lexer
+ *
+ * @return a non-zero value if at least one character has been
+ *         read from the stream, otherwise, zero
+ */
+static int
+refill(struct lexer *lexer);
+
+/**
+ * It counts the line breaks preceding the marked position of the
+ * specified lexer which have not been counted yet, that is, since
+ * the last refill or error.
  *
- * @return a token structure containing the
- *         specified token type
+ * @param lexer the lexer
+ */
+static void
+count_lines(struct lexer *lexer);
+
+/**
+ * It stores the specified token type into the token
+ * slot of the lexer.
+ *
+ * @param lexer the lexer
+ * @param type  the token type
+ *
+ * @return the token slot containing the specified
+ *         token type
  */
 static struct token *
-make_token(unsigned type);
+make_token(struct lexer *lexer, unsigned type);
 
 /**
  * It returns the next number identified from the
  * buffer.
  *
+ * @param lexer the lexer
+ *
  * @return the next number from the buffer
  */
 static struct token *
-next_number();
+next_number(struct lexer *lexer);
+
+/**
+ * It returns the double nearest to the specified significand
+ * times ten to the specified power, ties to even.
+ * <p>
+ * <b>Implementation Notes:</b>
+ * This function implements the Eisel-Lemire algorithm: the
+ * significand, shifted to its highest bit, is multiplied by
+ * the 128-bit power of five, whose product is exact enough
+ * to be rounded to the 53 bits of a double, whereas the power
+ * of two is worked out from the decimal exponent.
+ *
+ * @param w the significand, of at most 19 digits
+ * @param q the decimal exponent
+ *
+ * @return the double nearest to the number
+ */
+static double
+nearest_double(uint64_t w, int64_t q);
+
+/**
+ * It returns the double nearest to the specified number, ties
+ * to even, when its significand has too many digits to be
+ * rounded by <em>nearest_double</em>.
+ * <p>
+ * The number is copied as its significant digits followed by
+ * its exponent, without a decimal point, hence, it is parsed
+ * by <em>strtod</em> regardless of the locale. The digits
+ * beyond LEXER_NUMBER_DIGITS only tell whether the number is
+ * above its first digits, which is enough to round it.
+ *
+ * @param number    the number, as the lexer has read it
+ * @param numberlen the number length
+ *
+ * @return the double nearest to the number
+ */
+static double
+nearest_double_slow(const char *number, size_t numberlen);
 
 /**
  * It returns the next identifier, math constant
  * or the next math function identified from the buffer.
  *
+ * @param lexer the lexer
+ *
  * @return the next identifier, math constant or
  *         math function from the buffer
  */
 static struct token *
-next_name();
+next_name(struct lexer *lexer);
+
+/**
+ * It returns the token type of the keyword or the math constant
+ * matching the specified name, or <em>LEXER_TOKEN_ID</em> if the
+ * name is a user identifier.
+ * <p>
+ * If the name is a math constant, then <em>LEXER_TOKEN_NUMBER</em>
+ * is returned and the constant value is placed in the specified
+ * <em>value</em>.
+ *
+ * @param id    the name, not necessarily null-terminated
+ * @param idlen the name length
+ * @param value the placeholder for the math constant value
+ *
+ * @return the token type of the name
+ */
+static unsigned
+keyword(const char *id, size_t idlen, double *value);
 
 /**
  * It returns a number token containing the specified
  * value.
  *
+ * @param lexer the lexer
  * @param value the value
  *
  * @return a number token containing the specified value
  */
 static struct token *
-make_number(double value);
+make_number(struct lexer *lexer, double value);
 
 /**
- * It skips all characters until find a newline.
+ * It skips all characters until find a newline or the
+ * end of the stream.
+ *
+ * @param lexer the lexer
  */
 static void
-skip_line();
+skip_line(struct lexer *lexer);
 
 /* Function Definition */
 
 void
-init_lexer(FILE *stream) {
+init_lexer(struct lexer *lexer, FILE *stream) {
     /* It checks if a stream has been specified */
     if (!stream)
         LEXER_ERROR("A stream must be specified to initialize the lexer.\n");
 
-    lexer.buf    = (char *)calloc(LEXER_INPUT_BUFLEN, sizeof(char));
-    lexer.buflen = LEXER_INPUT_BUFLEN;
-    lexer.pos    = 0;
-    lexer.mark   = 0;
+    /* The buffer allocated by a previous initialization is reused */
+    if (!lexer->storage) {
+        lexer->storage = (char *)malloc(sizeof(char) * LEXER_INPUT_BUFLEN);
+        lexer->allocations++;
+    }
+
+    lexer->buf         = lexer->storage;
+    lexer->buflen      = LEXER_INPUT_BUFLEN;
+    lexer->len         = 0;
+    lexer->pos         = 0;
+    lexer->mark        = 0;
+    lexer->stream      = stream;
+    lexer->consumed    = 0;
+    lexer->lines       = 0;
+    lexer->linestart   = 0;
+    lexer->counted     = 0;
 
     /* It checks if a buffer could not be allocated for the lexer */
-    if (!lexer.buf)
+    if (!lexer->buf)
         LEXER_ERROR("A buffer could not be allocated for the lexer.\n");
 
-    /* It reads the contents from the specified stream to the lexer buffer */
-    fread(lexer.buf, sizeof(char), LEXER_INPUT_BUFLEN, stream);
+    if (!lexer->symbols)
+        lexer->symbols = intern_new();
+}
+
+void
+init_lexer_buffer(struct lexer *lexer, const char *buf, const size_t len) {
+    /* The buffer is never written since there is no stream to refill it from */
+    lexer->buf         = (char *)buf;
+    lexer->buflen      = len;
+    lexer->len         = len;
+    lexer->pos         = 0;
+    lexer->mark        = 0;
+    lexer->stream      = NULL;
+    lexer->consumed    = 0;
+    lexer->lines       = 0;
+    lexer->linestart   = 0;
+    lexer->counted     = 0;
+
+    if (!lexer->symbols)
+        lexer->symbols = intern_new();
 }
 
+_Noreturn void
+lexer_fail(struct lexer *lexer, const unsigned code) {
+    struct analysis_error *error = &lexer->error;
 
-struct token *
-next_token() {
-    /* It skips the blank spaces */
-    while (peek_char() == ' ') skip(1);
+    error->code      = code;
+    error->statement = 0;
+    error->message[strcspn(error->message, "\n")] = '\0';
 
-    /* LF files */
-    if (peek_char() == '\n') skip(1);
+    /* The line breaks preceding the token are only counted now */
+    count_lines(lexer);
+    error->line   = lexer->lines + 1;
+    error->column = lexer->consumed + lexer->mark - lexer->linestart + 1;
 
-    /* It returns the `EOF` token */
-    if (peek_char() == '\0') return make_token(LEXER_TOKEN_EOF);
+    longjmp(*lexer->recovery, 1);
+}
 
-    /* It skips one or more line comments */
-    while (peek_char() == '#')
-        skip_line();
+void
+lexer_free(struct lexer *lexer) {
+    free(lexer->storage);
+
+    if (lexer->symbols)
+        intern_free(lexer->symbols);
 
-    /* It peeks the next character to be analyzed */
-    const char c = peek_char();
+    lexer->storage = NULL;
+    lexer->symbols = NULL;
+}
+
+struct token *
+next_token(struct lexer *lexer) {
+    char c;
+
+    /* It skips the blank spaces, the line breaks and the line comments */
+    for (;;) {
+        mark(lexer);
+
+        c = peek_char(lexer);
+        if (c == ' ' || c == '\t' || c == '\r' || c == '\n')
+            skip(lexer, 1);
+        else if (c == '#')
+            skip_line(lexer);
+        else break;
+    }
+
+    /* It returns the `EOF` token */
+    if (c == '\0') return make_token(lexer, LEXER_TOKEN_EOF);
 
     /* It checks if the peeked character is a digit */
     /* Therefore, it tries to get the next number */
     if (isdigit(c))
-        return next_number();
+        return next_number(lexer);
 
     /* It checks if the peeked character is a character */
     /* Therefore, it tries to get the next identifier or */
     /* a mathematical constant */
     if (isalpha(c))
-        return next_name();
+        return next_name(lexer);
 
     switch (c) {
-        case '+': { skip(1); return make_token(LEXER_TOKEN_PLUS);  }
-        case '-': { skip(1); return make_token(LEXER_TOKEN_MINUS); }
+        case '+': { skip(lexer, 1); return make_token(lexer, LEXER_TOKEN_PLUS);  }
+        case '-': { skip(lexer, 1); return make_token(lexer, LEXER_TOKEN_MINUS); }
         case '*': {
-            skip(1);
+            skip(lexer, 1);
 
             /* It checks if the input matches the `**` */
-            if (peek_char() == '*') { skip(1); return make_token(LEXER_TOKEN_POW); }
+            if (peek_char(lexer) == '*') { skip(lexer, 1); return make_token(lexer, LEXER_TOKEN_POW); }
 
-            return make_token(LEXER_TOKEN_MULTIPLY);
+            return make_token(lexer, LEXER_TOKEN_MULTIPLY);
         }
-        case '/': { skip(1); return make_token(LEXER_TOKEN_DIVIDE);    }
-        case '(': { skip(1); return make_token(LEXER_TOKEN_LPAREN);    }
-        case ')': { skip(1); return make_token(LEXER_TOKEN_RPAREN);    }
-        case '[': { skip(1); return make_token(LEXER_TOKEN_LBRACKET);  }
-        case ']': { skip(1); return make_token(LEXER_TOKEN_RBRACKET);  }
-        case '|': { skip(1); return make_token(LEXER_TOKEN_PIPE);      }
-        case '=': { skip(1); return make_token(LEXER_TOKEN_EQUALS);    }
-        case '$': { skip(1); return make_token(LEXER_TOKEN_DOLLAR);    }
-        case ';': { skip(1); return make_token(LEXER_TOKEN_SEMICOLON); }
-        case ':': { skip(1); return make_token(LEXER_TOKEN_COLON); }
-        default: LEXER_ERROR("Unexpected character (%c).\n", c);
+        case '/': { skip(lexer, 1); return make_token(lexer, LEXER_TOKEN_DIVIDE);    }
+        case '(': { skip(lexer, 1); return make_token(lexer, LEXER_TOKEN_LPAREN);    }
+        case ')': { skip(lexer, 1); return make_token(lexer, LEXER_TOKEN_RPAREN);    }
+        case '[': { skip(lexer, 1); return make_token(lexer, LEXER_TOKEN_LBRACKET);  }
+        case ']': { skip(lexer, 1); return make_token(lexer, LEXER_TOKEN_RBRACKET);  }
+        case '|': { skip(lexer, 1); return make_token(lexer, LEXER_TOKEN_PIPE);      }
+        case '=': { skip(lexer, 1); return make_token(lexer, LEXER_TOKEN_EQUALS);    }
+        case '$': { skip(lexer, 1); return make_token(lexer, LEXER_TOKEN_DOLLAR);    }
+        case ';': { skip(lexer, 1); return make_token(lexer, LEXER_TOKEN_SEMICOLON); }
+        case ':': { skip(lexer, 1); return make_token(lexer, LEXER_TOKEN_COLON); }
+        default:
+            /* The character is skipped, such that the analysis may resume after it */
+            skip(lexer, 1);
+            LEXER_ERROR("Unexpected character (%c).\n", c);
     }
 }
 
 /* Static Function Declaration */
 
 inline static char
-peek_char() {
-    return lexer.buf[lexer.pos];
+peek_char(struct lexer *lexer) {
+    /* It checks if every character in the buffer has been analyzed */
+    /* If so, then the buffer is refilled from the stream */
+    if (lexer->pos == lexer->len && !refill(lexer))
+        return '\0';
+
+    return lexer->buf[lexer->pos];
 }
 
 inline static void
-skip(const unsigned n) {
-    lexer.pos += n;
+skip(struct lexer *lexer, const unsigned n) {
+    lexer->pos += n;
 }
 
 inline static void
-mark() {
-    lexer.mark = lexer.pos;
+mark(struct lexer *lexer) {
+    lexer->mark = lexer->pos;
 }
 
-static struct token *
-make_token(unsigned type) {
-    struct token *token = (struct token *)malloc(sizeof(struct token));
+static void
+count_lines(struct lexer *lexer) {
+    const char *const end = lexer->buf + lexer->mark;
+    const char       *p   = lexer->buf;
 
-    /* It checks if a token could not be allocated */
-    if (!token)
-        LEXER_ERROR("A token structure for type (%u) could not be allocated.\n", type);
+    /* The characters already counted are skipped */
+    if (lexer->counted > lexer->consumed)
+        p += lexer->counted - lexer->consumed;
 
-    token->type = type;
+    for (; p < end && (p = memchr(p, '\n', (size_t)(end - p))); p++) {
+        lexer->lines++;
+        lexer->linestart = lexer->consumed + (size_t)(p - lexer->buf) + 1;
+    }
 
-    return token;
+    if (lexer->counted < lexer->consumed + lexer->mark)
+        lexer->counted = lexer->consumed + lexer->mark;
 }
 
-static struct token *
-next_number() {
-    struct token *token;
-    char         *number;
-    unsigned      numberlen;
+static int
+refill(struct lexer *lexer) {
+    size_t keep;
+    size_t nread;
+
+    /* It checks if the stream has already been exhausted */
+    if (!lexer->stream)
+        return 0;
+
+    keep = lexer->len - lexer->mark;
+
+    /* It checks if the token being analyzed fills the entire buffer */
+    /* If so, it is dropped, such that the analysis may resume after it */
+    if (keep == lexer->buflen) {
+        lexer->mark = lexer->pos;
+        LEXER_ERROR("A token longer than %zu characters could not be analyzed.\n", lexer->buflen);
+    }
 
-    mark();
+    /* It counts the line breaks being discarded, for the position of an error */
+    count_lines(lexer);
 
-    /* It is reading the digits */
-    while (isdigit(peek_char())) skip(1);
+    /* It slides the characters from the mark to the beginning of the buffer */
+    memmove(lexer->buf, lexer->buf + lexer->mark, keep);
+
+    lexer->consumed += lexer->mark;
+    lexer->pos      -= lexer->mark;
+    lexer->mark      = 0;
+    lexer->len       = keep;
+
+    nread      = fread(lexer->buf + keep, sizeof(char), lexer->buflen - keep, lexer->stream);
+    lexer->len += nread;
+
+    /* It checks if the end of the stream has been reached */
+    if (0 == nread) {
+        lexer->stream = NULL;
+        return 0;
+    }
+
+    return 1;
+}
+
+inline static struct token *
+make_token(struct lexer *lexer, unsigned type) {
+    lexer->token.type = type;
+
+    return &lexer->token;
+}
+
+static struct token *
+next_number(struct lexer *lexer) {
+    uint64_t      w         = 0; /* the first 19 significant digits */
+    int           digits    = 0;
+    int           truncated = 0; /* whether a dropped digit is not zero */
+    int64_t       q         = 0; /* the decimal exponent of the significand */
+    int64_t       exponent  = 0;
+    int           negative  = 0;
+    size_t        back;
+    unsigned      d;
+    double        value;
+
+    mark(lexer);
+
+    /* It is reading the digits, of which the ones beyond the */
+    /* significand only scale it */
+    while (isdigit(peek_char(lexer))) {
+        d = (unsigned)(lexer->buf[lexer->pos] - '0');
+        if (digits < 19) {
+            if ((w = w * 10 + d)) digits++;
+        } else {
+            truncated |= d != 0;
+            q++;
+        }
+        skip(lexer, 1);
+    }
 
     /* It has been found a `dot` for a floating-point number */
-    if (peek_char() == '.') {
+    if (peek_char(lexer) == '.') {
         /* It skips the dot */
-        skip(1);
+        skip(lexer, 1);
 
         /* It is reading the digits after the dot */
-        while (isdigit(peek_char())) skip(1);
+        while (isdigit(peek_char(lexer))) {
+            d = (unsigned)(lexer->buf[lexer->pos] - '0');
+            if (digits < 19) {
+                if ((w = w * 10 + d)) digits++;
+                q--;
+            } else truncated |= d != 0;
+            skip(lexer, 1);
+        }
     }
 
-    numberlen = lexer.pos - lexer.mark + 1; /* number length */
-    number    = (char *)malloc(sizeof(char) * numberlen);
-    token     = make_token(LEXER_TOKEN_NUMBER);
+    /* It has been found an `e` for the scientific notation, which is */
+    /* only an exponent if a digit follows it, e.g., `2e` is `2 * e` */
+    if (peek_char(lexer) == 'e' || peek_char(lexer) == 'E') {
+        back = lexer->pos - lexer->mark;
+        skip(lexer, 1);
 
-    /* It checks if the number buffer could not be allocated */
-    if (!number)
-        LEXER_ERROR("A temporary buffer for the lexical analysis of a number could not be allocated.\n");
+        if (peek_char(lexer) == '+' || peek_char(lexer) == '-') {
+            negative = lexer->buf[lexer->pos] == '-';
+            skip(lexer, 1);
+        }
 
-    memcpy(number, lexer.buf + lexer.mark, numberlen);
+        /* It checks if there is no exponent. If so, the `e` is left */
+        /* for the next token, wherever a refill has moved the mark */
+        if (!isdigit(peek_char(lexer)))
+            lexer->pos = lexer->mark + back;
 
-    /* It terminates the temporary string with \0 */
-    number[numberlen - 1] = '\0';
+        /* The exponents too large for any double are clamped */
+        while (isdigit(peek_char(lexer))) {
+            if (exponent < 1000000)
+                exponent = exponent * 10 + (lexer->buf[lexer->pos] - '0');
+            skip(lexer, 1);
+        }
+        q += negative ? -exponent : exponent;
+    }
 
-    token->metadata.value = atof(number); // NOLINT(cert-err34-c)
+    /* The significands which are exact doubles are only multiplied */
+    /* or divided by an exact power of ten, which is rounded once */
+    if (!truncated && w <= (UINT64_C(1) << 53) && q >= -22 && q <= 22) {
+        static const double exact[] = {
+            1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+            1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+        };
+        value = q < 0 ? (double)w / exact[-q] : (double)w * exact[q];
+    } else {
+        value = nearest_double(w, q);
+
+        /* The number is within the significands having its first digits */
+        /* and the next ones, hence, it is rounded if both round alike */
+        if (truncated && value != nearest_double(w + 1, q))
+            value = nearest_double_slow(lexer->buf + lexer->mark, lexer->pos - lexer->mark);
+    }
 
-    /* It frees the temporary buffer */
-    free(number);
+    return make_number(lexer, value);
+}
 
-    return token;
+static double
+nearest_double(uint64_t w, const int64_t q) {
+    unsigned __int128 product;
+    uint64_t          high, low, mantissa, bits;
+    const uint64_t   *power;
+    int               lz, upperbit, shift;
+    int64_t           power2;
+    double            value;
+
+    if (w == 0 || q < POWERS_MIN)
+        return 0.0;
+    if (q > POWERS_MAX)
+        return INFINITY;
+
+    lz    = __builtin_clzll(w);
+    w   <<= lz;
+    power = &powers_of_five[(q - POWERS_MIN) * 2];
+
+    /* The lowest 64 bits of the power only matter if the bits below */
+    /* the 55 highest ones of the product may carry into them */
+    product = (unsigned __int128)w * power[0];
+    high    = (uint64_t)(product >> 64);
+    low     = (uint64_t)product;
+    if ((high & 0x1FF) == 0x1FF) {
+        const uint64_t carry = (uint64_t)(((unsigned __int128)w * power[1]) >> 64);
+
+        low += carry;
+        if (low < carry) high++;
+    }
+
+    upperbit = (int)(high >> 63);
+    shift    = upperbit + 64 - 52 - 3;
+    mantissa = high >> shift;
+
+    /* It is the biased exponent, as floor(log2(10^q)) is (217706 * q) >> 16 */
+    power2 = ((217706 * q) >> 16) + 63 + upperbit - lz + 1023;
+
+    /* It checks if the number is subnormal */
+    if (power2 <= 0) {
+        if (-power2 + 1 >= 64)
+            return 0.0;
+
+        mantissa >>= -power2 + 1;
+        mantissa  += mantissa & 1;
+        mantissa >>= 1;
+        power2     = mantissa < (UINT64_C(1) << 52) ? 0 : 1;
+        bits       = (mantissa & ~(UINT64_C(1) << 52)) | (uint64_t)power2 << 52;
+        memcpy(&value, &bits, sizeof(double));
+        return value;
+    }
+
+    /* A product exactly halfway between two doubles is rounded to the */
+    /* even one, which only happens for the exact powers of five */
+    if (low <= 1 && q >= -4 && q <= 23 && (mantissa & 3) == 1 && (mantissa << shift) == high)
+        mantissa &= ~UINT64_C(1);
+
+    mantissa += mantissa & 1;
+    mantissa >>= 1;
+    if (mantissa >= (UINT64_C(2) << 52)) {
+        mantissa = UINT64_C(1) << 52;
+        power2++;
+    }
+
+    if (power2 >= 0x7FF)
+        return INFINITY;
+
+    bits = (mantissa & ~(UINT64_C(1) << 52)) | (uint64_t)power2 << 52;
+    memcpy(&value, &bits, sizeof(double));
+
+    return value;
+}
+
+static double
+nearest_double_slow(const char *number, const size_t numberlen) {
+    char    copy[LEXER_NUMBER_DIGITS + 32];
+    size_t  n        = 0;
+    int64_t q        = 0;
+    int     fraction = 0;
+    int     sticky   = 0;
+    size_t  i;
+
+    /* It copies the significant digits, scaling the exponent by */
+    /* the dropped digits of the integer part */
+    for (i = 0; i < numberlen && number[i] != 'e' && number[i] != 'E'; i++) {
+        if (number[i] == '.')
+            fraction = 1;
+        else if (n == 0 && number[i] == '0')
+            q -= fraction;
+        else if (n < LEXER_NUMBER_DIGITS) {
+            copy[n++] = number[i];
+            q -= fraction;
+        } else {
+            sticky |= number[i] != '0';
+            q += !fraction;
+        }
+    }
+
+    /* Another digit stands for the dropped ones */
+    if (sticky) {
+        copy[n++] = '1';
+        q--;
+    }
+
+    if (i < numberlen) {
+        const int negative = number[++i] == '-';
+        int64_t   exponent = 0;
+
+        for (i += number[i] == '+' || number[i] == '-'; i < numberlen; i++)
+            if (exponent < 1000000)
+                exponent = exponent * 10 + (number[i] - '0');
+        q += negative ? -exponent : exponent;
+    }
+
+    snprintf(copy + n, sizeof(copy) - n, "e%lld", (long long)q);
+
+    return strtod(copy, NULL);
 }
 
 /**
@@ -277,73 +646,118 @@ next_number() {
  * @return a token identifier
  */
 static struct token *
-next_name() {
+next_name(struct lexer *lexer) {
     struct token *token;
-    char         *id;
-    unsigned      idlen;
+    const char   *id;
+    size_t        idlen;
+    unsigned      type;
+    double        value;
 
-    mark();
+    mark(lexer);
 
     /* It is reading the characters and digits */
-    while (isalnum(peek_char())) skip(1);
-
-    idlen = lexer.pos - lexer.mark + 1; /* id length */
-    id    = (char *)malloc(sizeof(char) * idlen);
-
-    /* It checks if the identifier buffer could not be allocated */
-    if (!id)
-        LEXER_ERROR("A temporary buffer for the lexical analysis of an identifier could not be allocated.\n");
-
-    memcpy(id, lexer.buf + lexer.mark, idlen);
-
-    id[idlen - 1] = '\0';
-
-    if (0 == strcmp(id, "pi"))
-        return make_number(M_PI);
-    else if (0 == strcmp(id, "e"))
-        return make_number(M_E);
-    else if (0 == strcmp(id, "sin"))
-        return make_token(LEXER_TOKEN_FUNCTION_SIN);
-    else if (0 == strcmp(id, "cos"))
-        return make_token(LEXER_TOKEN_FUNCTION_COS);
-    else if (0 == strcmp(id, "tan"))
-        return make_token(LEXER_TOKEN_FUNCTION_TAN);
-    else if (0 == strcmp(id, "csc"))
-        return make_token(LEXER_TOKEN_FUNCTION_CSC);
-    else if (0 == strcmp(id, "sec"))
-        return make_token(LEXER_TOKEN_FUNCTION_SEC);
-    else if (0 == strcmp(id, "cot"))
-        return make_token(LEXER_TOKEN_FUNCTION_COT);
-    else if (0 == strcmp(id, "floor"))
-        return make_token(LEXER_TOKEN_FUNCTION_FLOOR);
-    else if (0 == strcmp(id, "ceil"))
-        return make_token(LEXER_TOKEN_FUNCTION_CEIL);
-    else if (0 == strcmp(id, "sqrt"))
-        return make_token(LEXER_TOKEN_FUNCTION_SQRT);
-    else if (0 == strcmp(id, "cbrt"))
-        return make_token(LEXER_TOKEN_FUNCTION_CBRT);
-    else if (0 == strcmp(id, "log10"))
-        return make_token(LEXER_TOKEN_FUNCTION_LOG10);
-    else if (0 == strcmp(id, "log2"))
-        return make_token(LEXER_TOKEN_FUNCTION_LOG2);
-    else {
-        token = make_token(LEXER_TOKEN_ID);
-        token->metadata.id = id;
-
-        return token;
+    while (isalnum(peek_char(lexer))) skip(lexer, 1);
+
+    id    = lexer->buf + lexer->mark;
+    idlen = lexer->pos - lexer->mark; /* id length */
+
+    switch (type = keyword(id, idlen, &value)) {
+        case LEXER_TOKEN_NUMBER:
+            return make_number(lexer, value);
+        case LEXER_TOKEN_ID:
+            token = make_token(lexer, LEXER_TOKEN_ID);
+            token->metadata.id = intern(lexer->symbols, id, idlen);
+
+            return token;
+        default:
+            return make_token(lexer, type);
     }
 }
 
+/**
+ * <b>Implementation Note: </b>
+ * The keywords are dispatched by their length and, then, by
+ * their first character. Therefore, an identifier is compared
+ * against at most three keywords, and most of the identifiers
+ * are not compared at all.
+ */
+static unsigned
+keyword(const char *id, const size_t idlen, double *value) {
+/* It checks if the characters after the first one match the specified keyword */
+#define REST_IS( KEYWORD ) (0 == memcmp(id + 1, KEYWORD + 1, sizeof(KEYWORD) - 2))
+
+    switch (idlen) {
+        case 1:
+            if (id[0] == 'e') { *value = M_E; return LEXER_TOKEN_NUMBER; }
+            break;
+        case 2:
+            if (id[0] == 'p' && REST_IS("pi")) { *value = M_PI; return LEXER_TOKEN_NUMBER; }
+            break;
+        case 3:
+            switch (id[0]) {
+                case 's':
+                    if (REST_IS("sin")) return LEXER_TOKEN_FUNCTION_SIN;
+                    if (REST_IS("sec")) return LEXER_TOKEN_FUNCTION_SEC;
+                    break;
+                case 'c':
+                    if (REST_IS("cos")) return LEXER_TOKEN_FUNCTION_COS;
+                    if (REST_IS("csc")) return LEXER_TOKEN_FUNCTION_CSC;
+                    if (REST_IS("cot")) return LEXER_TOKEN_FUNCTION_COT;
+                    break;
+                case 't':
+                    if (REST_IS("tan")) return LEXER_TOKEN_FUNCTION_TAN;
+                    break;
+            }
+            break;
+        case 4:
+            switch (id[0]) {
+                case 'c':
+                    if (REST_IS("ceil")) return LEXER_TOKEN_FUNCTION_CEIL;
+                    if (REST_IS("cbrt")) return LEXER_TOKEN_FUNCTION_CBRT;
+                    break;
+                case 's':
+                    if (REST_IS("sqrt")) return LEXER_TOKEN_FUNCTION_SQRT;
+                    break;
+                case 'l':
+                    if (REST_IS("log2")) return LEXER_TOKEN_FUNCTION_LOG2;
+                    break;
+            }
+            break;
+        case 5:
+            switch (id[0]) {
+                case 'f':
+                    if (REST_IS("floor")) return LEXER_TOKEN_FUNCTION_FLOOR;
+                    break;
+                case 'l':
+                    if (REST_IS("log10")) return LEXER_TOKEN_FUNCTION_LOG10;
+                    break;
+            }
+            break;
+    }
+
+    return LEXER_TOKEN_ID;
+
+#undef REST_IS
+}
+
 static struct token *
-make_number(double value) {
-    struct token *token   = make_token(LEXER_TOKEN_NUMBER);
+make_number(struct lexer *lexer, double value) {
+    struct token *token   = make_token(lexer, LEXER_TOKEN_NUMBER);
     token->metadata.value = value;
 
     return token;
 }
 
 inline static void
-skip_line() {
-    while (peek_char() != '\n') skip(1);
-    skip(1); /* Skip the '\n' */
+skip_line(struct lexer *lexer) {
+    char c;
+
+    /* The comment characters are marked as they are skipped, therefore, */
+    /* a comment longer than the buffer does not need to fit in it */
+    while ((c = peek_char(lexer)) != '\n' && c != '\0') {
+        skip(lexer, 1);
+        mark(lexer);
+    }
+
+    if (c == '\n') skip(lexer, 1); /* Skip the '\n' */
 }
@@ -24,27 +24,74 @@
 #ifndef LEXER_H
 #define LEXER_H
 
+#include <stddef.h>
 #include <stdio.h>
+#include <setjmp.h>
+
+#include "../util/intern.h"
+
+/**
+ * Analysis error codes definition.
+ */
+#define ANALYSIS_LEXICAL  (0x1)
+#define ANALYSIS_SYNTAX   (0x2)
+#define ANALYSIS_SEMANTIC (0x3)
+
+/**
+ * It reports an error of the analysis of the input.
+ * <p>
+ * If the lexer has a recovery point, then the error is
+ * written into the lexer error, along with its position,
+ * and the analysis returns to the recovery point.
+ * Otherwise, the message is printed out to the standard
+ * output and the program is exited.
+ *
+ * @param lexer   the lexer analyzing the input
+ * @param code    the analysis error code
+ * @param message the message describing the error
+ */
+#define ANALYSIS_ERROR( LEXER, CODE, MESSAGE, ... ) do {                                    \
+                                if ((LEXER)->recovery) {                                    \
+                                    snprintf((LEXER)->error.message,                        \
+                                             sizeof((LEXER)->error.message),                \
+                                             MESSAGE, ##__VA_ARGS__);                       \
+                                    lexer_fail(LEXER, CODE);                                \
+                                }                                                           \
+                                printf(MESSAGE, ##__VA_ARGS__);                             \
+                                exit(EXIT_FAILURE);                                         \
+                               } while (0)
 
 /**
  * It prints a message to the standard output indicating
  * an error at the lexer phase has occurred.
  * <p>
  * Further, after the message printing the program is
- * exited.
+ * exited, unless the lexer has a recovery point. The
+ * current token becomes an error token, such that the
+ * analysis may resume by skipping it.
+ * <p>
+ * It is used by the lexer functions, which name their
+ * lexer <em>lexer</em>.
  *
  * @param message the message to be printed out to the
  *                standard output
  */
-#define LEXER_ERROR( MESSAGE, ... ) do {                                  \
-                                printf("lexer: " MESSAGE, ##__VA_ARGS__); \
-                                exit(EXIT_FAILURE);                       \
+#define LEXER_ERROR( MESSAGE, ... ) do {                                                    \
+                                lexer->token.type = LEXER_TOKEN_ERROR;                      \
+                                ANALYSIS_ERROR(lexer, ANALYSIS_LEXICAL, "lexer: " MESSAGE,  \
+                                               ##__VA_ARGS__);                              \
                                } while (0)
 
 /**
  * Lexer constants definition.
+ * <p>
+ * The input buffer is a sliding window over the stream, therefore,
+ * its length bounds the length of a single token but not the length
+ * of the input. A number is rounded from its first LEXER_NUMBER_DIGITS
+ * significant digits, which is as many as any double may need.
  */
-#define LEXER_INPUT_BUFLEN (256)
+#define LEXER_INPUT_BUFLEN  (64 * 1024)
+#define LEXER_NUMBER_DIGITS (768)
 
 /**
  * Lexer tokens definition.
@@ -78,17 +125,46 @@
 #define LEXER_TOKEN_FUNCTION_CBRT    (0x1A)
 #define LEXER_TOKEN_FUNCTION_LOG10   (0x1B)
 #define LEXER_TOKEN_FUNCTION_LOG2    (0x1C)
+#define LEXER_TOKEN_ERROR            (0x1D)
 
-#define DEFINE_LEXER() struct lexer lexer;
-#define DEFINE_CURRENT_TOKEN() struct token *curr_token;
+/* Structure Definitions */
 
-#define TOKEN_TYPE()  (curr_token->type)
-#define TOKEN_VALUE() (curr_token->metadata.value)
-#define TOKEN_ID()    (curr_token->metadata.id)
-#define NEXT_TOKEN()  (curr_token = next_token())
+/**
+ * An error of the analysis of the input.
+ * <p>
+ * Its position is only worked out when the error is reported,
+ * hence, the analysis of a valid input does not pay for it.
+ */
+struct analysis_error {
+    unsigned           code;         /* the analysis error code */
+    unsigned long long line;         /* the line of the error, from 1 */
+    unsigned long long column;       /* the column of the error, from 1 */
+    unsigned           statement;    /* the statement of the error, from 0 */
+    char               message[256]; /* the message, without a line break */
+};
 
-/* Structure Definitions */
+struct token {
+    /**
+     * It stores the token type.
+     */
+    unsigned type;
 
+    /**
+     * It stores the token metadata.
+     */
+    union {
+        unsigned id;
+        double   value;
+    } metadata;
+};
+
+/**
+ * It represents the state of a lexical analysis.
+ * <p>
+ * The lexer does not share any state with the other lexers,
+ * therefore, distinct lexers may be used by distinct threads.
+ * A lexer must be zeroed before its first initialization.
+ */
 struct lexer {
     /**
      * It represents the buffer to store the characters
@@ -99,7 +175,13 @@ struct lexer {
     /**
      * It represents the buffer length.
      */
-    unsigned  buflen;
+    size_t    buflen;
+
+    /**
+     * It represents the amount of characters currently
+     * loaded into the buffer.
+     */
+    size_t    len;
 
     /**
      * It represents the position of the current character
@@ -108,7 +190,7 @@ struct lexer {
      * It is recommended not to change this variable directly,
      * only by the functions provided for the lexical analysis.
      */
-    unsigned pos;
+    size_t   pos;
 
     /**
      * It represents a cache for the position of the current
@@ -117,39 +199,152 @@ struct lexer {
      * It is recomended not to change this variable directly,
      * only by the functions provided for the lexical analysis.
      */
-    unsigned mark;
-};
+    size_t   mark;
 
-struct token {
     /**
-     * It stores the token type.
+     * It represents the stream from which the buffer is
+     * refilled, or NULL if the stream has been exhausted.
      */
-    unsigned type;
+    FILE    *stream;
 
     /**
-     * It stores the token metadata.
+     * It represents the amount of line breaks preceding the first
+     * <em>counted</em> characters of the input, and the amount of
+     * characters preceding the line of the last of them.
+     * <p>
+     * They are counted as the refills discard the characters and as
+     * the errors are found, hence, each error only counts the line
+     * breaks since the previous one. They are only needed to work
+     * out the position of an error.
      */
-    union {
-        char  *id;
-        double value;
-    } metadata;
+    unsigned long long lines;
+    unsigned long long linestart;
+    unsigned long long counted;
+
+    /**
+     * It represents the buffer allocated by the lexer to read
+     * a stream, or NULL if no stream has been read yet. It is
+     * reused by the next initializations from a stream.
+     */
+    char    *storage;
+
+    /**
+     * It represents the amount of characters that have been
+     * discarded from the beginning of the buffer by the refills.
+     * <p>
+     * Therefore, the amount of characters analyzed so far is
+     * given by <em>consumed + pos</em>.
+     */
+    unsigned long long consumed;
+
+    /**
+     * It represents the slot in which the current token is
+     * stored.
+     * <p>
+     * Since the grammar needs a single token of lookahead,
+     * the slot is reused by every call to <em>next_token</em>,
+     * hence, the token contents must be copied out before the
+     * next token is retrieved.
+     */
+    struct token token;
+
+    /**
+     * It represents the pool in which the identifiers are
+     * interned. The identifier tokens carry the symbol
+     * identifier assigned by this pool.
+     * <p>
+     * The pool is kept across initializations of the lexer,
+     * therefore, a symbol identifier is stable for the whole
+     * lifetime of the lexer.
+     */
+    struct intern_pool *symbols;
+
+    /**
+     * It represents the amount of memory allocations that
+     * have been performed by the lexer.
+     */
+    unsigned long long allocations;
+
+    /**
+     * It represents the point to which the analysis returns
+     * on an error, or NULL if the errors exit the program.
+     * <p>
+     * It is set by the callers analyzing untrusted input,
+     * e.g., a server, which must outlive a malformed input.
+     */
+    jmp_buf *recovery;
+
+    /**
+     * It represents the last error which has returned to the
+     * recovery point.
+     */
+    struct analysis_error error;
 };
 
 /**
  * It retrieves the next token from the buffer.
+ * <p>
+ * The returned token is owned by the lexer and it is
+ * overwritten by the next call to this function.
+ *
+ * @param lexer the lexer
  *
  * @return the next token from the buffer
  */
 struct token *
-next_token();
+next_token(struct lexer *lexer);
 
 /**
  * It initializes the lexer loading from the specified
  * stream the characters that will be lexical analyzed.
+ * <p>
+ * The stream is read incrementally as the lexical analysis
+ * advances, hence, the memory used by the lexer does not
+ * depend on the stream length.
  *
+ * @param lexer  the lexer
  * @param stream the stream to be analyzed by the lexer
  */
 void
-init_lexer(FILE *stream);
+init_lexer(struct lexer *lexer, FILE *stream);
+
+/**
+ * It initializes the lexer to analyze the characters of
+ * the specified buffer in place, that is, without copying
+ * them.
+ * <p>
+ * The buffer does not need to be terminated by a null
+ * character and it is never written by the lexer, hence,
+ * it may be a read-only memory mapping of a file.
+ *
+ * @param lexer the lexer
+ * @param buf   the buffer to be analyzed by the lexer
+ * @param len   the buffer length
+ */
+void
+init_lexer_buffer(struct lexer *lexer, const char *buf, size_t len);
+
+/**
+ * It completes the lexer error with the specified code and
+ * with the position of the token being analyzed, and then it
+ * returns to the recovery point of the lexer.
+ * <p>
+ * It is only called by <em>ANALYSIS_ERROR</em>, after the
+ * message has been written into the lexer error.
+ *
+ * @param lexer the lexer, which has a recovery point
+ * @param code  the analysis error code
+ */
+_Noreturn void
+lexer_fail(struct lexer *lexer, unsigned code);
+
+/**
+ * It frees the buffer and the symbols of the specified
+ * lexer. The lexer may be initialized again afterwards.
+ *
+ * @param lexer the lexer
+ */
+void
+lexer_free(struct lexer *lexer);
 
 #endif // LEXER_H
@@ -23,29 +23,545 @@
  */
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #include "./lexer/lexer.h"
 #include "./parser/parser.h"
+#include "./eval/eval.h"
+#include "./eval/parallel.h"
+#include "./vm/vm.h"
+#include "./jit/jit.h"
+#include "./opt/opt.h"
+#include "./batch/batch.h"
+#include "./serve/serve.h"
+#include "./output/output.h"
+#include "./semantic/semantic.h"
 
-extern struct lexer lexer;
-extern struct token *curr_token;
+/**
+ * Evaluation engines definition.
+ */
+#define ENGINE_TREE (0x0)
+#define ENGINE_VM   (0x1)
+#define ENGINE_JIT  (0x2)
+
+/**
+ * The minimum amount of statements the tree engine evaluates on a pool,
+ * since the fewer statements take less than starting its threads.
+ */
+#define PARALLEL_STATEMENTS (64)
+
+/**
+ * The amount of rows of the bound columns evaluated at a time when
+ * their results are written to the standard output.
+ */
+#define BATCH_STREAM_ROWS (64 * 1024)
+
+/**
+ * It returns the current time in seconds measured by a
+ * monotonic clock.
+ *
+ * @return the current time in seconds
+ */
+static double
+now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/**
+ * It prints the statistics about the evaluation to the
+ * standard error.
+ *
+ * @param lexer     the lexer of the input
+ * @param analysis  the time in seconds taken by the lexical and syntax analysis
+ * @param elapsed   the time in seconds taken by the whole run
+ * @param program   the compiled program
+ * @param optimized the optimized program
+ */
+static void
+print_stats(const struct lexer *lexer, const double analysis, const double elapsed, const struct program *program,
+            const struct program *optimized) {
+    const double bytes = (double)(lexer->consumed + lexer->pos);
+
+    fflush(stdout);
+    fprintf(stderr, "stats: %.0f bytes lexed and parsed in %.6f s (%.2f MB/s).\n",
+            bytes, analysis, analysis > 0.0 ? bytes / analysis / 1e6 : 0.0);
+    fprintf(stderr, "stats: %.0f bytes run end to end in %.6f s (%.2f MB/s).\n",
+            bytes, elapsed, elapsed > 0.0 ? bytes / elapsed / 1e6 : 0.0);
+    fprintf(stderr, "stats: %llu allocations performed by the lexer.\n", lexer->allocations);
+    fprintf(stderr, "stats: %u distinct identifiers interned (%llu allocations).\n",
+            lexer->symbols->count, lexer->symbols->allocations);
+    fprintf(stderr, "stats: %u nodes compiled, %u eliminated as common subexpressions.\n",
+            program->count, program->eliminated);
+    fprintf(stderr, "stats: %u nodes after optimization.\n", optimized->count);
+}
+
+/**
+ * It initializes the lexer to analyze the file at the specified path.
+ * <p>
+ * If the path refers to a regular file, then the file is memory-mapped
+ * and analyzed in place. Otherwise, e.g., a pipe or a terminal, the file
+ * is read through the buffered stream.
+ * <p>
+ * Further, if the file could not be opened, then the program is exited.
+ *
+ * @param lexer the lexer to be initialized
+ * @param path  the path of the file to be analyzed
+ */
+static void
+init_input(struct lexer *lexer, const char *path) {
+    struct stat st;
+    FILE       *input;
+    void       *map;
+    int         fd;
+
+    if ((fd = open(path, O_RDONLY)) < 0) {
+        printf("RDP-CALC: Input stream %s could not be opened.\n", path);
+        exit(EXIT_FAILURE);
+    }
+
+    /* It checks if the file is a non-empty regular file that can be mapped */
+    if (0 == fstat(fd, &st) && S_ISREG(st.st_mode) && st.st_size > 0) {
+        map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+        if (map != MAP_FAILED) {
+            /* The lexer reads the mapping front to back only once */
+            madvise(map, (size_t)st.st_size, MADV_SEQUENTIAL);
+            close(fd);
+
+            init_lexer_buffer(lexer, (const char *)map, (size_t)st.st_size);
+            return;
+        }
+    }
+
+    if (!(input = fdopen(fd, "r"))) {
+        printf("RDP-CALC: Input stream %s could not be opened.\n", path);
+        exit(EXIT_FAILURE);
+    }
+
+    init_lexer(lexer, input);
+}
+
+/**
+ * It memory-maps the column of little-endian doubles in the file at
+ * the specified path.
+ * <p>
+ * If the file could not be mapped or its size is not a multiple of
+ * the size of a double, then the program is exited.
+ *
+ * @param path the path of the column file
+ * @param rows the amount of rows of the column, which is set
+ *
+ * @return the values of the column, or NULL if it has no rows
+ */
+static const double *
+map_column(const char *path, size_t *rows) {
+    struct stat st;
+    void       *map;
+    int         fd;
+
+    if ((fd = open(path, O_RDONLY)) < 0 || 0 != fstat(fd, &st)) {
+        printf("RDP-CALC: Column %s could not be opened.\n", path);
+        exit(EXIT_FAILURE);
+    }
+
+    /* It checks if the file does not hold a whole amount of doubles */
+    if (st.st_size % sizeof(double)) {
+        printf("RDP-CALC: Column %s size is not a multiple of %zu bytes.\n", path, sizeof(double));
+        exit(EXIT_FAILURE);
+    }
+
+    *rows = (size_t)st.st_size / sizeof(double);
+    if (0 == *rows) {
+        close(fd);
+        return NULL;
+    }
+
+    if ((map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0)) == MAP_FAILED) {
+        printf("RDP-CALC: Column %s could not be mapped.\n", path);
+        exit(EXIT_FAILURE);
+    }
+
+    /* The column is read front to back only once */
+    madvise(map, (size_t)st.st_size, MADV_SEQUENTIAL);
+    close(fd);
+
+    return (const double *)map;
+}
+
+/**
+ * It evaluates the specified program once for each row of the columns
+ * specified by the bindings, writing the values of each result into a
+ * column created at the specified path of the result, or, if there is
+ * no path, writing the results of each row to the specified output.
+ * <p>
+ * Each binding has the form <em>name=path</em>, where the name is a
+ * variable of the program, other than a constant, and the path is a
+ * column file. Every column must have the same amount of rows.
+ * <p>
+ * The rows are evaluated by a pool of the specified amount of threads.
+ * <p>
+ * If a binding is invalid, the amount of paths is not the amount of
+ * results, or a column could not be mapped, then the program is exited.
+ *
+ * @param program   the program to be evaluated
+ * @param symbols   the symbols of the variable names of the program
+ * @param bindings  the bindings of the variables to the columns
+ * @param nbindings the amount of bindings
+ * @param outputs   the paths of the output columns, one per result
+ * @param noutputs  the amount of output paths
+ * @param output    the output of the rows, if there is no output path
+ * @param threads   the amount of threads, or 0 for one per available core
+ *
+ * @return the amount of rows evaluated
+ */
+static size_t
+run_batch(const struct program *program, const struct intern_pool *symbols, char **bindings,
+          const uint32_t nbindings, char **outputs, const uint32_t noutputs, struct output *output,
+          const unsigned threads) {
+    struct column *columns = malloc(sizeof(struct column) * nbindings * 2); /* the columns, then a chunk of them */
+    double       **outs    = malloc(sizeof(double *) * (program->nresults + 1));
+    int           *fds     = malloc(sizeof(int) * (noutputs + 1));
+    size_t         rows    = 0;
+    struct pool   *pool;
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+    printf("RDP-CALC: The columns of little-endian doubles are not supported on this host.\n");
+    exit(EXIT_FAILURE);
+#endif
+
+    if (!columns || !outs || !fds) {
+        printf("RDP-CALC: %u columns could not be allocated.\n", nbindings + noutputs);
+        exit(EXIT_FAILURE);
+    }
+
+    /* It checks if each result does not have its own output column */
+    if (noutputs && noutputs != program->nresults) {
+        printf("RDP-CALC: The expression has %u results, but %u output columns are given.\n",
+               program->nresults, noutputs);
+        exit(EXIT_FAILURE);
+    }
+
+    for (uint32_t c = 0; c < nbindings; c++) {
+        char    *path = strchr(bindings[c], '=');
+        unsigned id;
+        size_t   n;
+
+        if (!path) {
+            printf("RDP-CALC: Binding %s is not of the form name=path.\n", bindings[c]);
+            exit(EXIT_FAILURE);
+        }
+
+        id = intern_find(symbols, bindings[c], (size_t)(path - bindings[c]));
+
+        /* It checks if the name is not a variable stored by the program */
+        if (id == INTERN_NONE || id >= program->nslots || program->stores[id] == AST_NONE) {
+            printf("RDP-CALC: Variable `%.*s` is not defined by the expression.\n",
+                   (int)(path - bindings[c]), bindings[c]);
+            exit(EXIT_FAILURE);
+        }
+
+        /* It checks if the variable is a constant, which has been folded */
+        if (program->flags[id] & IS_CONSTANT) {
+            printf("RDP-CALC: Variable `%s` cannot be bound since it is read-only.\n",
+                   intern_name(symbols, id));
+            exit(EXIT_FAILURE);
+        }
+
+        columns[c].slot   = id;
+        columns[c].values = map_column(path + 1, &n);
+
+        if (c > 0 && n != rows) {
+            printf("RDP-CALC: Column %s has %zu rows, instead of %zu.\n", path + 1, n, rows);
+            exit(EXIT_FAILURE);
+        }
+        rows = n;
+    }
+
+    for (uint32_t o = 0; o < noutputs; o++) {
+        if ((fds[o] = open(outputs[o], O_RDWR | O_CREAT | O_TRUNC, 0644)) < 0 ||
+            0 != ftruncate(fds[o], (off_t)(rows * sizeof(double)))) {
+            printf("RDP-CALC: Output column %s could not be created.\n", outputs[o]);
+            exit(EXIT_FAILURE);
+        }
+
+        if (rows > 0) {
+            outs[o] = mmap(NULL, rows * sizeof(double), PROT_READ | PROT_WRITE, MAP_SHARED, fds[o], 0);
+            if (outs[o] == MAP_FAILED) {
+                printf("RDP-CALC: Output column %s could not be mapped.\n", outputs[o]);
+                exit(EXIT_FAILURE);
+            }
+        }
+    }
+
+    /* The results written to the output are evaluated a chunk of rows */
+    /* at a time, into columns reused by every chunk */
+    if (!noutputs) {
+        for (uint32_t o = 0; o < program->nresults; o++) {
+            if (!(outs[o] = malloc(sizeof(double) * BATCH_STREAM_ROWS))) {
+                printf("RDP-CALC: The results of %d rows could not be allocated.\n", BATCH_STREAM_ROWS);
+                exit(EXIT_FAILURE);
+            }
+        }
+    }
+
+    if (rows > 0) {
+        pool = pool_new(threads);
+
+        if (noutputs)
+            evaluate_batch(program, columns, nbindings, rows, outs, pool);
+        else {
+            struct column *chunk = columns + nbindings;
+
+            for (size_t start = 0; start < rows; start += BATCH_STREAM_ROWS) {
+                const size_t n = rows - start < BATCH_STREAM_ROWS ? rows - start : BATCH_STREAM_ROWS;
+
+                for (uint32_t c = 0; c < nbindings; c++) {
+                    chunk[c].slot   = columns[c].slot;
+                    chunk[c].values = columns[c].values + start;
+                }
+                evaluate_batch(program, chunk, nbindings, n, outs, pool);
+                output_columns(output, (const double *const *)outs, program->nresults, n);
+            }
+        }
+
+        pool_free(pool);
+
+        for (uint32_t o = 0; o < noutputs; o++)
+            munmap(outs[o], rows * sizeof(double));
+        for (uint32_t c = 0; c < nbindings; c++)
+            munmap((void *)columns[c].values, rows * sizeof(double));
+    }
+
+    if (!noutputs)
+        for (uint32_t o = 0; o < program->nresults; o++)
+            free(outs[o]);
+
+    for (uint32_t o = 0; o < noutputs; o++)
+        close(fds[o]);
+    free(columns);
+    free(outs);
+    free(fds);
+
+    return rows;
+}
+
+/**
+ * It evaluates the specified program using the specified engine, and
+ * writes the value of each result to the specified output.
+ * <p>
+ * The tree engine evaluates the independent statements of the larger
+ * programs concurrently on a pool of the specified amount of threads.
+ * <p>
+ * If the evaluation frame could not be allocated, then the program
+ * is exited.
+ *
+ * @param program the program to be evaluated
+ * @param engine  the evaluation engine
+ * @param output  the output of the results
+ * @param threads the amount of threads, or 0 for one per available core
+ */
+static void
+run(const struct program *program, const int engine, struct output *output, const unsigned threads) {
+    struct bytecode *bytecode;
+    struct jit      *jit;
+    struct pool     *pool;
+    double          *frame;
+
+    if (!(frame = calloc(program_frame_size(program), sizeof(double)))) {
+        printf("RDP-CALC: An evaluation frame could not be allocated.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    switch (engine) {
+        case ENGINE_VM:
+            bytecode = vm_compile(program);
+            vm_run(bytecode, frame);
+            bytecode_free(bytecode);
+            break;
+        case ENGINE_JIT:
+            bytecode = vm_compile(program);
+
+            /* It checks if the bytecode could be compiled to machine code */
+            /* Otherwise, it falls back to the virtual machine */
+            if ((jit = jit_compile(bytecode))) {
+                jit->fn(frame);
+                jit_free(jit);
+            } else vm_run(bytecode, frame);
+
+            bytecode_free(bytecode);
+            break;
+        default:
+            /* It checks if the program is worth evaluating on a pool */
+            if (program->nstatements >= PARALLEL_STATEMENTS && threads != 1) {
+                pool = pool_new(threads);
+                evaluate_parallel(program, frame, pool);
+                pool_free(pool);
+            } else evaluate(program, frame);
+    }
+
+    output_row(output, frame + program->nslots, program->nresults);
+
+    free(frame);
+}
 
 int main(int argc, char **argv) {
     --argc, ++argv;
 
-    FILE *input;
+    struct parser  *parser;
+    struct program *program;
+    struct program *optimized;
+    char          **bindings  = malloc(sizeof(char *) * (argc + 1));
+    uint32_t        nbindings = 0;
+    char          **outputs   = malloc(sizeof(char *) * (argc + 1));
+    uint32_t        noutputs  = 0;
+    const char     *sockpath  = NULL;
+    unsigned        threads   = 0;
+    int             format    = OUTPUT_PLAIN;
+    struct output   output;
+    size_t          exprcache = SERVE_EXPRESSIONS;
+    size_t          rescache  = SERVE_RESULTS;
+    int             stats     = 0;
+    int             dumps     = 0;
+    int             engine    = ENGINE_TREE;
+    size_t          errors;
+    double          start;
+    double          analysis;
+
+    if (!bindings || !outputs) {
+        printf("RDP-CALC: The options could not be allocated.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    /* It parses the options preceding the input stream */
+    for (; argc > 0 && 0 == strncmp(argv[0], "--", 2); --argc, ++argv) {
+        if (0 == strcmp(argv[0], "--stats"))
+            stats = 1;
+        else if (0 == strcmp(argv[0], "--dump"))
+            dumps = 1;
+        else if (0 == strcmp(argv[0], "--vm"))
+            engine = ENGINE_VM;
+        else if (0 == strcmp(argv[0], "--jit"))
+            engine = ENGINE_JIT;
+        else if (0 == strcmp(argv[0], "--bind") && argc > 1) {
+            bindings[nbindings++] = argv[1];
+            --argc, ++argv;
+        } else if (0 == strcmp(argv[0], "--output") && argc > 1) {
+            outputs[noutputs++] = argv[1];
+            --argc, ++argv;
+        } else if (0 == strcmp(argv[0], "--serve") && argc > 1) {
+            sockpath = argv[1];
+            --argc, ++argv;
+        } else if (0 == strcmp(argv[0], "--threads") && argc > 1) {
+            char *end;
+            threads = (unsigned)strtoul(argv[1], &end, 10);
+            if (end == argv[1] || *end != '\0' || threads > 4096) {
+                printf("RDP-CALC: The amount of threads %s is not valid.\n", argv[1]);
+                exit(EXIT_FAILURE);
+            }
+            --argc, ++argv;
+        } else if ((0 == strcmp(argv[0], "--expression-cache") || 0 == strcmp(argv[0], "--result-cache"))
+                   && argc > 1) {
+            char               *end;
+            unsigned long long  megabytes = strtoull(argv[1], &end, 10);
+            if (end == argv[1] || *end != '\0' || megabytes > ((size_t)-1 >> 20)) {
+                printf("RDP-CALC: The cache size %s is not valid.\n", argv[1]);
+                exit(EXIT_FAILURE);
+            }
+            if (0 == strcmp(argv[0], "--result-cache"))
+                rescache = (size_t)megabytes << 20;
+            else exprcache = (size_t)megabytes << 20;
+            --argc, ++argv;
+        } else if (0 == strcmp(argv[0], "--format") && argc > 1) {
+            if (0 == strcmp(argv[1], "plain"))
+                format = OUTPUT_PLAIN;
+            else if (0 == strcmp(argv[1], "csv"))
+                format = OUTPUT_CSV;
+            else if (0 == strcmp(argv[1], "binary"))
+                format = OUTPUT_BINARY;
+            else {
+                printf("RDP-CALC: The output format %s is not valid.\n", argv[1]);
+                exit(EXIT_FAILURE);
+            }
+            --argc, ++argv;
+        } else {
+            printf("RDP-CALC: Unknown option %s.\n", argv[0]);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    /* It checks if the output columns are given without bound columns */
+    if (noutputs > 0 && !nbindings) {
+        printf("RDP-CALC: The option --output requires the option --bind.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    /* It checks if the calculator serves the requests of a socket */
+    /* instead of evaluating an input stream */
+    if (sockpath) {
+        serve(sockpath, exprcache, rescache, stats);
+        free(bindings);
+        free(outputs);
+        return 0;
+    }
+
+    start  = now();
+    parser = parser_new();
 
     /* It checks if the user is running the */
     /* application without specyfing an input stream */
     if (0 == argc)
-        input = stdin;
-    else if (!(input = fopen(argv[0], "r"))) {
-        printf("RDP-CALC: Input stream %s could not be opened.\n", argv[0]);
-        exit(EXIT_FAILURE);
+        init_lexer(&parser->lexer, stdin);
+    else init_input(&parser->lexer, argv[0]);
+
+    /* The statements having an error are reported and left out, */
+    /* whereas the other statements are still evaluated */
+    analysis  = now();
+    program   = compile(parser);
+    analysis  = now() - analysis;
+    optimized = optimize(program);
+    errors    = parser->nerrors;
+    print_errors(parser);
+
+    if (dumps) {
+        fprintf(stderr, "dump: %u nodes before optimization (%u eliminated as common subexpressions).\n",
+                program->count, program->eliminated);
+        dump(stderr, program, parser->lexer.symbols);
+        fprintf(stderr, "dump: %u nodes after optimization.\n", optimized->count);
+        dump(stderr, optimized, parser->lexer.symbols);
     }
 
-    init_lexer(input);
-    parse();
+    init_output(&output, STDOUT_FILENO, format);
+
+    if (nbindings > 0) {
+        const size_t rows = run_batch(optimized, parser->lexer.symbols, bindings, nbindings, outputs, noutputs,
+                                      &output, threads);
+
+        /* The rows written to the standard output are not followed by their amount */
+        if (noutputs)
+            printf("Rows: %zu.\n", rows);
+
+        if (stats)
+            fprintf(stderr, "stats: %zu rows evaluated (%.2f Mrows/s).\n", rows, rows / (now() - start) / 1e6);
+    } else if (optimized->nresults)
+        run(optimized, engine, &output, threads);
+
+    output_free(&output);
+
+    if (stats)
+        print_stats(&parser->lexer, analysis, now() - start, program, optimized);
+
+    free(bindings);
+    free(outputs);
+    program_free(program);
+    program_free(optimized);
+    parser_free(parser);
 
-    return 0;
+    return errors ? EXIT_FAILURE : 0;
 }
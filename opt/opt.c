@@ -0,0 +1,297 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Ricardo Fares
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "../semantic/semantic.h"
+#include "../eval/eval.h"
+#include "./opt.h"
+
+/**
+ * The names of the node operations, indexed by operation.
+ */
+static const char *const names[] = {
+    "number", "load", "store", "add", "sub", "mul", "div", "pow", "fact", "abs",
+    "sin", "cos", "tan", "csc", "sec", "cot", "floor", "ceil", "sqrt", "cbrt",
+    "log10", "log2"
+};
+
+/* Structure Definitions */
+
+/**
+ * The state of the optimization of a program.
+ * <p>
+ * The nodes of the source program whose values are known at compile
+ * time are not copied into the target program at once, instead, a
+ * number node is appended only when their value is an operand of a
+ * node that could not be folded. Therefore, the operands of a folded
+ * node do not leave dead nodes behind.
+ */
+struct folder {
+    const struct program *source;
+    struct program       *target;
+    uint32_t             *map;    /* the index of each source node in the target */
+    unsigned char        *known;  /* whether each source node value is known */
+    double               *values; /* the value of each known source node */
+};
+
+/* Function Declaration */
+
+/**
+ * It returns the index of the target node computing the value of the
+ * specified source node, appending a number node if the value is known
+ * and has not been needed yet.
+ *
+ * @param folder the optimization state
+ * @param index  the index of the source node
+ *
+ * @return the index of the target node
+ */
+static uint32_t
+operand(struct folder *folder, uint32_t index);
+
+/**
+ * It checks if the specified value is a power of two whose reciprocal
+ * is a normal number, such that the division by the value is exactly
+ * the multiplication by its reciprocal.
+ *
+ * @param value      the value to be checked
+ * @param reciprocal the reciprocal of the value, set if it is exact
+ *
+ * @return 1 if the reciprocal is exact, otherwise 0
+ */
+static int
+exact_reciprocal(double value, double *reciprocal);
+
+/**
+ * It appends the multiplications computing the specified target node
+ * raised to the specified exponent, by the exponentiation by squaring.
+ *
+ * @param folder   the optimization state
+ * @param base     the index of the target node of the base
+ * @param exponent the exponent, at least 1
+ *
+ * @return the index of the target node computing the power
+ */
+static uint32_t
+power(struct folder *folder, uint32_t base, unsigned exponent);
+
+/**
+ * It simplifies the specified binary source node, in which at most one
+ * operand is known, appending its target node if it is not an identity.
+ *
+ * @param folder the optimization state
+ * @param index  the index of the source node
+ *
+ * @return the index of the target node computing the source node
+ */
+static uint32_t
+simplify(struct folder *folder, uint32_t index);
+
+/* Function Definition */
+
+static uint32_t
+operand(struct folder *folder, const uint32_t index) {
+    if (folder->map[index] == AST_NONE)
+        folder->map[index] = ast_number(folder->target, folder->values[index]);
+    return folder->map[index];
+}
+
+static int
+exact_reciprocal(const double value, double *reciprocal) {
+    int exponent;
+
+    if (!isfinite(value) || fabs(frexp(value, &exponent)) != 0.5)
+        return 0;
+    *reciprocal = 1.0 / value;
+    return isnormal(*reciprocal);
+}
+
+static uint32_t
+power(struct folder *folder, uint32_t base, unsigned exponent) {
+    uint32_t result = AST_NONE;
+
+    for (;;) {
+        if (exponent & 1)
+            result = result == AST_NONE ? base : ast_binary(folder->target, AST_MUL, result, base);
+        if (!(exponent >>= 1))
+            return result;
+        base = ast_binary(folder->target, AST_MUL, base, base);
+    }
+}
+
+static uint32_t
+simplify(struct folder *folder, const uint32_t index) {
+    const struct ast_node *node = &folder->source->nodes[index];
+    const int              l    = folder->known[node->lhs];
+    const int              r    = folder->known[node->rhs];
+    const double           a    = folder->values[node->lhs];
+    const double           b    = folder->values[node->rhs];
+    double                 reciprocal;
+
+    switch (node->op) {
+        case AST_ADD:
+            /* Only the negative zero is the identity of the addition */
+            if (r && b == 0.0 && signbit(b))
+                return folder->map[node->lhs];
+            if (l && a == 0.0 && signbit(a))
+                return folder->map[node->rhs];
+            break;
+        case AST_SUB:
+            if (r && b == 0.0 && !signbit(b))
+                return folder->map[node->lhs];
+            break;
+        case AST_MUL:
+            if (r && b == 1.0)
+                return folder->map[node->lhs];
+            if (l && a == 1.0)
+                return folder->map[node->rhs];
+            break;
+        case AST_DIV:
+            if (r && b == 1.0)
+                return folder->map[node->lhs];
+            if (r && exact_reciprocal(b, &reciprocal))
+                return ast_binary(folder->target, AST_MUL, folder->map[node->lhs],
+                                  ast_number(folder->target, reciprocal));
+            break;
+        case AST_POW:
+            if (r && b == 1.0)
+                return folder->map[node->lhs];
+            if (r && b == -1.0)
+                return ast_binary(folder->target, AST_DIV, ast_number(folder->target, 1.0), folder->map[node->lhs]);
+            if (r && b >= 2.0 && b <= OPT_POW_MAX && b == floor(b))
+                return power(folder, folder->map[node->lhs], (unsigned)b);
+            break;
+    }
+
+    return ast_binary(folder->target, node->op, operand(folder, node->lhs), operand(folder, node->rhs));
+}
+
+struct program *
+optimize(const struct program *program) {
+    struct folder folder;
+    uint32_t      next = 0; /* the next statement to be ended */
+
+    folder.source = program;
+    folder.target = program_new();
+    folder.map    = malloc(sizeof(uint32_t) * (program->count + 1));
+    folder.known  = calloc(program->count + 1, sizeof(unsigned char));
+    folder.values = calloc(program->count + 1, sizeof(double));
+
+    /* It checks if the optimization state could not be allocated */
+    if (!folder.map || !folder.known || !folder.values) {
+        printf("optimize: The state of %u nodes could not be allocated.\n", program->count);
+        exit(EXIT_FAILURE);
+    }
+
+    for (uint32_t i = 0; i < program->count; i++) {
+        const struct ast_node *node = &program->nodes[i];
+
+        folder.map[i] = AST_NONE;
+
+        switch (node->op) {
+            case AST_NUMBER:
+                folder.known[i]  = 1;
+                folder.values[i] = program->consts[node->aux];
+                break;
+            case AST_LOAD:
+                /* It checks if the load reads a constant stored by the program, */
+                /* whose value is either known or computed by the stored node. */
+                /* A stored load is not shared, since the engines read a load */
+                /* at each use, after which its variable may have been stored */
+                if (program->flags[node->aux] & IS_CONSTANT && node->rhs != AST_NONE) {
+                    const uint32_t value = program->nodes[node->rhs].lhs;
+
+                    if (folder.known[value]) {
+                        folder.known[i]  = 1;
+                        folder.values[i] = folder.values[value];
+                    } else if (folder.target->nodes[folder.map[value]].op != AST_LOAD)
+                        folder.map[i] = folder.map[value];
+                    else folder.map[i] = ast_load(folder.target, node->aux);
+                } else folder.map[i] = ast_load(folder.target, node->aux);
+                break;
+            case AST_STORE:
+                folder.map[i] = ast_store(folder.target, node->aux, operand(&folder, node->lhs),
+                                          program->flags[node->aux]);
+                break;
+            case AST_ADD: case AST_SUB: case AST_MUL: case AST_DIV: case AST_POW:
+                /* It checks if both operands are known */
+                if (folder.known[node->lhs] && folder.known[node->rhs]) {
+                    folder.known[i]  = 1;
+                    folder.values[i] = apply(node->op, folder.values[node->lhs], folder.values[node->rhs]);
+                } else folder.map[i] = simplify(&folder, i);
+                break;
+            default:
+                /* It checks if the operand is known */
+                if (folder.known[node->lhs]) {
+                    folder.known[i]  = 1;
+                    folder.values[i] = apply(node->op, folder.values[node->lhs], 0.0);
+                } else folder.map[i] = ast_unary(folder.target, node->op, folder.map[node->lhs]);
+        }
+
+        /* The statements ending at the node end in the target, such that */
+        /* the target keeps the statements and their dependencies */
+        for (; next < program->nstatements && program->statements[next].end == i + 1; next++) {
+            const struct ast_statement *statement = &program->statements[next];
+            if (statement->output != AST_NONE)
+                ast_statement(folder.target, operand(&folder, statement->node), 1);
+            else ast_statement(folder.target, folder.map[statement->node], 0);
+        }
+    }
+
+    free(folder.map);
+    free(folder.known);
+    free(folder.values);
+
+    return folder.target;
+}
+
+void
+dump(FILE *stream, const struct program *program, const struct intern_pool *symbols) {
+    for (uint32_t i = 0; i < program->count; i++) {
+        const struct ast_node *node = &program->nodes[i];
+
+        fprintf(stream, "%6u  %-6s  ", i, names[node->op]);
+        switch (node->op) {
+            case AST_NUMBER:
+                fprintf(stream, "%.17g\n", program->consts[node->aux]);
+                break;
+            case AST_LOAD:
+                fprintf(stream, "%s\n", intern_name(symbols, node->aux));
+                break;
+            case AST_STORE:
+                fprintf(stream, "%s, %%%u\n", intern_name(symbols, node->aux), node->lhs);
+                break;
+            case AST_ADD: case AST_SUB: case AST_MUL: case AST_DIV: case AST_POW:
+                fprintf(stream, "%%%u, %%%u\n", node->lhs, node->rhs);
+                break;
+            default:
+                fprintf(stream, "%%%u\n", node->lhs);
+        }
+    }
+    for (uint32_t i = 0; i < program->nstatements; i++)
+        if (program->statements[i].output != AST_NONE)
+            fprintf(stream, "%6s  %%%u\n", "result", program->statements[i].node);
+}
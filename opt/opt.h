@@ -0,0 +1,95 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Ricardo Fares
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef OPT_H
+#define OPT_H
+
+#include <stdio.h>
+
+#include "../ast/ast.h"
+#include "../util/intern.h"
+
+/**
+ * The greatest integer exponent of a power lowered into multiplications,
+ * whose error grows with the amount of multiplications.
+ */
+#define OPT_POW_MAX (4)
+
+/* Function Declaration */
+
+/**
+ * It optimizes the specified program into a new equivalent program.
+ * <p>
+ * The subtrees whose operands are all known at compile time, i.e.,
+ * numbers, the built-in constants and the loads of the variables
+ * defined with <em>:=</em>, are folded into a single number. Since
+ * the math functions and the factorial are pure, their calls are
+ * folded as well.
+ * <p>
+ * A variable defined with <em>:=</em> is read-only, hence, each of its
+ * loads is replaced by the node computing its value, even if the value
+ * is not known, unless the value is just another variable.
+ * <p>
+ * Further, the following identities are simplified, which hold for
+ * every value of <em>x</em> including the signed zeros, the infinities
+ * and NaN:
+ *
+ *      x * 1, 1 * x, x / 1, x ** 1  ->  x
+ *      x + (-0), (-0) + x, x - 0    ->  x
+ *      x / c                        ->  x * (1 / c), c a power of two
+ *
+ * The identity <em>x + 0</em> is not simplified, because it turns
+ * <em>-0</em> into <em>+0</em>.
+ * <p>
+ * The powers whose exponent is an integer from 2 to OPT_POW_MAX are
+ * lowered into multiplications by the exponentiation by squaring, e.g.,
+ * <em>x ** 3</em> into <em>x * (x * x)</em>, and <em>x ** -1</em> into
+ * <em>1 / x</em>. Unlike the identities, they are within a couple of
+ * ULPs of <em>pow</em> rather than equal to it, except <em>x ** 2</em>.
+ * <p>
+ * The specified program is not modified and must still be freed by
+ * the caller.
+ *
+ * @param program the program to be optimized
+ *
+ * @return the optimized program, which must be freed by the caller
+ */
+struct program *
+optimize(const struct program *program);
+
+/**
+ * It prints the nodes of the specified program to the specified
+ * stream, one node per line in their evaluation order, followed by
+ * the node of each result.
+ * <p>
+ * The variables are printed by their names in the specified symbol
+ * pool, since their slots are their symbol identifiers.
+ *
+ * @param stream  the stream to print to
+ * @param program the program to be printed
+ * @param symbols the pool of the variable names
+ */
+void
+dump(FILE *stream, const struct program *program, const struct intern_pool *symbols);
+
+#endif // OPT_H
@@ -0,0 +1,460 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Ricardo Fares
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <unistd.h>
+
+#include "./output.h"
+#include "./ryu.h"
+
+/**
+ * The shortest digits of a double, such that the double is the one
+ * nearest to <em>digits * 10^exponent</em>.
+ */
+struct decimal {
+    uint64_t digits;
+    int32_t  exponent;
+};
+
+/**
+ * The pairs of decimal digits from 00 to 99.
+ */
+static const char pairs[200] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+/* Static Function Declaration */
+
+/**
+ * It returns the amount of bits of 5^e, for e from 0 to 3528.
+ *
+ * @param e the exponent
+ *
+ * @return the amount of bits
+ */
+static int32_t
+pow5bits(int32_t e);
+
+/**
+ * It returns floor(log10(2^e)), for e from 0 to 1650.
+ *
+ * @param e the exponent
+ *
+ * @return the logarithm
+ */
+static uint32_t
+log10_pow2(int32_t e);
+
+/**
+ * It returns floor(log10(5^e)), for e from 0 to 2620.
+ *
+ * @param e the exponent
+ *
+ * @return the logarithm
+ */
+static uint32_t
+log10_pow5(int32_t e);
+
+/**
+ * It tells whether the specified value is a multiple of 5^p.
+ *
+ * @param value the value
+ * @param p     the exponent
+ *
+ * @return non-zero if the value is a multiple, zero otherwise
+ */
+static int
+multiple_of_pow5(uint64_t value, uint32_t p);
+
+/**
+ * It returns the specified value times the specified 128-bit factor,
+ * shifted right by the specified amount of bits, at least 64.
+ *
+ * @param m      the value
+ * @param factor the factor, as its lowest and then its highest 64 bits
+ * @param shift  the shift
+ *
+ * @return the shifted product
+ */
+static uint64_t
+mul_shift(uint64_t m, const uint64_t *factor, int32_t shift);
+
+/**
+ * It returns the shortest digits of the specified finite positive
+ * double, given as its IEEE 754 mantissa and biased exponent.
+ *
+ * @param mantissa the mantissa, without its implicit bit
+ * @param exponent the biased exponent
+ *
+ * @return the shortest digits
+ */
+static struct decimal
+shortest(uint64_t mantissa, uint32_t exponent);
+
+/**
+ * It writes the specified double into the buffer of the specified
+ * output in the format of the output, followed by the specified
+ * separator if the format is textual.
+ *
+ * @param output    the output
+ * @param value     the double
+ * @param separator the separator
+ */
+static void
+put_value(struct output *output, double value, char separator);
+
+/* Function Definition */
+
+size_t
+format_double(const double value, char *buf) {
+    uint64_t       bits;
+    uint64_t       mantissa;
+    uint32_t       exponent;
+    struct decimal d;
+    char           storage[20];
+    char *const    end = storage + sizeof(storage);
+    char          *digits;
+    int32_t        ndigits;
+    int32_t        point;
+    uint64_t       v;
+    char          *p   = buf;
+
+    memcpy(&bits, &value, sizeof(double));
+    mantissa = bits & ((UINT64_C(1) << 52) - 1);
+    exponent = (uint32_t)(bits >> 52) & 0x7FF;
+
+    if (exponent == 0x7FF && mantissa) {
+        memcpy(buf, "nan", 3);
+        return 3;
+    }
+
+    if (bits >> 63)
+        *p++ = '-';
+
+    if (exponent == 0x7FF) {
+        memcpy(p, "inf", 3);
+        return (size_t)(p - buf) + 3;
+    }
+
+    if (!exponent && !mantissa) {
+        *p = '0';
+        return (size_t)(p - buf) + 1;
+    }
+
+    d = shortest(mantissa, exponent);
+
+    /* The digits are written from the last one, two at a time */
+    digits = end;
+    for (v = d.digits; v >= 100; v /= 100) {
+        digits -= 2;
+        memcpy(digits, pairs + (v % 100) * 2, 2);
+    }
+    if (v >= 10) {
+        digits -= 2;
+        memcpy(digits, pairs + v * 2, 2);
+    } else *--digits = (char)('0' + v);
+    ndigits = (int32_t)(end - digits);
+
+    /* It is the position of the decimal point after the first digit */
+    point = ndigits + d.exponent;
+
+    if (point > 17 || point < -3) {
+        /* The scientific notation, e.g., 1.5e-9 */
+        *p++ = digits[0];
+        if (ndigits > 1) {
+            *p++ = '.';
+            memcpy(p, digits + 1, (size_t)ndigits - 1);
+            p += ndigits - 1;
+        }
+        *p++ = 'e';
+        if (--point < 0) {
+            *p++  = '-';
+            point = -point;
+        }
+        if (point >= 100) {
+            *p++   = (char)('0' + point / 100);
+            point %= 100;
+            memcpy(p, pairs + point * 2, 2);
+            p += 2;
+        } else if (point >= 10) {
+            memcpy(p, pairs + point * 2, 2);
+            p += 2;
+        } else *p++ = (char)('0' + point);
+    } else if (point <= 0) {
+        /* The number below one, e.g., 0.0015 */
+        *p++ = '0';
+        *p++ = '.';
+        memset(p, '0', (size_t)-point);
+        p += -point;
+        memcpy(p, digits, (size_t)ndigits);
+        p += ndigits;
+    } else if (point >= ndigits) {
+        /* The integer, e.g., 1500 */
+        memcpy(p, digits, (size_t)ndigits);
+        p += ndigits;
+        memset(p, '0', (size_t)(point - ndigits));
+        p += point - ndigits;
+    } else {
+        /* The number having a fraction, e.g., 1.5 */
+        memcpy(p, digits, (size_t)point);
+        p += point;
+        *p++ = '.';
+        memcpy(p, digits + point, (size_t)(ndigits - point));
+        p += ndigits - point;
+    }
+
+    return (size_t)(p - buf);
+}
+
+void
+init_output(struct output *output, const int fd, const int format) {
+    output->fd     = fd;
+    output->format = format;
+    output->len    = 0;
+
+    /* It checks if the buffer could not be allocated */
+    if (!(output->buf = malloc(OUTPUT_BUFLEN))) {
+        printf("output: A buffer of %d characters could not be allocated.\n", OUTPUT_BUFLEN);
+        exit(EXIT_FAILURE);
+    }
+}
+
+void
+output_row(struct output *output, const double *values, const size_t n) {
+    for (size_t i = 0; i < n; i++)
+        put_value(output, values[i], output->format == OUTPUT_CSV && i + 1 < n ? ',' : '\n');
+}
+
+void
+output_columns(struct output *output, const double *const *columns, const size_t ncolumns, const size_t rows) {
+    for (size_t r = 0; r < rows; r++)
+        for (size_t c = 0; c < ncolumns; c++)
+            put_value(output, columns[c][r], output->format == OUTPUT_CSV && c + 1 < ncolumns ? ',' : '\n');
+}
+
+void
+flush_output(struct output *output) {
+    size_t written = 0;
+
+    /* The messages printed to the same descriptor by the standard */
+    /* I/O precede the values */
+    if (output->fd == STDOUT_FILENO)
+        fflush(stdout);
+
+    while (written < output->len) {
+        const ssize_t n = write(output->fd, output->buf + written, output->len - written);
+
+        if (n < 0 && errno == EINTR)
+            continue;
+
+        /* It checks if the values could not be written */
+        if (n <= 0) {
+            fprintf(stderr, "output: The values could not be written (%s).\n", strerror(errno));
+            exit(EXIT_FAILURE);
+        }
+        written += (size_t)n;
+    }
+
+    output->len = 0;
+}
+
+void
+output_free(struct output *output) {
+    flush_output(output);
+    free(output->buf);
+    output->buf = NULL;
+}
+
+/* Static Function Definition */
+
+inline static int32_t
+pow5bits(const int32_t e) {
+    return (int32_t)(((uint32_t)e * 1217359) >> 19) + 1;
+}
+
+inline static uint32_t
+log10_pow2(const int32_t e) {
+    return ((uint32_t)e * 78913) >> 18;
+}
+
+inline static uint32_t
+log10_pow5(const int32_t e) {
+    return ((uint32_t)e * 732923) >> 20;
+}
+
+static int
+multiple_of_pow5(uint64_t value, const uint32_t p) {
+    uint32_t count = 0;
+
+    for (; value % 5 == 0 && count < p; value /= 5)
+        count++;
+
+    return count >= p;
+}
+
+inline static uint64_t
+mul_shift(const uint64_t m, const uint64_t *factor, const int32_t shift) {
+    const unsigned __int128 low  = (unsigned __int128)m * factor[0];
+    const unsigned __int128 high = (unsigned __int128)m * factor[1];
+
+    return (uint64_t)(((low >> 64) + high) >> (shift - 64));
+}
+
+static struct decimal
+shortest(const uint64_t mantissa, const uint32_t exponent) {
+    int32_t  e2;
+    uint64_t m2;
+    uint64_t vr, vp, vm;
+    int32_t  e10;
+    int      vm_zeros = 0; /* whether the digits removed from vm are zeros */
+    int      vr_zeros = 0; /* whether the digits removed from vr are zeros */
+    int32_t  removed  = 0;
+    unsigned last     = 0; /* the last digit removed from vr */
+    uint64_t output;
+
+    /* The bounds are worked out from 4 times the mantissa, */
+    /* such that they are integers */
+    if (exponent == 0) {
+        e2 = 1 - 1023 - 52 - 2;
+        m2 = mantissa;
+    } else {
+        e2 = (int32_t)exponent - 1023 - 52 - 2;
+        m2 = (UINT64_C(1) << 52) | mantissa;
+    }
+
+    const int      even     = (m2 & 1) == 0; /* whether the bounds round to the double */
+    const uint64_t mv       = 4 * m2;
+    const uint32_t mm_shift = mantissa != 0 || exponent <= 1; /* whether the lower gap is as wide */
+
+    /* The bounds are scaled into decimal by a power of five, */
+    /* tracking whether the digits they lose are all zeros */
+    if (e2 >= 0) {
+        const uint32_t q = log10_pow2(e2) - (e2 > 3);
+        const int32_t  k = RYU_POW5_INV_BITCOUNT + pow5bits((int32_t)q) - 1;
+        const int32_t  i = -e2 + (int32_t)q + k;
+
+        e10 = (int32_t)q;
+        vr  = mul_shift(4 * m2, ryu_pow5_inv_split[q], i);
+        vp  = mul_shift(4 * m2 + 2, ryu_pow5_inv_split[q], i);
+        vm  = mul_shift(4 * m2 - 1 - mm_shift, ryu_pow5_inv_split[q], i);
+
+        if (q <= 21) {
+            if (mv % 5 == 0)
+                vr_zeros = multiple_of_pow5(mv, q);
+            else if (even)
+                vm_zeros = multiple_of_pow5(mv - 1 - mm_shift, q);
+            else vp -= multiple_of_pow5(mv + 2, q);
+        }
+    } else {
+        const uint32_t q = log10_pow5(-e2) - (-e2 > 1);
+        const int32_t  i = -e2 - (int32_t)q;
+        const int32_t  k = pow5bits(i) - RYU_POW5_BITCOUNT;
+        const int32_t  j = (int32_t)q - k;
+
+        e10 = (int32_t)q + e2;
+        vr  = mul_shift(4 * m2, ryu_pow5_split[i], j);
+        vp  = mul_shift(4 * m2 + 2, ryu_pow5_split[i], j);
+        vm  = mul_shift(4 * m2 - 1 - mm_shift, ryu_pow5_split[i], j);
+
+        if (q <= 1) {
+            vr_zeros = 1;
+            if (even)
+                vm_zeros = mm_shift == 1;
+            else vp--;
+        } else if (q < 63)
+            vr_zeros = (mv & ((UINT64_C(1) << q) - 1)) == 0;
+    }
+
+    /* The digits shared by the bounds are removed, which are rarely */
+    /* followed by zeros only, in which case the ties round to even */
+    if (vm_zeros || vr_zeros) {
+        for (; vp / 10 > vm / 10; removed++) {
+            vm_zeros &= vm % 10 == 0;
+            vr_zeros &= last == 0;
+            last      = (unsigned)(vr % 10);
+            vr /= 10;
+            vp /= 10;
+            vm /= 10;
+        }
+        if (vm_zeros) {
+            for (; vm % 10 == 0; removed++) {
+                vr_zeros &= last == 0;
+                last      = (unsigned)(vr % 10);
+                vr /= 10;
+                vp /= 10;
+                vm /= 10;
+            }
+        }
+        if (vr_zeros && last == 5 && vr % 2 == 0)
+            last = 4;
+        output = vr + ((vr == vm && (!even || !vm_zeros)) || last >= 5);
+    } else {
+        int round_up = 0;
+
+        /* Two digits are removed at a time while they are shared */
+        if (vp / 100 > vm / 100) {
+            round_up = vr % 100 >= 50;
+            vr /= 100;
+            vp /= 100;
+            vm /= 100;
+            removed += 2;
+        }
+        for (; vp / 10 > vm / 10; removed++) {
+            round_up = vr % 10 >= 5;
+            vr /= 10;
+            vp /= 10;
+            vm /= 10;
+        }
+        output = vr + (vr == vm || round_up);
+    }
+
+    return (struct decimal){ output, e10 + removed };
+}
+
+static void
+put_value(struct output *output, const double value, const char separator) {
+    if (output->len + OUTPUT_DOUBLE_MAX + 16 > OUTPUT_BUFLEN)
+        flush_output(output);
+
+    switch (output->format) {
+        case OUTPUT_BINARY:
+            memcpy(output->buf + output->len, &value, sizeof(double));
+            output->len += sizeof(double);
+            return;
+        case OUTPUT_CSV:
+            output->len += format_double(value, output->buf + output->len);
+            break;
+        default:
+            memcpy(output->buf + output->len, "Value: ", 7);
+            output->len += 7;
+            output->len += format_double(value, output->buf + output->len);
+            output->buf[output->len++] = '.';
+    }
+
+    output->buf[output->len++] = separator;
+}
@@ -0,0 +1,141 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Ricardo Fares
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef OUTPUT_H
+#define OUTPUT_H
+
+#include <stddef.h>
+
+/**
+ * Output formats definition.
+ * <p>
+ * The plain format writes a line per value, the CSV format writes a
+ * line per row whose values are separated by commas, and the binary
+ * format writes the values of each row as native doubles.
+ */
+#define OUTPUT_PLAIN  (0x0)
+#define OUTPUT_CSV    (0x1)
+#define OUTPUT_BINARY (0x2)
+
+/**
+ * Output constants definition.
+ * <p>
+ * A formatted double never takes more than OUTPUT_DOUBLE_MAX characters,
+ * and the values are written OUTPUT_BUFLEN characters at a time.
+ */
+#define OUTPUT_DOUBLE_MAX (32)
+#define OUTPUT_BUFLEN     (1024 * 1024)
+
+/**
+ * A buffered output of values.
+ * <p>
+ * The values are formatted into the buffer, which is written by a
+ * single <em>write</em> each time it is full, bypassing the standard
+ * I/O of the C library.
+ */
+struct output {
+    int    fd;
+    int    format;
+    char  *buf;
+    size_t len;
+};
+
+/* Function Declaration */
+
+/**
+ * It writes the shortest decimal representation of the specified
+ * double which is read back as the same double into the specified
+ * buffer, e.g., <em>0.1</em>, <em>12</em> or <em>1.5e-9</em>.
+ * <p>
+ * <b>Implementation Notes:</b>
+ * This function implements the Ryu algorithm by Ulf Adams: the bounds
+ * of the interval rounding to the double are multiplied by a 125-bit
+ * power of five, and the digits they share are removed until the
+ * shortest ones are left, rounded to the nearest. As with the
+ * <em>%g</em> conversion, the representation is positional if its
+ * exponent is from -4 to 16, and scientific otherwise, as the lexer
+ * reads it.
+ *
+ * @param value the double
+ * @param buf   the buffer, which has OUTPUT_DOUBLE_MAX characters
+ *
+ * @return the amount of characters written, not null-terminated
+ */
+size_t
+format_double(double value, char *buf);
+
+/**
+ * It initializes the specified output writing to the specified file
+ * descriptor in the specified format.
+ * <p>
+ * If the buffer could not be allocated, then the program is exited.
+ *
+ * @param output the output
+ * @param fd     the file descriptor
+ * @param format the output format
+ */
+void
+init_output(struct output *output, int fd, int format);
+
+/**
+ * It writes a row of the specified values to the specified output.
+ *
+ * @param output the output
+ * @param values the values
+ * @param n      the amount of values
+ */
+void
+output_row(struct output *output, const double *values, size_t n);
+
+/**
+ * It writes the specified rows of the specified columns to the
+ * specified output, the values of each row in column order.
+ *
+ * @param output   the output
+ * @param columns  the columns
+ * @param ncolumns the amount of columns
+ * @param rows     the amount of rows of each column
+ */
+void
+output_columns(struct output *output, const double *const *columns, size_t ncolumns, size_t rows);
+
+/**
+ * It writes the buffered values of the specified output.
+ * <p>
+ * If the values could not be written, then the program is exited.
+ *
+ * @param output the output
+ */
+void
+flush_output(struct output *output);
+
+/**
+ * It writes the buffered values of the specified output and frees
+ * its buffer.
+ *
+ * @param output the output
+ */
+void
+output_free(struct output *output);
+
+#endif // OUTPUT_H
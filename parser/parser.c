@@ -23,19 +23,54 @@
  */
 #include <stdio.h>
 #include <stdlib.h>
-#include <math.h>
+#include <string.h>
+#include <unistd.h>
 
 #include "../lexer/lexer.h"
-#include "../util/hashtable.h"
+#include "../semantic/semantic.h"
+#include "../ast/ast.h"
+#include "../eval/eval.h"
+#include "../output/output.h"
 #include "./parser.h"
 
-/* Variables */
-
-extern struct token *curr_token;
-struct hashtable    *ht;
+/**
+ * It retrieves the type, the value and the symbol identifier of the
+ * current token of the parser, and advances to the next token.
+ */
+#define TOKEN_TYPE()  (parser->token->type)
+#define TOKEN_VALUE() (parser->token->metadata.value)
+#define TOKEN_ID()    (parser->token->metadata.id)
+#define NEXT_TOKEN()  (parser->token = next_token(&parser->lexer))
 
 /* Function Declaration */
 
+/**
+ * It returns the descriptor of the variable with the specified
+ * symbol identifier, or NULL if the variable has not been defined.
+ *
+ * @param parser the parser
+ * @param id     the symbol identifier of the variable
+ *
+ * @return the variable descriptor or NULL if the variable has
+ *         not been defined
+ */
+static struct var_descriptor_t *
+lookup(struct parser *parser, unsigned id);
+
+/**
+ * It defines the variable with the specified symbol identifier
+ * as described by the specified descriptor.
+ * <p>
+ * If the variable descriptors could not be grown to fit the
+ * variable, then the program is exited.
+ *
+ * @param parser   the parser
+ * @param id       the symbol identifier of the variable
+ * @param var_desc the variable descriptor
+ */
+static void
+define(struct parser *parser, unsigned id, const struct var_descriptor_t *var_desc);
+
 /**
  * It checks if the next token to be analyzed has
  * the same type as the specified type.
@@ -43,46 +78,100 @@ struct hashtable    *ht;
  * If the token type does not match, then a syntax
  * error has been identified and the program is exited.
  *
- * @param type the token type to be specified
+ * @param parser the parser
+ * @param type   the token type to be specified
+ */
+static void
+match(struct parser *parser, unsigned type);
+
+/**
+ * It parses the input, as <em>S</em> does, followed by the end of the
+ * input.
+ * <p>
+ * The errors of the input are collected into the parser errors, one
+ * per statement. The nodes of a statement having an error are discarded
+ * and the analysis resumes after the statement, that is, after its
+ * semicolon. Therefore, the other statements are still compiled.
+ * <p>
+ * A single recovery point is set for the whole input, hence, the
+ * statements without errors do not pay for the recovery.
+ *
+ * @param parser  the parser
+ * @param results whether the input must have at least one result
+ */
+static void
+statements(struct parser *parser, int results);
+
+/**
+ * It checks if another statement follows the current statement, that
+ * is, if a semicolon follows it which is not the last token.
+ *
+ * @param parser the parser
+ *
+ * @return a non-zero value if another statement follows, otherwise,
+ *         zero
+ */
+static int
+follows(struct parser *parser);
+
+/**
+ * It checks if the current statement ends at the next token, that is,
+ * if the next token is a semicolon or the end of the input.
+ * <p>
+ * If it does not, then a syntax error has been identified, before the
+ * statement has been added to the program.
+ *
+ * @param parser the parser
  */
 static void
-match(unsigned type);
+ends(struct parser *parser);
 
 /**
  * It parses the following production rule (in BNF-notation).
  *
- *      <S> ::= { $id = <expr> ; } <expr>
+ *      <S>         ::= <statement> { ; <statement> } [ ; ]
+ *      <statement> ::= $id [:]= <expr> | <expr>
  *
+ * @param parser the parser
  */
-static double
-S();
+static void
+S(struct parser *parser);
 
 /**
  * It parses the following production rule (in BNF-notation).
  *
  *      <expr> ::= <term> { ( + | - ) <term> }
  *
+ * @param parser the parser
+ *
+ * @return the index of the node computing the parsed expression
  */
-static double
-expr();
+static uint32_t
+expr(struct parser *parser);
 
 /**
  * It parses the following production rule (in BNF-notation).
  *
  *      <term> ::= <base> { ( * | / ) <base> }
  *
+ * @param parser the parser
+ *
+ * @return the index of the node computing the parsed expression
  */
-static double
-term();
+static uint32_t
+term(struct parser *parser);
 
 /**
  * It parses the following production rule (in BNF-notation).
  *
  *      <base> ::= <factor> { ** <factor> }
  *
+ * @param parser the parser
+ *
+ * @return the index of the node computing the parsed expression
  */
-static double
-base();
+static uint32_t
+base(struct parser *parser);
 
 /**
  * It parses the following production rule (in BNF-notation).
@@ -107,92 +196,265 @@ base();
  *                   log10( <expr> ) |
  *                   log2( <expr> )  |
  *
- */
-static double
-factor();
-
-/**
- * It calculates the factorial of the specified double
- * floating-point number x, that is, x!.
- *
- * @param x the number to calculate its factorial
+ * @param parser the parser
  *
- * @return the factorial of x, that is, x!
+ * @return the index of the node computing the parsed expression
  */
-static double
-factorial(double x);
+static uint32_t
+factor(struct parser *parser);
 
 /* Function Definition */
 
-void parse() {
-    ht = hashtable_new(10);
+struct parser *
+parser_new() {
+    struct parser *parser = calloc(1, sizeof(struct parser));
+
+    /* It checks if the parser could not be allocated */
+    if (!parser) {
+        printf("parser: A parser could not be allocated.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    return parser;
+}
+
+void
+parser_free(struct parser *parser) {
+    lexer_free(&parser->lexer);
+    free(parser->vars);
+    free(parser->replaced);
+    free(parser->errors);
+    free(parser);
+}
+
+struct program *
+compile(struct parser *parser) {
+    parser->program = program_new();
 
-    NEXT_TOKEN();
+    /* The variables of a previously compiled program are forgotten */
+    if (parser->vars)
+        memset(parser->vars, 0, parser->nvars * sizeof(struct var_descriptor_t));
+    parser->generation++;
 
-    double value = S();
-    match(LEXER_TOKEN_EOF);
+    statements(parser, 1);
 
-    printf("Value: %lf.\n", value);
+    return parser->program;
 }
 
-static double
-S() {
-    while (TOKEN_TYPE() == LEXER_TOKEN_DOLLAR) {
-        char                    *id;
-        double                   value;
-        struct var_descriptor_t *placeholder;
-        struct var_descriptor_t  var_desc;
-
-        match(LEXER_TOKEN_DOLLAR);
-
-        id          = TOKEN_ID();
-        placeholder = hashtable_find(ht, id);
-
-        // It check if a variable already exists with that id. If so,
-        // then it is checked if the variable is constant. Therefore, if
-        // the variable is constant a parser error occurr since it is not
-        // possible to re-assign a read-only variable.
-        if (placeholder && placeholder->flags & IS_CONSTANT)
-            PARSE_ERROR("Variable `%s` cannot be re-assigned since it is read-only.\n", id);
-
-        match(LEXER_TOKEN_ID);
-
-        // It checks if the equals token `=` is preceded by the 
-        // colon token `:`. Such that, we are analyzing a syntax
-        // of `:=`. Therefore, this will indicate that a constant
-        // is being defined instead of a variable.
-        var_desc.flags = 0;
-        if (TOKEN_TYPE() == LEXER_TOKEN_COLON) {
-            match(LEXER_TOKEN_COLON);
-            var_desc.flags = IS_CONSTANT;
+struct program *
+compile_resident(struct parser *parser) {
+    parser->program   = program_new();
+    parser->resident  = 1;
+    parser->nreplaced = 0;
+
+    statements(parser, 0);
+
+    parser->resident = 0;
+
+    /* It checks if the input has an error. If so, the variables */
+    /* it has defined are forgotten */
+    if (parser->nerrors) {
+        while (parser->nreplaced > 0) {
+            const struct replaced *undo = &parser->replaced[--parser->nreplaced];
+            parser->vars[undo->id]      = undo->descriptor;
         }
+        parser->lexer.error = parser->errors[0];
+
+        program_free(parser->program);
+        return parser->program = NULL;
+    }
+
+    return parser->program;
+}
 
-        match(LEXER_TOKEN_EQUALS);
+int
+declare(struct parser *parser, const unsigned id) {
+    const struct var_descriptor_t  var_desc    = { 0 };
+    const struct var_descriptor_t *placeholder = lookup(parser, id);
 
-        value          = expr();
-        var_desc.value = value;
+    /* It checks if the variable is read-only */
+    if (placeholder && placeholder->flags & IS_CONSTANT)
+        return -1;
 
-        hashtable_insert(ht, id, &var_desc);
+    if (!placeholder)
+        define(parser, id, &var_desc);
 
-        match(LEXER_TOKEN_SEMICOLON);
+    return 0;
+}
+
+unsigned long
+definitions(const struct parser *parser) {
+    return parser->generation;
+}
+
+void
+print_errors(const struct parser *parser) {
+    for (size_t i = 0; i < parser->nerrors; i++) {
+        const struct analysis_error *error = &parser->errors[i];
+
+        printf("Error at line %llu, column %llu (statement %u): %s\n", error->line, error->column,
+               error->statement + 1, error->message);
     }
+}
+
+void parse(struct parser *parser) {
+    double       *frame;
+    struct output output;
+
+    compile(parser);
+    print_errors(parser);
 
-    return expr();
+    /* It checks if the evaluation frame could not be allocated */
+    if (!(frame = calloc(program_frame_size(parser->program), sizeof(double))))
+        PARSE_ERROR("An evaluation frame of %zu values could not be allocated.\n", program_frame_size(parser->program));
+
+    evaluate(parser->program, frame);
+
+    init_output(&output, STDOUT_FILENO, OUTPUT_PLAIN);
+    output_row(&output, frame + parser->program->nslots, parser->program->nresults);
+    output_free(&output);
+
+    free(frame);
+    program_free(parser->program);
+}
+
+static void
+S(struct parser *parser) {
+    for (;;) {
+        if (TOKEN_TYPE() == LEXER_TOKEN_DOLLAR) {
+            unsigned                 id;
+            uint32_t                 value;
+            struct var_descriptor_t *placeholder;
+            struct var_descriptor_t  var_desc = { 0 };
+
+            match(parser, LEXER_TOKEN_DOLLAR);
+
+            id          = TOKEN_ID();
+            placeholder = lookup(parser, id);
+
+            // It check if a variable already exists with that id. If so,
+            // then it is checked if the variable is constant. Therefore, if
+            // the variable is constant a parser error occurr since it is not
+            // possible to re-assign a read-only variable.
+            if (placeholder && placeholder->flags & IS_CONSTANT)
+                PARSE_ERROR("Variable `%s` cannot be re-assigned since it is read-only.\n",
+                            intern_name(parser->lexer.symbols, id));
+
+            match(parser, LEXER_TOKEN_ID);
+
+            // It checks if the equals token `=` is preceded by the 
+            // colon token `:`. Such that, we are analyzing a syntax
+            // of `:=`. Therefore, this will indicate that a constant
+            // is being defined instead of a variable.
+            var_desc.flags = 0;
+            if (TOKEN_TYPE() == LEXER_TOKEN_COLON) {
+                match(parser, LEXER_TOKEN_COLON);
+                var_desc.flags = IS_CONSTANT;
+            }
+
+            match(parser, LEXER_TOKEN_EQUALS);
+
+            value = expr(parser);
+            ends(parser);
+
+            define(parser, id, &var_desc);
+            ast_statement(parser->program, ast_store(parser->program, id, value, var_desc.flags), 0);
+        } else {
+            const uint32_t value = expr(parser);
+
+            ends(parser);
+            ast_statement(parser->program, value, 1);
+        }
+
+        if (!follows(parser))
+            break;
+    }
 }
 
-static double
-expr() {
-    double value = term();
+static void
+statements(struct parser *parser, const int results) {
+    jmp_buf        recovery;
+    jmp_buf *const previous = parser->lexer.recovery;
+
+    parser->lexer.recovery = &recovery;
+    parser->token          = &parser->lexer.token;
+    parser->nerrors        = 0;
+    parser->synchronizing  = 0;
+
+    /* It checks if a statement has an error, which has returned here */
+    if (setjmp(recovery)) {
+        /* The errors found while skipping the statement are not its own */
+        if (!parser->synchronizing) {
+            if (parser->nerrors == parser->errorscap) {
+                struct analysis_error *newerrors;
+
+                parser->errorscap = parser->errorscap ? parser->errorscap << 1 : 16;
+                if (!(newerrors = realloc(parser->errors, sizeof(struct analysis_error) * parser->errorscap))) {
+                    printf("parser: %zu errors could not be allocated.\n", parser->errorscap);
+                    exit(EXIT_FAILURE);
+                }
+                parser->errors = newerrors;
+            }
+            parser->errors[parser->nerrors]           = parser->lexer.error;
+            parser->errors[parser->nerrors].statement = parser->program->nstatements + (unsigned)parser->nerrors;
+            parser->nerrors++;
+
+            ast_discard(parser->program);
+        }
+
+        /* It skips the rest of the statement, up to its semicolon */
+        parser->synchronizing = 1;
+        while (TOKEN_TYPE() != LEXER_TOKEN_SEMICOLON && TOKEN_TYPE() != LEXER_TOKEN_EOF)
+            NEXT_TOKEN();
+        parser->synchronizing = 0;
+
+        if (follows(parser))
+            S(parser);
+    } else {
+        NEXT_TOKEN();
+        S(parser);
+    }
+
+    match(parser, LEXER_TOKEN_EOF);
+
+    /* It checks if there is no result to be evaluated, unless */
+    /* the statements that could have been one have an error */
+    if (results && !parser->nerrors && !parser->program->nresults)
+        PARSE_ERROR("A program must have at least one result.\n");
+
+    parser->lexer.recovery = previous;
+}
+
+static int
+follows(struct parser *parser) {
+    /* The last statement may omit its semicolon */
+    if (TOKEN_TYPE() != LEXER_TOKEN_SEMICOLON)
+        return 0;
+    match(parser, LEXER_TOKEN_SEMICOLON);
+
+    return TOKEN_TYPE() != LEXER_TOKEN_EOF;
+}
+
+static void
+ends(struct parser *parser) {
+    if (TOKEN_TYPE() != LEXER_TOKEN_SEMICOLON && TOKEN_TYPE() != LEXER_TOKEN_EOF)
+        SYNTAX_ERROR("Token Caught: %d, Expected: %d or %d.\n", TOKEN_TYPE(), LEXER_TOKEN_SEMICOLON,
+                     LEXER_TOKEN_EOF);
+}
+
+static uint32_t
+expr(struct parser *parser) {
+    uint32_t value = term(parser);
 
     while ((TOKEN_TYPE() == LEXER_TOKEN_PLUS) || (TOKEN_TYPE() == LEXER_TOKEN_MINUS)) {
         switch (TOKEN_TYPE()) {
             case LEXER_TOKEN_PLUS:
-                match(LEXER_TOKEN_PLUS);
-                value += term();
+                match(parser, LEXER_TOKEN_PLUS);
+                value = ast_binary(parser->program, AST_ADD, value, term(parser));
                 break;
             case LEXER_TOKEN_MINUS:
-                match(LEXER_TOKEN_MINUS);
-                value -= term();
+                match(parser, LEXER_TOKEN_MINUS);
+                value = ast_binary(parser->program, AST_SUB, value, term(parser));
                 break;
             default:
                 SYNTAX_ERROR("Token Caught: %d, Token Expected: %d or %d.\n", TOKEN_TYPE(),
@@ -203,19 +465,19 @@ expr() {
     return value;
 }
 
-static double
-term() {
-    double value = base();
+static uint32_t
+term(struct parser *parser) {
+    uint32_t value = base(parser);
 
     while ((TOKEN_TYPE() == LEXER_TOKEN_MULTIPLY) || (TOKEN_TYPE() == LEXER_TOKEN_DIVIDE)) {
         switch (TOKEN_TYPE()) {
             case LEXER_TOKEN_MULTIPLY:
-                match(LEXER_TOKEN_MULTIPLY);
-                value *= base();
+                match(parser, LEXER_TOKEN_MULTIPLY);
+                value = ast_binary(parser->program, AST_MUL, value, base(parser));
                 break;
             case LEXER_TOKEN_DIVIDE:
-                match(LEXER_TOKEN_DIVIDE);
-                value /= base();
+                match(parser, LEXER_TOKEN_DIVIDE);
+                value = ast_binary(parser->program, AST_DIV, value, base(parser));
                 break;
             default:
                 SYNTAX_ERROR("Token Caught: %d, Token Expected: %d or %d.\n",
@@ -226,15 +488,15 @@ term() {
     return value;
 }
 
-static double
-base() {
-    double value = factor();
+static uint32_t
+base(struct parser *parser) {
+    uint32_t value = factor(parser);
 
     while (TOKEN_TYPE() == LEXER_TOKEN_POW) {
         switch (TOKEN_TYPE()) {
             case LEXER_TOKEN_POW:
-                match(LEXER_TOKEN_POW);
-                value = pow(value, factor());
+                match(parser, LEXER_TOKEN_POW);
+                value = ast_binary(parser->program, AST_POW, value, factor(parser));
                 break;
             default:
                 SYNTAX_ERROR("Token Caught: %d, Token Expected: %d.\n", TOKEN_TYPE(), LEXER_TOKEN_POW);
@@ -244,145 +506,185 @@ base() {
     return value;
 }
 
-static double
-factor() {
+static uint32_t
+factor(struct parser *parser) {
     if (TOKEN_TYPE() == LEXER_TOKEN_NUMBER) {
         const double value = TOKEN_VALUE();
-        match(LEXER_TOKEN_NUMBER);
-        return value;
+        match(parser, LEXER_TOKEN_NUMBER);
+        return ast_number(parser->program, value);
     } else if (TOKEN_TYPE() == LEXER_TOKEN_LPAREN) {
-        match(LEXER_TOKEN_LPAREN);
-        const double value = expr();
-        match(LEXER_TOKEN_RPAREN);
+        match(parser, LEXER_TOKEN_LPAREN);
+        const uint32_t value = expr(parser);
+        match(parser, LEXER_TOKEN_RPAREN);
         return value;
     } else if (TOKEN_TYPE() == LEXER_TOKEN_LBRACKET) {
-        match(LEXER_TOKEN_LBRACKET);
-        const double value = factorial(expr());
-        match(LEXER_TOKEN_RBRACKET);
+        match(parser, LEXER_TOKEN_LBRACKET);
+        const uint32_t value = ast_unary(parser->program, AST_FACT, expr(parser));
+        match(parser, LEXER_TOKEN_RBRACKET);
         return value;
     } else if (TOKEN_TYPE() == LEXER_TOKEN_PLUS) {
-        match(LEXER_TOKEN_PLUS);
+        match(parser, LEXER_TOKEN_PLUS);
         const double value = TOKEN_VALUE();
-        match(LEXER_TOKEN_NUMBER);
-        return value;
+        match(parser, LEXER_TOKEN_NUMBER);
+        return ast_number(parser->program, value);
     } else if (TOKEN_TYPE() == LEXER_TOKEN_MINUS) {
-        match(LEXER_TOKEN_MINUS);
+        match(parser, LEXER_TOKEN_MINUS);
         const double value = -TOKEN_VALUE();
-        match(LEXER_TOKEN_NUMBER);
-        return value;
+        match(parser, LEXER_TOKEN_NUMBER);
+        return ast_number(parser->program, value);
     } else if (TOKEN_TYPE() == LEXER_TOKEN_PIPE) {
-        match(LEXER_TOKEN_PIPE);
-        const double value = fabs(expr());
-        match(LEXER_TOKEN_PIPE);
+        match(parser, LEXER_TOKEN_PIPE);
+        const uint32_t value = ast_unary(parser->program, AST_ABS, expr(parser));
+        match(parser, LEXER_TOKEN_PIPE);
         return value;
     } else if (TOKEN_TYPE() == LEXER_TOKEN_ID) {
-        const char              *id = TOKEN_ID();
-        struct var_descriptor_t *placeholder = NULL;
-
-        match(LEXER_TOKEN_ID);
-
-        placeholder = hashtable_find(ht, id);
+        const unsigned id = TOKEN_ID();
 
         /* It checks if there is no mapping to a value */
         /* for the specified identifier */
-        if (!placeholder)
-            PARSE_ERROR("Use of undeclared variable %s.\n", id);
+        if (!lookup(parser, id))
+            PARSE_ERROR("Use of undeclared variable %s.\n", intern_name(parser->lexer.symbols, id));
+
+        match(parser, LEXER_TOKEN_ID);
 
-        return placeholder->value;
+        return ast_load(parser->program, id);
     } else if (TOKEN_TYPE() == LEXER_TOKEN_FUNCTION_SIN) {  /* sin( <expr> ) */
-        match(LEXER_TOKEN_FUNCTION_SIN);
-        match(LEXER_TOKEN_LPAREN);
-        const double value = expr();
-        match(LEXER_TOKEN_RPAREN);
-        return sin(value);
+        match(parser, LEXER_TOKEN_FUNCTION_SIN);
+        match(parser, LEXER_TOKEN_LPAREN);
+        const uint32_t value = ast_unary(parser->program, AST_SIN, expr(parser));
+        match(parser, LEXER_TOKEN_RPAREN);
+        return value;
     } else if (TOKEN_TYPE() == LEXER_TOKEN_FUNCTION_COS) {  /* cos( <expr> ) */
-        match(LEXER_TOKEN_FUNCTION_COS);
-        match(LEXER_TOKEN_LPAREN);
-        const double value = expr();
-        match(LEXER_TOKEN_RPAREN);
-        return cos(value);
+        match(parser, LEXER_TOKEN_FUNCTION_COS);
+        match(parser, LEXER_TOKEN_LPAREN);
+        const uint32_t value = ast_unary(parser->program, AST_COS, expr(parser));
+        match(parser, LEXER_TOKEN_RPAREN);
+        return value;
     } else if (TOKEN_TYPE() == LEXER_TOKEN_FUNCTION_TAN) {  /* tan( <expr> ) */
-        match(LEXER_TOKEN_FUNCTION_TAN);
-        match(LEXER_TOKEN_LPAREN);
-        const double value = expr();
-        match(LEXER_TOKEN_RPAREN);
-        return tan(value);
+        match(parser, LEXER_TOKEN_FUNCTION_TAN);
+        match(parser, LEXER_TOKEN_LPAREN);
+        const uint32_t value = ast_unary(parser->program, AST_TAN, expr(parser));
+        match(parser, LEXER_TOKEN_RPAREN);
+        return value;
     } else if (TOKEN_TYPE() == LEXER_TOKEN_FUNCTION_CSC) {  /* csc( <expr> ) */
-        match(LEXER_TOKEN_FUNCTION_CSC);
-        match(LEXER_TOKEN_LPAREN);
-        const double value = expr();
-        match(LEXER_TOKEN_RPAREN);
-        return 1.0 / sin(value);
+        match(parser, LEXER_TOKEN_FUNCTION_CSC);
+        match(parser, LEXER_TOKEN_LPAREN);
+        const uint32_t value = ast_unary(parser->program, AST_CSC, expr(parser));
+        match(parser, LEXER_TOKEN_RPAREN);
+        return value;
     } else if (TOKEN_TYPE() == LEXER_TOKEN_FUNCTION_SEC) {  /* sec( <expr> ) */
-        match(LEXER_TOKEN_FUNCTION_SEC);
-        match(LEXER_TOKEN_LPAREN);
-        const double value = expr();
-        match(LEXER_TOKEN_RPAREN);
-        return 1.0 / cos(value);
+        match(parser, LEXER_TOKEN_FUNCTION_SEC);
+        match(parser, LEXER_TOKEN_LPAREN);
+        const uint32_t value = ast_unary(parser->program, AST_SEC, expr(parser));
+        match(parser, LEXER_TOKEN_RPAREN);
+        return value;
     } else if (TOKEN_TYPE() == LEXER_TOKEN_FUNCTION_COT) {  /* cot( <expr> ) */
-        match(LEXER_TOKEN_FUNCTION_COT);
-        match(LEXER_TOKEN_LPAREN);
-        const double value = expr();
-        match(LEXER_TOKEN_RPAREN);
-        return 1.0 / tan(value);
+        match(parser, LEXER_TOKEN_FUNCTION_COT);
+        match(parser, LEXER_TOKEN_LPAREN);
+        const uint32_t value = ast_unary(parser->program, AST_COT, expr(parser));
+        match(parser, LEXER_TOKEN_RPAREN);
+        return value;
     } else if (TOKEN_TYPE() == LEXER_TOKEN_FUNCTION_FLOOR) {  /* floor( <expr> ) */
-        match(LEXER_TOKEN_FUNCTION_FLOOR);
-        match(LEXER_TOKEN_LPAREN);
-        const double value = expr();
-        match(LEXER_TOKEN_RPAREN);
-        return floor(value);
+        match(parser, LEXER_TOKEN_FUNCTION_FLOOR);
+        match(parser, LEXER_TOKEN_LPAREN);
+        const uint32_t value = ast_unary(parser->program, AST_FLOOR, expr(parser));
+        match(parser, LEXER_TOKEN_RPAREN);
+        return value;
     } else if (TOKEN_TYPE() == LEXER_TOKEN_FUNCTION_CEIL) {  /* ceil( <expr> ) */
-        match(LEXER_TOKEN_FUNCTION_CEIL);
-        match(LEXER_TOKEN_LPAREN);
-        const double value = expr();
-        match(LEXER_TOKEN_RPAREN);
-        return ceil(value);
+        match(parser, LEXER_TOKEN_FUNCTION_CEIL);
+        match(parser, LEXER_TOKEN_LPAREN);
+        const uint32_t value = ast_unary(parser->program, AST_CEIL, expr(parser));
+        match(parser, LEXER_TOKEN_RPAREN);
+        return value;
     } else if (TOKEN_TYPE() == LEXER_TOKEN_FUNCTION_SQRT) {  /* sqrt( <expr> ) */
-        match(LEXER_TOKEN_FUNCTION_SQRT);
-        match(LEXER_TOKEN_LPAREN);
-        const double value = expr();
-        match(LEXER_TOKEN_RPAREN);
-        return sqrt(value);
+        match(parser, LEXER_TOKEN_FUNCTION_SQRT);
+        match(parser, LEXER_TOKEN_LPAREN);
+        const uint32_t value = ast_unary(parser->program, AST_SQRT, expr(parser));
+        match(parser, LEXER_TOKEN_RPAREN);
+        return value;
     } else if (TOKEN_TYPE() == LEXER_TOKEN_FUNCTION_CBRT) {  /* cbrt( <expr> ) */
-        match(LEXER_TOKEN_FUNCTION_CBRT);
-        match(LEXER_TOKEN_LPAREN);
-        const double value = expr();
-        match(LEXER_TOKEN_RPAREN);
-        return cbrt(value);
+        match(parser, LEXER_TOKEN_FUNCTION_CBRT);
+        match(parser, LEXER_TOKEN_LPAREN);
+        const uint32_t value = ast_unary(parser->program, AST_CBRT, expr(parser));
+        match(parser, LEXER_TOKEN_RPAREN);
+        return value;
     } else if (TOKEN_TYPE() == LEXER_TOKEN_FUNCTION_LOG10) {  /* log10( <expr> ) */
-        match(LEXER_TOKEN_FUNCTION_LOG10);
-        match(LEXER_TOKEN_LPAREN);
-        const double value = expr();
-        match(LEXER_TOKEN_RPAREN);
-        return log10(value);
+        match(parser, LEXER_TOKEN_FUNCTION_LOG10);
+        match(parser, LEXER_TOKEN_LPAREN);
+        const uint32_t value = ast_unary(parser->program, AST_LOG10, expr(parser));
+        match(parser, LEXER_TOKEN_RPAREN);
+        return value;
     } else if (TOKEN_TYPE() == LEXER_TOKEN_FUNCTION_LOG2) {  /* log2( <expr> ) */
-        match(LEXER_TOKEN_FUNCTION_LOG2);
-        match(LEXER_TOKEN_LPAREN);
-        const double value = expr();
-        match(LEXER_TOKEN_RPAREN);
-        return log2(value);
+        match(parser, LEXER_TOKEN_FUNCTION_LOG2);
+        match(parser, LEXER_TOKEN_LPAREN);
+        const uint32_t value = ast_unary(parser->program, AST_LOG2, expr(parser));
+        match(parser, LEXER_TOKEN_RPAREN);
+        return value;
+    }
+
+    SYNTAX_ERROR("Token Caught: %d, Expected: a number, a variable, a function or an opening token.\n",
+                 TOKEN_TYPE());
+}
+
+inline static struct var_descriptor_t *
+lookup(struct parser *parser, const unsigned id) {
+    return id < parser->nvars && parser->vars[id].flags & IS_DEFINED ? &parser->vars[id] : NULL;
+}
+
+static void
+define(struct parser *parser, const unsigned id, const struct var_descriptor_t *var_desc) {
+    /* It checks if the variable descriptors must be grown to fit the variable */
+    if (id >= parser->nvars) {
+        size_t                   newlen = parser->nvars ? parser->nvars << 1 : 16;
+        struct var_descriptor_t *newvars;
+
+        while (newlen <= id) newlen <<= 1;
+
+        if (!(newvars = realloc(parser->vars, sizeof(struct var_descriptor_t) * newlen)))
+            PARSE_ERROR("The descriptors of %zu variables could not be allocated.\n", newlen);
+
+        memset(newvars + parser->nvars, 0, sizeof(struct var_descriptor_t) * (newlen - parser->nvars));
+
+        parser->vars  = newvars;
+        parser->nvars = newlen;
     }
 
-    printf("factor: Should not reach here!");
-    exit(EXIT_FAILURE);
+    /* It checks if the variable is defined anew. If it was already */
+    /* defined, then the programs compiled so far by compile_resident */
+    /* may have relied on its former flags, hence, they are invalid */
+    if (parser->vars[id].flags != (var_desc->flags | IS_DEFINED)) {
+        if (parser->vars[id].flags & IS_DEFINED)
+            parser->generation++;
+
+        /* It checks if the replaced descriptor must be kept */
+        if (parser->resident) {
+            if (parser->nreplaced == parser->replacedcap) {
+                struct replaced *newreplaced;
+                size_t           newcap = parser->replacedcap ? parser->replacedcap << 1 : 16;
+
+                if (!(newreplaced = realloc(parser->replaced, sizeof(struct replaced) * newcap)))
+                    PARSE_ERROR("The descriptors of %zu variables could not be allocated.\n", newcap);
+                parser->replaced    = newreplaced;
+                parser->replacedcap = newcap;
+            }
+            parser->replaced[parser->nreplaced].id         = id;
+            parser->replaced[parser->nreplaced].descriptor = parser->vars[id];
+            parser->nreplaced++;
+        }
+    }
+
+    parser->vars[id]        = *var_desc;
+    parser->vars[id].flags |= IS_DEFINED;
 }
 
 static void
-match(const unsigned type) {
+match(struct parser *parser, const unsigned type) {
     /* It checks if the current token that has been identified by the */
     /* lexical analysis matches its type with the specified type */
     /* If so, then the next token in the buffer is got */
-    if (curr_token->type == type) {
+    if (TOKEN_TYPE() == type) {
         NEXT_TOKEN();
     } else {
         SYNTAX_ERROR("Token Caught: %d, Expected: %d.\n", TOKEN_TYPE(), type);
     }
 }
-
-static double
-factorial(const double x) {
-    double i = 0.0;
-    double f = 1.0;
-    while ((++i) <= x) f *= i;
-    return f;
-}
@@ -24,48 +24,240 @@
 #ifndef PARSER_H
 #define PARSER_H
 
+#include "../ast/ast.h"
+#include "../lexer/lexer.h"
+#include "../semantic/semantic.h"
+
 /**
  * It prints a message to the standard output indicating
  * an error at the parsing phase has occurred.
  * <p>
  * Further, after the message printing the program is
- * exited.
+ * exited, unless the lexer has a recovery point.
+ * <p>
+ * It is used by the parser functions, which name their
+ * parser <em>parser</em>.
  *
  * @param message the message to be printed out to the
  *                standard output
  */
-#define PARSE_ERROR( MESSAGE, ... ) do {                                   \
-                                printf("parser: " MESSAGE, ##__VA_ARGS__); \
-                                exit(EXIT_FAILURE);                        \
-                               } while (0)
+#define PARSE_ERROR( MESSAGE, ... ) ANALYSIS_ERROR(&parser->lexer, ANALYSIS_SEMANTIC, "parser: " MESSAGE, \
+                                                   ##__VA_ARGS__)
 
 /**
  * It prints a message to the standard output indicating
  * a syntax error has been identified.
  * <p>
  * Further, after the message printing the program is
- * exited.
+ * exited, unless the lexer has a recovery point.
  *
  * @param message the message to be printed out to
  *                the standard output, indicating which
  *                syntax error has occurred
  */
-#define SYNTAX_ERROR( MESSAGE, ... ) PARSE_ERROR("A syntax error has been identified. " MESSAGE, ##__VA_ARGS__)
+#define SYNTAX_ERROR( MESSAGE, ... ) ANALYSIS_ERROR(&parser->lexer, ANALYSIS_SYNTAX,                           \
+                                                    "parser: A syntax error has been identified. " MESSAGE, \
+                                                    ##__VA_ARGS__)
+
+/* Structure Definitions */
+
+/**
+ * A descriptor replaced by a definition, which is
+ * restored if the program being compiled has an error.
+ */
+struct replaced {
+    unsigned                id;
+    struct var_descriptor_t descriptor;
+};
+
+/**
+ * It represents the state of a syntax analysis, that is,
+ * its lexer and the variables defined so far.
+ * <p>
+ * The parser does not share any state with the other
+ * parsers, therefore, distinct parsers may be used by
+ * distinct threads.
+ */
+struct parser {
+    /**
+     * It represents the lexer of the input, which owns
+     * the symbols of the variable names.
+     */
+    struct lexer             lexer;
+
+    /**
+     * It represents the current token.
+     */
+    struct token            *token;
+
+    /**
+     * It represents the program being compiled.
+     */
+    struct program          *program;
+
+    /**
+     * It represents the variable descriptors indexed by
+     * the symbol identifier of the variable name, and the
+     * amount of descriptors that have been allocated.
+     */
+    struct var_descriptor_t *vars;
+    size_t                   nvars;
+
+    /**
+     * It represents the descriptors replaced by the program
+     * being compiled by <em>compile_resident</em>, their
+     * amount and the amount that have been allocated.
+     */
+    struct replaced         *replaced;
+    size_t                   nreplaced;
+    size_t                   replacedcap;
+
+    /**
+     * It represents whether the replaced descriptors are kept.
+     */
+    int                      resident;
+
+    /**
+     * It represents the amount of times a defined variable
+     * has been defined with other flags.
+     */
+    unsigned long            generation;
+
+    /**
+     * It represents the errors of the last compiled input, one
+     * per statement having an error, their amount and the
+     * amount that have been allocated.
+     */
+    struct analysis_error   *errors;
+    size_t                   nerrors;
+    size_t                   errorscap;
+
+    /**
+     * It represents whether the rest of a statement having an
+     * error is being skipped.
+     */
+    int                      synchronizing;
+};
 
 /* Function Declaration */
 
+/**
+ * It allocates a parser without any variable defined.
+ * <p>
+ * The input of the parser is specified by initializing
+ * its lexer, by <em>init_lexer</em> or by
+ * <em>init_lexer_buffer</em>.
+ *
+ * @return the parser, which must be freed by the caller
+ *         by <em>parser_free</em>
+ */
+struct parser *parser_new();
+
+/**
+ * It frees the specified parser and its lexer.
+ *
+ * @param parser the parser
+ */
+void parser_free(struct parser *parser);
+
+/**
+ * It compiles the provided input into a program
+ * which may be evaluated any amount of times.
+ * <p>
+ * More generally, this function does parse the
+ * same grammar as <em>parse</em>, but instead of
+ * evaluating the input it builds its expression
+ * tree.
+ * <p>
+ * The statements having an error are left out of
+ * the program, rather than the program being
+ * exited, and their errors are left in the parser
+ * errors, e.g., to be printed by
+ * <em>print_errors</em>.
+ *
+ * @param parser the parser
+ *
+ * @return the compiled program, which must be
+ *         freed by the caller
+ */
+struct program *compile(struct parser *parser);
+
+/**
+ * It compiles the provided input into a program, as
+ * <em>compile</em> does, except that the variables
+ * defined by the previously compiled programs remain
+ * defined, hence, the input may use them and they
+ * keep their flags, and that the program may have
+ * no result at all.
+ * <p>
+ * A program without results only stores its variables,
+ * hence, it may only be evaluated by <em>evaluate</em>.
+ * <p>
+ * If the input has an error, then NULL is returned
+ * rather than the program being exited, the errors of
+ * its statements are left in the parser errors, the
+ * first one also in the lexer error, and the variables
+ * defined by the input are forgotten.
+ *
+ * @param parser the parser
+ *
+ * @return the compiled program, which must be freed by
+ *         the caller, or NULL if the input has an error
+ */
+struct program *compile_resident(struct parser *parser);
+
+/**
+ * It defines the variable with the specified symbol
+ * identifier, as a definition <em>$id = ...</em> does,
+ * unless it is already defined, such that the programs
+ * compiled next by <em>compile_resident</em> may use it.
+ *
+ * @param parser the parser
+ * @param id     the symbol identifier of the variable
+ *
+ * @return zero, or -1 if the variable is read-only
+ */
+int declare(struct parser *parser, unsigned id);
+
+/**
+ * It returns the amount of times a defined variable has
+ * been defined with other flags so far.
+ * <p>
+ * A program compiled by <em>compile_resident</em> is
+ * still valid as long as this amount is unchanged.
+ *
+ * @param parser the parser
+ *
+ * @return the amount of changes of the variables
+ */
+unsigned long definitions(const struct parser *parser);
+
+/**
+ * It prints the errors of the last compiled input to
+ * the standard output, one line per error.
+ *
+ * @param parser the parser
+ */
+void print_errors(const struct parser *parser);
+
 /**
  * It performs the syntax analysis in the
- * provided input.
+ * provided input, evaluates it and prints
+ * the value of each result to the standard
+ * output.
  * <p>
  * More generally, this function does parse
- * the following grammar production rule
+ * the following grammar production rules
  *
- *      <S> ::= <expr> $
+ *      <S>         ::= <statement> { ; <statement> } [ ; ] $
+ *      <statement> ::= $id [:]= <expr> | <expr>
  *
  * in which <S> is the start symbol from the
- * grammar.
+ * grammar, and at least one statement must
+ * be a result, i.e., an expression.
+ *
+ * @param parser the parser
  */
-void parse();
+void parse(struct parser *parser);
 
 #endif // PARSER_H
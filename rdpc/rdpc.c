@@ -0,0 +1,1008 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Ricardo Fares
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <setjmp.h>
+
+#include "../lexer/lexer.h"
+#include "../parser/parser.h"
+#include "../semantic/semantic.h"
+#include "../eval/eval.h"
+#include "../eval/incremental.h"
+#include "../opt/opt.h"
+#include "../util/lru.h"
+#include "./rdpc.h"
+
+/* Structure Definitions */
+
+struct rdpc_ctx {
+    struct parser *parser;
+    double        *values;  /* the value of each variable, indexed by its symbol */
+    size_t         nvalues;
+    double        *frame;
+    size_t         framelen;
+    int            usage;   /* whether the last error is not an analysis error */
+};
+
+struct rdpc_expr {
+    const struct rdpc_ctx *ctx;
+    struct program        *program;     /* the optimized program */
+    struct incremental    *incremental; /* its evaluation, once it has been updated */
+    uint32_t              *outputs;     /* the results changed by an update */
+    unsigned long          generation;  /* the definitions it has been compiled against */
+    size_t                 nresults;
+    size_t                 len;
+    char                   source[];    /* the source, to compile it again */
+};
+
+/**
+ * An expression of a cache, keyed by the tokens of its source.
+ */
+struct cached_expr {
+    struct lru_entry    entry;
+    struct rdpc_expr   *expr;
+    unsigned long long  serial;     /* the key of the expression among the results */
+    unsigned long       generation; /* the definitions its inputs have been found for */
+    uint32_t           *inputs;     /* the slots read before being stored */
+    uint32_t            ninputs;
+    int                 pure;       /* whether it does not store any variable */
+    size_t              ntokens;
+    unsigned char       tokens[];
+};
+
+/**
+ * A result of a cache, keyed by its expression and by the values of
+ * the inputs of its expression.
+ */
+struct cached_result {
+    struct lru_entry    entry;
+    unsigned long long  serial;
+    unsigned long       generation;
+    uint32_t            ninputs;
+    uint32_t            nresults;
+    double              values[];   /* the inputs, followed by the results */
+};
+
+struct rdpc_cache {
+    struct rdpc_ctx    *ctx;
+    struct lru         *expressions;
+    struct lru         *results;
+    unsigned char      *tokens;     /* the tokens of the source being evaluated */
+    size_t              ntokens;
+    size_t              tokenscap;
+    double             *values;     /* its inputs, followed by its results */
+    size_t              valuescap;
+    unsigned long long  serial;
+};
+
+/* Function Declaration */
+
+/**
+ * It reports an error of the specified context other than an analysis
+ * error, e.g., a usage error, whose message is formatted as specified.
+ *
+ * @param ctx    the context
+ * @param code   the error code
+ * @param format the format of the message
+ *
+ * @return -1
+ */
+static int
+fail(struct rdpc_ctx *ctx, int code, const char *format, ...);
+
+/**
+ * It compiles and optimizes the specified source.
+ * <p>
+ * If the source has an error, then its errors are left in the parser
+ * of the context.
+ *
+ * @param ctx    the context
+ * @param source the source
+ * @param len    the source length
+ *
+ * @return the optimized program, or NULL if the source has an error
+ */
+static struct program *
+build(struct rdpc_ctx *ctx, const char *source, size_t len);
+
+/**
+ * It compiles the specified expression again if a variable it may rely
+ * on has been defined anew, forgetting its incremental evaluation.
+ *
+ * @param ctx  the context
+ * @param expr the expression
+ *
+ * @return zero, or -1 if the expression could not be compiled again
+ */
+static int
+refresh(struct rdpc_ctx *ctx, struct rdpc_expr *expr);
+
+/**
+ * It returns the symbol identifier of the specified variable name.
+ * <p>
+ * If the name is not a variable name, e.g., a math function or a
+ * number, then a usage error is reported.
+ *
+ * @param ctx  the context
+ * @param name the variable name, null-terminated
+ *
+ * @return the symbol identifier, or INTERN_NONE if the name is not a
+ *         variable name
+ */
+static unsigned
+variable(struct rdpc_ctx *ctx, const char *name);
+
+/**
+ * It returns the amount of symbols interned by the specified context.
+ *
+ * @param ctx the context
+ *
+ * @return the amount of symbols
+ */
+static unsigned
+symbols(const struct rdpc_ctx *ctx);
+
+/**
+ * It forgets the symbols interned by the specified context after the
+ * specified amount of symbols, e.g., the names of a source which has
+ * failed to compile, such that a failed call does not keep growing the
+ * context.
+ *
+ * @param ctx   the context
+ * @param count the amount of symbols to be kept
+ */
+static void
+forget(struct rdpc_ctx *ctx, unsigned count);
+
+/**
+ * It grows the variables of the specified context to fit at least the
+ * specified amount of variables, and its frame to fit at least the
+ * specified amount of doubles.
+ * <p>
+ * If there is not enough memory, then a memory error is reported, and
+ * the storage which could not be grown is left as it was.
+ *
+ * @param ctx      the context
+ * @param nvalues  the amount of variables
+ * @param framelen the amount of doubles of the frame
+ *
+ * @return zero, or -1 if the storage could not be grown
+ */
+static int
+reserve(struct rdpc_ctx *ctx, size_t nvalues, size_t framelen);
+
+/**
+ * It normalizes the specified source into the tokens of the specified
+ * cache, i.e., the type of each token followed by its symbol identifier
+ * or its value, such that the blanks of the source are left out.
+ *
+ * @param cache  the cache
+ * @param source the source
+ * @param len    the source length
+ *
+ * @return zero, or -1 if the source has a lexical error or its tokens
+ *         could not be allocated
+ */
+static int
+tokenize(struct rdpc_cache *cache, const char *source, size_t len);
+
+/**
+ * It calculates a hash code for the specified bytes, continuing from
+ * the specified hash code.
+ * <p>
+ * <b>Implementation Notes:</b>
+ * As the hash table, this function implements the FNV-1a Hash Algorithm
+ * mixed by the MurmurHash3 finalizer, since the cache selects a bucket
+ * by the lowest bits, although it takes a word of the bytes at a time,
+ * whose high bits are folded back into the low ones.
+ *
+ * @param bytes the bytes
+ * @param n     the amount of bytes
+ * @param seed  the hash code to continue from
+ *
+ * @return the hash code
+ */
+static uint64_t
+digest(const void *bytes, size_t n, uint64_t seed);
+
+/**
+ * It finds the inputs of the specified cached expression, and whether
+ * it is pure, for the definitions it has been compiled against.
+ * <p>
+ * If the inputs could not be allocated, then the cached expression is
+ * left as it was.
+ *
+ * @param cached the cached expression
+ *
+ * @return zero, or -1 if the inputs could not be allocated
+ */
+static int
+find_inputs(struct cached_expr *cached);
+
+/**
+ * It returns the amount of bytes the specified expression is charged
+ * for by a cache.
+ *
+ * @param expr the expression
+ *
+ * @return the amount of bytes
+ */
+static size_t
+footprint(const struct rdpc_expr *expr);
+
+/**
+ * It evaluates the specified expression, which is not cached, into the
+ * values of the specified cache and frees it.
+ *
+ * @param cache    the cache
+ * @param expr     the expression, or NULL if it has failed to compile
+ * @param nresults the placeholder for the amount of results
+ *
+ * @return the value of each result, or NULL if the expression is NULL
+ *         or could not be evaluated
+ */
+static const double *
+evaluate_once(struct rdpc_cache *cache, struct rdpc_expr *expr, size_t *nresults);
+
+/**
+ * It grows the values of the specified cache to fit at least the
+ * specified amount of doubles.
+ * <p>
+ * If there is not enough memory, then a memory error is reported, and
+ * the values are left as they were.
+ *
+ * @param cache the cache
+ * @param n     the amount of doubles
+ *
+ * @return zero, or -1 if the values could not be grown
+ */
+static int
+reserve_values(struct rdpc_cache *cache, size_t n);
+
+/**
+ * It tells whether the specified cached expression has the tokens of
+ * the specified cache.
+ *
+ * @param entry the cached expression
+ * @param key   the cache
+ *
+ * @return non-zero if the tokens are the same, zero otherwise
+ */
+static int
+same_tokens(const struct lru_entry *entry, const void *key);
+
+/**
+ * It tells whether the specified cached result has the expression and
+ * the input values of the specified result.
+ *
+ * @param entry the cached result
+ * @param key   the result being looked up, whose results are unset
+ *
+ * @return non-zero if the keys are the same, zero otherwise
+ */
+static int
+same_result(const struct lru_entry *entry, const void *key);
+
+/**
+ * It frees the specified evicted expression.
+ *
+ * @param entry the cached expression
+ * @param arg   unused
+ */
+static void
+release_expr(struct lru_entry *entry, void *arg);
+
+/**
+ * It frees the specified evicted result.
+ *
+ * @param entry the cached result
+ * @param arg   unused
+ */
+static void
+release_result(struct lru_entry *entry, void *arg);
+
+/* Function Definition */
+
+struct rdpc_ctx *
+rdpc_ctx_new(void) {
+    struct rdpc_ctx *ctx = calloc(1, sizeof(struct rdpc_ctx));
+
+    /* It checks if the context could not be allocated */
+    if (!ctx)
+        return NULL;
+
+    ctx->parser = parser_new();
+
+    /* The storage is never empty, since it is copied from and to */
+    if (reserve(ctx, 1, 1) < 0) {
+        rdpc_ctx_free(ctx);
+        return NULL;
+    }
+
+    return ctx;
+}
+
+void
+rdpc_ctx_free(struct rdpc_ctx *ctx) {
+    parser_free(ctx->parser);
+    free(ctx->values);
+    free(ctx->frame);
+    free(ctx);
+}
+
+struct rdpc_expr *
+rdpc_compile(struct rdpc_ctx *ctx, const char *source, const size_t len) {
+    struct rdpc_expr *expr;
+    struct program   *program;
+
+    /* It checks if the expression could not be allocated, before its */
+    /* definitions are kept by the context */
+    if (!(expr = malloc(sizeof(struct rdpc_expr) + len))) {
+        fail(ctx, RDPC_ERROR_MEMORY, "rdpc: An expression of %zu characters could not be allocated.", len);
+        return NULL;
+    }
+
+    if (!(program = build(ctx, source, len))) {
+        free(expr);
+        return NULL;
+    }
+
+    expr->ctx         = ctx;
+    expr->program     = program;
+    expr->incremental = NULL;
+    expr->outputs     = NULL;
+    expr->generation  = definitions(ctx->parser);
+    expr->nresults   = program->nresults;
+    expr->len        = len;
+    memcpy(expr->source, source, len);
+
+    return expr;
+}
+
+size_t
+rdpc_results(const struct rdpc_expr *expr) {
+    return expr->nresults;
+}
+
+int
+rdpc_eval(struct rdpc_ctx *ctx, struct rdpc_expr *expr, double *results) {
+    const struct program *program;
+
+    if (refresh(ctx, expr) < 0)
+        return -1;
+
+    program = expr->program;
+    if (reserve(ctx, program->nslots, program_frame_size(program)) < 0)
+        return -1;
+
+    /* It checks if the expression is evaluated incrementally. If so, */
+    /* its evaluation is kept up to date, which evaluates it in full */
+    if (expr->incremental) {
+        incremental_update(expr->incremental, ctx->values, NULL);
+        if (program->nresults)
+            memcpy(results, incremental_frame(expr->incremental) + program->nslots,
+                   sizeof(double) * program->nresults);
+        return 0;
+    }
+
+    /* The variables keep their values across the evaluations, */
+    /* whereas the frame only fits the program being evaluated */
+    memcpy(ctx->frame, ctx->values, sizeof(double) * program->nslots);
+    evaluate(program, ctx->frame);
+    memcpy(ctx->values, ctx->frame, sizeof(double) * program->nslots);
+
+    if (program->nresults)
+        memcpy(results, ctx->frame + program->nslots, sizeof(double) * program->nresults);
+
+    return 0;
+}
+
+int
+rdpc_update(struct rdpc_ctx *ctx, struct rdpc_expr *expr, double *results, size_t *changed, size_t *nchanged) {
+    const struct program *program;
+    const double         *frame;
+    uint32_t              n;
+
+    if (refresh(ctx, expr) < 0)
+        return -1;
+
+    program = expr->program;
+    if (reserve(ctx, program->nslots, 0) < 0)
+        return -1;
+
+    /* It checks if the expression has not been updated yet */
+    if (!expr->incremental) {
+        /* It checks if the changed results could not be allocated */
+        if (!(expr->outputs = malloc(sizeof(uint32_t) * (program->nresults + 1))))
+            return fail(ctx, RDPC_ERROR_MEMORY, "rdpc: The results of an expression could not be allocated.");
+
+        expr->incremental = incremental_new(program);
+    }
+
+    n     = incremental_update(expr->incremental, ctx->values, expr->outputs);
+    frame = incremental_frame(expr->incremental);
+    for (uint32_t i = 0; i < n; i++) {
+        changed[i]                = expr->outputs[i];
+        results[expr->outputs[i]] = frame[program->nslots + expr->outputs[i]];
+    }
+    *nchanged = n;
+
+    return 0;
+}
+
+int
+rdpc_set_var(struct rdpc_ctx *ctx, const char *name, const double value) {
+    const unsigned count = symbols(ctx);
+    const unsigned id    = variable(ctx, name);
+
+    /* The variables are grown before the variable is declared, such */
+    /* that the context is left as it was if they cannot be */
+    if (id == INTERN_NONE)
+        return -1;
+    if (reserve(ctx, (size_t)id + 1, 0) < 0) {
+        forget(ctx, count);
+        return -1;
+    }
+
+    /* It checks if the variable is read-only */
+    if (declare(ctx->parser, id) < 0)
+        return fail(ctx, RDPC_ERROR_USAGE, "rdpc: Variable `%s` cannot be re-assigned since it is read-only.", name);
+
+    ctx->values[id] = value;
+
+    return 0;
+}
+
+int
+rdpc_get_var(const struct rdpc_ctx *ctx, const char *name, double *value) {
+    const struct parser *parser = ctx->parser;
+    unsigned             id;
+
+    /* It checks if no input has been analyzed yet */
+    if (!parser->lexer.symbols)
+        return -1;
+
+    id = intern_find(parser->lexer.symbols, name, strlen(name));
+
+    /* It checks if the variable is not defined */
+    if (id == INTERN_NONE || id >= parser->nvars || !(parser->vars[id].flags & IS_DEFINED))
+        return -1;
+
+    *value = id < ctx->nvalues ? ctx->values[id] : 0.0;
+
+    return 0;
+}
+
+const char *
+rdpc_error(const struct rdpc_ctx *ctx) {
+    return ctx->parser->lexer.error.message;
+}
+
+/* The analysis errors are reported with their own codes */
+_Static_assert(ANALYSIS_LEXICAL == RDPC_ERROR_LEXICAL && ANALYSIS_SYNTAX == RDPC_ERROR_SYNTAX &&
+               ANALYSIS_SEMANTIC == RDPC_ERROR_SEMANTIC, "The analysis error codes must match the library ones.");
+
+size_t
+rdpc_errors(const struct rdpc_ctx *ctx, struct rdpc_status *errors, const size_t n) {
+    const struct analysis_error *first = ctx->usage ? &ctx->parser->lexer.error : ctx->parser->errors;
+    const size_t                 count = ctx->usage ? 1 : ctx->parser->nerrors;
+
+    for (size_t i = 0; i < count && i < n; i++) {
+        errors[i].code      = (int)first[i].code;
+        errors[i].line      = first[i].line;
+        errors[i].column    = first[i].column;
+        errors[i].statement = first[i].statement;
+        errors[i].message   = first[i].message;
+    }
+
+    return count;
+}
+
+void
+rdpc_expr_free(struct rdpc_expr *expr) {
+    if (expr->incremental)
+        incremental_free(expr->incremental);
+    free(expr->outputs);
+    program_free(expr->program);
+    free(expr);
+}
+
+struct rdpc_cache *
+rdpc_cache_new(struct rdpc_ctx *ctx, const size_t expressions, const size_t results) {
+    struct rdpc_cache *cache = calloc(1, sizeof(struct rdpc_cache));
+
+    /* It checks if the cache could not be allocated */
+    if (!cache)
+        return NULL;
+
+    cache->ctx         = ctx;
+    cache->expressions = lru_new(expressions, release_expr, NULL);
+    cache->results     = lru_new(results, release_result, NULL);
+
+    return cache;
+}
+
+const double *
+rdpc_cache_eval(struct rdpc_cache *cache, const char *source, const size_t len, size_t *nresults) {
+    struct rdpc_ctx      *ctx = cache->ctx;
+    struct cached_expr   *cached;
+    struct cached_result *result;
+    struct cached_result *key;
+    struct rdpc_expr     *expr;
+    double               *inputs;
+    uint64_t              hash;
+    const unsigned        count = symbols(ctx);
+
+    /* A source which is not even made of tokens, or whose tokens */
+    /* could not be allocated, is compiled anyway without caching it, */
+    /* such that its errors are reported as usual */
+    if (tokenize(cache, source, len) < 0) {
+        if (!(expr = rdpc_compile(ctx, source, len)))
+            forget(ctx, count);
+        return evaluate_once(cache, expr, nresults);
+    }
+
+    hash   = digest(cache->tokens, cache->ntokens, 0);
+    cached = (struct cached_expr *)lru_find(cache->expressions, hash, same_tokens, cache);
+
+    if (!cached) {
+        /* The names interned by the tokens are forgotten as well */
+        if (!(expr = rdpc_compile(ctx, source, len))) {
+            forget(ctx, count);
+            return NULL;
+        }
+
+        /* It checks if the cached expression could not be allocated, */
+        /* in which case the expression is evaluated without caching it */
+        if (!(cached = malloc(sizeof(struct cached_expr) + cache->ntokens)))
+            return evaluate_once(cache, expr, nresults);
+
+        cached->entry.hash = hash;
+        cached->entry.size = sizeof(struct cached_expr) + cache->ntokens + footprint(expr);
+        cached->expr       = expr;
+        cached->serial     = ++cache->serial;
+        cached->inputs     = NULL;
+        cached->ntokens    = cache->ntokens;
+        memcpy(cached->tokens, cache->tokens, cache->ntokens);
+
+        /* It checks if the inputs could not be found or if the */
+        /* expression alone is larger than the cache */
+        if (find_inputs(cached) < 0 || lru_insert(cache->expressions, &cached->entry) < 0) {
+            free(cached->inputs);
+            free(cached);
+            return evaluate_once(cache, expr, nresults);
+        }
+    }
+
+    expr = cached->expr;
+    if (refresh(ctx, expr) < 0)
+        return NULL;
+
+    /* The inputs of an expression compiled again may differ, */
+    /* e.g., a variable defined anew as a constant is folded */
+    if (cached->generation != expr->generation && find_inputs(cached) < 0) {
+        fail(ctx, RDPC_ERROR_MEMORY, "rdpc: The inputs of an expression could not be allocated.");
+        return NULL;
+    }
+
+    if (reserve_values(cache, sizeof(struct cached_result) / sizeof(double) + 1 + cached->ninputs + expr->nresults) < 0
+            || reserve(ctx, expr->program->nslots, 0) < 0)
+        return NULL;
+    *nresults = expr->nresults;
+
+    /* The results of an expression storing a variable are never */
+    /* cached, since its evaluation must store the variable again */
+    if (!cached->pure || !cache->results->limit)
+        return rdpc_eval(ctx, expr, cache->values) < 0 ? NULL : cache->values;
+
+    /* The key is laid out as a cached result, whose results follow */
+    key             = (struct cached_result *)cache->values;
+    key->serial     = cached->serial;
+    key->generation = expr->generation;
+    key->ninputs    = cached->ninputs;
+    key->nresults   = (uint32_t)expr->nresults;
+    inputs          = key->values;
+    for (uint32_t k = 0; k < cached->ninputs; k++)
+        inputs[k] = ctx->values[cached->inputs[k]];
+
+    hash   = digest(inputs, sizeof(double) * cached->ninputs,
+                    digest(&key->generation, sizeof(unsigned long), cached->entry.hash ^ cached->serial));
+    result = (struct cached_result *)lru_find(cache->results, hash, same_result, key);
+
+    if (result) {
+        memcpy(inputs + cached->ninputs, result->values + result->ninputs, sizeof(double) * result->nresults);
+        return inputs + cached->ninputs;
+    }
+
+    if (rdpc_eval(ctx, expr, inputs + cached->ninputs) < 0)
+        return NULL;
+
+    /* It checks if the cached result could not be allocated, in */
+    /* which case the results are returned without caching them */
+    if (!(result = malloc(sizeof(struct cached_result) + sizeof(double) * (cached->ninputs + expr->nresults))))
+        return inputs + cached->ninputs;
+
+    memcpy(result, key, sizeof(struct cached_result) + sizeof(double) * (cached->ninputs + expr->nresults));
+    result->entry.hash = hash;
+    result->entry.size = sizeof(struct cached_result) + sizeof(double) * (cached->ninputs + expr->nresults);
+    if (lru_insert(cache->results, &result->entry) < 0)
+        free(result);
+
+    return inputs + cached->ninputs;
+}
+
+void
+rdpc_cache_stats(const struct rdpc_cache *cache, struct rdpc_cache_stats *stats) {
+    stats->hits             = cache->expressions->hits;
+    stats->misses           = cache->expressions->misses;
+    stats->evictions        = cache->expressions->evictions;
+    stats->result_hits      = cache->results->hits;
+    stats->result_misses    = cache->results->misses;
+    stats->result_evictions = cache->results->evictions;
+    stats->expressions      = cache->expressions->count;
+    stats->expression_bytes = cache->expressions->used;
+    stats->results          = cache->results->count;
+    stats->result_bytes     = cache->results->used;
+}
+
+void
+rdpc_cache_free(struct rdpc_cache *cache) {
+    lru_free(cache->expressions);
+    lru_free(cache->results);
+    free(cache->tokens);
+    free(cache->values);
+    free(cache);
+}
+
+/* Static Function Definition */
+
+static int
+fail(struct rdpc_ctx *ctx, const int code, const char *format, ...) {
+    struct analysis_error *error = &ctx->parser->lexer.error;
+    va_list                args;
+
+    va_start(args, format);
+    vsnprintf(error->message, sizeof(error->message), format, args);
+    va_end(args);
+
+    error->code      = code;
+    error->line      = 0;
+    error->column    = 0;
+    error->statement = 0;
+    ctx->usage       = 1;
+
+    return -1;
+}
+
+static struct program *
+build(struct rdpc_ctx *ctx, const char *source, const size_t len) {
+    struct lexer   *lexer = &ctx->parser->lexer;
+    struct program *compiled;
+    struct program *program;
+    const unsigned  count = symbols(ctx);
+
+    init_lexer_buffer(lexer, source, len);
+    ctx->usage = 0;
+
+    /* The definitions of a source which has failed to compile are */
+    /* undone by the parser, and its names are forgotten here */
+    if (!(compiled = compile_resident(ctx->parser))) {
+        forget(ctx, count);
+        return NULL;
+    }
+
+    program = optimize(compiled);
+    program_free(compiled);
+
+    return program;
+}
+
+static int
+refresh(struct rdpc_ctx *ctx, struct rdpc_expr *expr) {
+    struct program *rebuilt;
+
+    /* It checks if the expression has been compiled by another context */
+    if (expr->ctx != ctx)
+        return fail(ctx, RDPC_ERROR_USAGE, "rdpc: The expression has been compiled by another context.");
+
+    /* It checks if the expression may rely on former definitions */
+    if (expr->generation == definitions(ctx->parser))
+        return 0;
+
+    if (!(rebuilt = build(ctx, expr->source, expr->len)))
+        return -1;
+
+    /* The incremental evaluation refers to the former program */
+    if (expr->incremental) {
+        incremental_free(expr->incremental);
+        free(expr->outputs);
+        expr->incremental = NULL;
+        expr->outputs     = NULL;
+    }
+
+    program_free(expr->program);
+    expr->program    = rebuilt;
+    expr->generation = definitions(ctx->parser);
+
+    return 0;
+}
+
+static unsigned
+variable(struct rdpc_ctx *ctx, const char *name) {
+    struct lexer      *lexer    = &ctx->parser->lexer;
+    jmp_buf *const     previous = lexer->recovery;
+    jmp_buf            recovery;
+    volatile unsigned  id       = INTERN_NONE;
+    const unsigned     count    = symbols(ctx);
+
+    init_lexer_buffer(lexer, name, strlen(name));
+    lexer->recovery = &recovery;
+
+    /* It checks if the name is a single identifier, which has returned */
+    /* here if it is not even a token */
+    if (!setjmp(recovery)) {
+        const struct token *token = next_token(lexer);
+
+        if (token->type == LEXER_TOKEN_ID) {
+            id = token->metadata.id;
+            if (next_token(lexer)->type != LEXER_TOKEN_EOF)
+                id = INTERN_NONE;
+        }
+    }
+
+    lexer->recovery = previous;
+
+    if (id == INTERN_NONE) {
+        forget(ctx, count);
+        fail(ctx, RDPC_ERROR_USAGE, "rdpc: `%s` is not a variable name.", name);
+    }
+
+    return id;
+}
+
+static unsigned
+symbols(const struct rdpc_ctx *ctx) {
+    const struct intern_pool *pool = ctx->parser->lexer.symbols;
+
+    return pool ? pool->count : 0;
+}
+
+static void
+forget(struct rdpc_ctx *ctx, const unsigned count) {
+    struct intern_pool *pool = ctx->parser->lexer.symbols;
+
+    if (pool)
+        intern_truncate(pool, count);
+}
+
+static int
+reserve(struct rdpc_ctx *ctx, const size_t nvalues, const size_t framelen) {
+    if (nvalues > ctx->nvalues) {
+        size_t  newlen = ctx->nvalues ? ctx->nvalues << 1 : 16;
+        double *values;
+
+        while (newlen < nvalues) newlen <<= 1;
+
+        if (!(values = realloc(ctx->values, sizeof(double) * newlen)))
+            return fail(ctx, RDPC_ERROR_MEMORY, "rdpc: %zu variables could not be allocated.", newlen);
+        memset(values + ctx->nvalues, 0, sizeof(double) * (newlen - ctx->nvalues));
+
+        ctx->values  = values;
+        ctx->nvalues = newlen;
+    }
+
+    if (framelen > ctx->framelen) {
+        size_t  newlen = ctx->framelen ? ctx->framelen << 1 : 64;
+        double *frame;
+
+        while (newlen < framelen) newlen <<= 1;
+
+        if (!(frame = realloc(ctx->frame, sizeof(double) * newlen)))
+            return fail(ctx, RDPC_ERROR_MEMORY, "rdpc: An evaluation frame of %zu values could not be allocated.",
+                        newlen);
+
+        ctx->frame    = frame;
+        ctx->framelen = newlen;
+    }
+
+    return 0;
+}
+
+static int
+tokenize(struct rdpc_cache *cache, const char *source, const size_t len) {
+    struct lexer      *lexer    = &cache->ctx->parser->lexer;
+    jmp_buf *const     previous = lexer->recovery;
+    jmp_buf            recovery;
+    volatile int       status   = -1;
+
+    init_lexer_buffer(lexer, source, len);
+    lexer->recovery = &recovery;
+    cache->ntokens  = 0;
+
+    /* It checks if every token has been read, which has returned */
+    /* here if a character is not part of any token */
+    if (!setjmp(recovery)) {
+        const struct token *token;
+        unsigned char      *tokens;
+
+        for (;;) {
+            token = next_token(lexer);
+
+            /* A token takes a byte and at most a double */
+            if (cache->tokenscap - cache->ntokens < 1 + sizeof(double)) {
+                size_t newcap = cache->tokenscap ? cache->tokenscap << 1 : 256;
+
+                if (!(tokens = realloc(cache->tokens, newcap)))
+                    break;
+                cache->tokens    = tokens;
+                cache->tokenscap = newcap;
+            }
+
+            cache->tokens[cache->ntokens++] = (unsigned char)token->type;
+            if (token->type == LEXER_TOKEN_ID) {
+                memcpy(cache->tokens + cache->ntokens, &token->metadata.id, sizeof(unsigned));
+                cache->ntokens += sizeof(unsigned);
+            } else if (token->type == LEXER_TOKEN_NUMBER) {
+                memcpy(cache->tokens + cache->ntokens, &token->metadata.value, sizeof(double));
+                cache->ntokens += sizeof(double);
+            }
+
+            if (token->type == LEXER_TOKEN_EOF) {
+                status = 0;
+                break;
+            }
+        }
+    }
+
+    lexer->recovery = previous;
+
+    return status;
+}
+
+static uint64_t
+digest(const void *bytes, const size_t n, const uint64_t seed) {
+    const unsigned char *p    = bytes;
+    uint64_t             hash = 14695981039346656037ull ^ seed;
+    uint64_t             word;
+    size_t               i    = 0;
+
+    /* The bytes are mixed a word at a time, the last ones included */
+    for (; i + sizeof(uint64_t) <= n; i += sizeof(uint64_t)) {
+        memcpy(&word, p + i, sizeof(uint64_t));
+        hash = (hash ^ word) * 1099511628211ull;
+        hash ^= hash >> 29;
+    }
+    for (; i < n; i++)
+        hash = (hash ^ p[i]) * 1099511628211ull;
+    hash ^= hash >> 33;
+    hash *= 0xFF51AFD7ED558CCDull;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+static int
+find_inputs(struct cached_expr *cached) {
+    const struct program *program = cached->expr->program;
+    uint32_t             *inputs;
+    uint32_t              n       = 0;
+
+    /* It checks if the inputs could not be allocated */
+    if (!(inputs = malloc(sizeof(uint32_t) * (program->nslots + 1))))
+        return -1;
+
+    free(cached->inputs);
+    cached->inputs = inputs;
+
+    /* The loads are shared, hence, a slot is read by a single load */
+    /* without a store */
+    cached->pure = 1;
+    for (uint32_t i = 0; i < program->count; i++) {
+        if (program->nodes[i].op == AST_LOAD && program->nodes[i].rhs == AST_NONE)
+            cached->inputs[n++] = program->nodes[i].aux;
+        else if (program->nodes[i].op == AST_STORE)
+            cached->pure = 0;
+    }
+
+    cached->ninputs    = n;
+    cached->generation = cached->expr->generation;
+
+    return 0;
+}
+
+static size_t
+footprint(const struct rdpc_expr *expr) {
+    const struct program *program = expr->program;
+
+    return sizeof(struct rdpc_expr) + expr->len + sizeof(struct program)
+           + sizeof(struct ast_node) * program->capacity + sizeof(double) * program->constscap
+           + sizeof(uint32_t) * 2 * program->slotscap + (program->index ? sizeof(uint32_t) * (program->mask + 1) : 0)
+           + sizeof(struct ast_statement) * program->statementscap + sizeof(uint32_t) * program->depscap;
+}
+
+static const double *
+evaluate_once(struct rdpc_cache *cache, struct rdpc_expr *expr, size_t *nresults) {
+    int status;
+
+    if (!expr)
+        return NULL;
+
+    status = reserve_values(cache, expr->nresults) < 0 ? -1 : rdpc_eval(cache->ctx, expr, cache->values);
+    *nresults = expr->nresults;
+    rdpc_expr_free(expr);
+
+    return status < 0 ? NULL : cache->values;
+}
+
+static int
+reserve_values(struct rdpc_cache *cache, const size_t n) {
+    if (n > cache->valuescap) {
+        size_t  newcap = cache->valuescap ? cache->valuescap << 1 : 64;
+        double *values;
+
+        while (newcap < n) newcap <<= 1;
+
+        if (!(values = realloc(cache->values, sizeof(double) * newcap)))
+            return fail(cache->ctx, RDPC_ERROR_MEMORY, "rdpc: %zu cached values could not be allocated.", newcap);
+        cache->values    = values;
+        cache->valuescap = newcap;
+    }
+
+    return 0;
+}
+
+static int
+same_tokens(const struct lru_entry *entry, const void *key) {
+    const struct cached_expr *cached = (const struct cached_expr *)entry;
+    const struct rdpc_cache  *cache  = key;
+
+    return cached->ntokens == cache->ntokens && !memcmp(cached->tokens, cache->tokens, cache->ntokens);
+}
+
+static int
+same_result(const struct lru_entry *entry, const void *key) {
+    const struct cached_result *cached = (const struct cached_result *)entry;
+    const struct cached_result *result = key;
+
+    return cached->serial == result->serial && cached->generation == result->generation
+           && cached->ninputs == result->ninputs
+           && !memcmp(cached->values, result->values, sizeof(double) * result->ninputs);
+}
+
+static void
+release_expr(struct lru_entry *entry, void *arg) {
+    struct cached_expr *cached = (struct cached_expr *)entry;
+
+    (void)arg;
+    rdpc_expr_free(cached->expr);
+    free(cached->inputs);
+    free(cached);
+}
+
+static void
+release_result(struct lru_entry *entry, void *arg) {
+    (void)arg;
+    free(entry);
+}
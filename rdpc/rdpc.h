@@ -0,0 +1,329 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Ricardo Fares
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef RDPC_H
+#define RDPC_H
+
+#include <stddef.h>
+
+/**
+ * The embeddable calculator library.
+ * <p>
+ * A context holds the variables and the symbols of its expressions, and
+ * it does not share any state with the other contexts. Therefore, the
+ * contexts may be used concurrently by distinct threads, as long as a
+ * single context is not used by two threads at a time.
+ * <p>
+ * The errors of the expressions are reported by the return value of the
+ * functions, and their message is kept by the context, rather than the
+ * application being exited. Likewise, a failure to allocate the storage
+ * of the library is reported as a memory error, which leaves the context
+ * as it was.
+ */
+
+/**
+ * Error codes definition.
+ * <p>
+ * The errors of a source are lexical, syntax or semantic errors, e.g.,
+ * an undeclared variable, whereas the other errors are usage errors of
+ * the library, e.g., an invalid variable name, or memory errors.
+ */
+#define RDPC_ERROR_LEXICAL  (1)
+#define RDPC_ERROR_SYNTAX   (2)
+#define RDPC_ERROR_SEMANTIC (3)
+#define RDPC_ERROR_USAGE    (4)
+#define RDPC_ERROR_MEMORY   (5)
+
+/* Structure Declarations */
+
+/**
+ * A calculator context, opaque to its users.
+ */
+struct rdpc_ctx;
+
+/**
+ * An expression compiled by a context, opaque to its users.
+ */
+struct rdpc_expr;
+
+/**
+ * A cache of the expressions compiled by a context and of their
+ * results, opaque to its users.
+ */
+struct rdpc_cache;
+
+/**
+ * An error reported by a context.
+ * <p>
+ * The position of a usage error is zero, since it has no source.
+ */
+struct rdpc_status {
+    int                code;      /* the error code */
+    unsigned long long line;      /* the line of the error in its source, from 1 */
+    unsigned long long column;    /* the column of the error in its line, from 1 */
+    unsigned           statement; /* the statement of the error in its source, from 0 */
+    const char        *message;   /* the message, valid until the next call on the context */
+};
+
+/**
+ * The counters of a cache.
+ * <p>
+ * The results are only looked up for the expressions which do not
+ * define any variable, hence, the lookups of the results may be less
+ * than the ones of the expressions.
+ */
+struct rdpc_cache_stats {
+    unsigned long long hits;             /* the sources whose expression was cached */
+    unsigned long long misses;           /* the sources compiled */
+    unsigned long long evictions;        /* the expressions evicted */
+    unsigned long long result_hits;      /* the evaluations whose results were cached */
+    unsigned long long result_misses;    /* the evaluations performed */
+    unsigned long long result_evictions; /* the results evicted */
+    size_t             expressions;      /* the expressions cached */
+    size_t             expression_bytes; /* the bytes the expressions are charged for */
+    size_t             results;          /* the results cached */
+    size_t             result_bytes;     /* the bytes the results are charged for */
+};
+
+/* Function Declaration */
+
+/**
+ * It allocates a context without any variable defined.
+ *
+ * @return the context, which must be freed by <em>rdpc_ctx_free</em>,
+ *         or NULL if it could not be allocated
+ */
+struct rdpc_ctx *
+rdpc_ctx_new(void);
+
+/**
+ * It frees the specified context. The expressions compiled by the
+ * context must be freed before.
+ *
+ * @param ctx the context
+ */
+void
+rdpc_ctx_free(struct rdpc_ctx *ctx);
+
+/**
+ * It compiles the specified source into an expression of the specified
+ * context, which may be evaluated any amount of times.
+ * <p>
+ * The source is a program, whose statements are separated by semicolons,
+ * as the calculator input. Its definitions remain for the expressions
+ * compiled next by the context, whereas if the source has an error, then
+ * they are forgotten. Every statement of the source is analyzed, hence,
+ * each statement having an error reports its own error.
+ *
+ * @param ctx    the context
+ * @param source the source, not necessarily null-terminated
+ * @param len    the source length
+ *
+ * @return the expression, which must be freed by <em>rdpc_expr_free</em>,
+ *         or NULL if the source has an error, whose message is given by
+ *         <em>rdpc_error</em>
+ */
+struct rdpc_expr *
+rdpc_compile(struct rdpc_ctx *ctx, const char *source, size_t len);
+
+/**
+ * It returns the amount of results of the specified expression.
+ *
+ * @param expr the expression
+ *
+ * @return the amount of results
+ */
+size_t
+rdpc_results(const struct rdpc_expr *expr);
+
+/**
+ * It evaluates the specified expression over the variables of the
+ * specified context, which must have compiled it.
+ * <p>
+ * If a variable the expression relies on has been defined anew with
+ * other flags, e.g., as a constant, then the expression is compiled
+ * again from its source beforehand.
+ *
+ * @param ctx     the context
+ * @param expr    the expression
+ * @param results the placeholder for the value of each result, which
+ *                has <em>rdpc_results(expr)</em> doubles
+ *
+ * @return zero, or -1 if the expression could not be compiled again,
+ *         whose message is given by <em>rdpc_error</em>
+ */
+int
+rdpc_eval(struct rdpc_ctx *ctx, struct rdpc_expr *expr, double *results);
+
+/**
+ * It evaluates again the results of the specified expression which
+ * depend on the variables changed since its last evaluation, e.g., by
+ * <em>rdpc_set_var</em>, as a spreadsheet does.
+ * <p>
+ * The expression keeps the graph of its definitions and results, in
+ * which each statement points to the statements referring to it, hence,
+ * only the transitive dependents of the changed variables are evaluated,
+ * and a statement whose value has not changed stops the propagation.
+ * The first update of an expression evaluates it in full, and every
+ * result has changed.
+ * <p>
+ * The results are the same as the ones of <em>rdpc_eval</em>, whereas a
+ * variable stored by the expression which has been set since is only
+ * stored again if its definition is evaluated again, unless the
+ * expression reads it before storing it.
+ *
+ * @param ctx      the context
+ * @param expr     the expression
+ * @param results  the value of each result, which has
+ *                 <em>rdpc_results(expr)</em> doubles, whose changed
+ *                 results are written
+ * @param changed  the placeholder for the indices of the changed
+ *                 results, in ascending order, which has
+ *                 <em>rdpc_results(expr)</em> indices
+ * @param nchanged the placeholder for the amount of changed results
+ *
+ * @return zero, or -1 if the expression could not be compiled again,
+ *         whose message is given by <em>rdpc_error</em>
+ */
+int
+rdpc_update(struct rdpc_ctx *ctx, struct rdpc_expr *expr, double *results, size_t *changed, size_t *nchanged);
+
+/**
+ * It sets the specified variable of the specified context to the
+ * specified value, defining the variable if it is not defined.
+ *
+ * @param ctx   the context
+ * @param name  the variable name, null-terminated
+ * @param value the value
+ *
+ * @return zero, or -1 if the name is not a variable name or the variable
+ *         is read-only, whose message is given by <em>rdpc_error</em>
+ */
+int
+rdpc_set_var(struct rdpc_ctx *ctx, const char *name, double value);
+
+/**
+ * It retrieves the value of the specified variable of the specified
+ * context.
+ *
+ * @param ctx   the context
+ * @param name  the variable name, null-terminated
+ * @param value the placeholder for the value
+ *
+ * @return zero, or -1 if the variable is not defined
+ */
+int
+rdpc_get_var(const struct rdpc_ctx *ctx, const char *name, double *value);
+
+/**
+ * It returns the message of the last error of the specified context,
+ * i.e., of the first statement having an error for a compilation.
+ *
+ * @param ctx the context
+ *
+ * @return the message, without a trailing line break
+ */
+const char *
+rdpc_error(const struct rdpc_ctx *ctx);
+
+/**
+ * It retrieves the errors of the last failed call on the specified
+ * context, that is, one error per statement having an error for a
+ * compilation, or the usage error otherwise.
+ *
+ * @param ctx    the context
+ * @param errors the placeholder for the errors
+ * @param n      the amount of errors fitting in the placeholder
+ *
+ * @return the amount of errors, which may exceed <em>n</em>
+ */
+size_t
+rdpc_errors(const struct rdpc_ctx *ctx, struct rdpc_status *errors, size_t n);
+
+/**
+ * It frees the specified expression.
+ *
+ * @param expr the expression
+ */
+void
+rdpc_expr_free(struct rdpc_expr *expr);
+
+/**
+ * It allocates a cache of the expressions compiled by the specified
+ * context and of their results, bounded by the specified amounts of
+ * memory.
+ * <p>
+ * An expression is cached by the tokens of its source, rather than by
+ * its characters, hence, sources differing only by their blanks share
+ * their expression. A result is cached by the expression and by the
+ * values of the variables it reads, as long as the expression does not
+ * define any variable. The least recently used expressions and results
+ * are evicted once they are charged more than their limit.
+ *
+ * @param ctx         the context, which must outlive the cache
+ * @param expressions the bytes the cached expressions may be charged
+ *                    for, or zero for none to be cached
+ * @param results     the bytes the cached results may be charged for,
+ *                    or zero for none to be cached
+ *
+ * @return the cache, which must be freed by <em>rdpc_cache_free</em>,
+ *         or NULL if it could not be allocated
+ */
+struct rdpc_cache *
+rdpc_cache_new(struct rdpc_ctx *ctx, size_t expressions, size_t results);
+
+/**
+ * It evaluates the specified source over the variables of the context
+ * of the specified cache, as <em>rdpc_compile</em> and
+ * <em>rdpc_eval</em> do, reusing its cached expression and results.
+ *
+ * @param cache    the cache
+ * @param source   the source, not necessarily null-terminated
+ * @param len      the source length
+ * @param nresults the placeholder for the amount of results
+ *
+ * @return the value of each result, valid until the next call on the
+ *         cache, or NULL if the source has an error, whose message is
+ *         given by <em>rdpc_error</em>
+ */
+const double *
+rdpc_cache_eval(struct rdpc_cache *cache, const char *source, size_t len, size_t *nresults);
+
+/**
+ * It retrieves the counters of the specified cache.
+ *
+ * @param cache the cache
+ * @param stats the placeholder for the counters
+ */
+void
+rdpc_cache_stats(const struct rdpc_cache *cache, struct rdpc_cache_stats *stats);
+
+/**
+ * It frees the specified cache and every expression it has cached.
+ *
+ * @param cache the cache
+ */
+void
+rdpc_cache_free(struct rdpc_cache *cache);
+
+#endif // RDPC_H
@@ -4,7 +4,7 @@
 /**
  * It contains the flags of a variable descriptor.
  */
-enum semantic_flags_t { IS_CONSTANT = 1 };
+enum semantic_flags_t { IS_CONSTANT = 1, IS_DEFINED = 2 };
 
 /**
  * A variable descriptor that contains the semantic
@@ -0,0 +1,476 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Ricardo Fares
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#include "../rdpc/rdpc.h"
+#include "../output/output.h"
+#include "./serve.h"
+
+/**
+ * A connection of a client.
+ * <p>
+ * The responses are buffered until the socket is writable, and the
+ * requests of the connection are not read meanwhile, such that a client
+ * which does not read its responses cannot grow them without bound.
+ */
+struct connection {
+    int                fd;
+    uint32_t           events; /* the events being waited for */
+    char              *in;     /* the characters read but not served yet */
+    size_t             inlen;
+    size_t             incap;
+    char              *out;    /* the responses not sent yet */
+    size_t             outpos;
+    size_t             outlen;
+    size_t             outcap;
+    struct connection *prev;   /* the connections of the server */
+    struct connection *next;
+};
+
+/**
+ * A server of evaluation requests.
+ */
+struct server {
+    int                 listener;
+    int                 epoll;
+    int                 signals;
+    struct rdpc_ctx    *ctx;   /* the variables shared by the requests */
+    struct rdpc_cache  *cache; /* the expressions and results of the requests */
+    struct connection  *connections;
+    unsigned long long  served;
+    unsigned long long  failed;
+    unsigned long long  accepted;
+};
+
+/**
+ * It grows the specified storage to fit at least the specified minimum
+ * amount of elements, doubling its capacity.
+ * <p>
+ * If there is not enough memory, then the application is immediately
+ * terminated.
+ *
+ * @param storage  the storage to be grown
+ * @param capacity the storage capacity in elements, which is updated
+ * @param size     the size of a single element
+ * @param minimum  the minimum capacity in elements after growing
+ *
+ * @return the grown storage
+ */
+static void *
+grow(void *storage, size_t *capacity, const size_t size, const size_t minimum) {
+    size_t newcap = *capacity ? *capacity : 16;
+
+    while (newcap < minimum) newcap <<= 1;
+
+    if (!(storage = realloc(storage, size * newcap))) {
+        printf("serve: %zu elements could not be allocated.\n", newcap);
+        exit(EXIT_FAILURE);
+    }
+    *capacity = newcap;
+    return storage;
+}
+
+/**
+ * It appends the specified formatted response to the responses of the
+ * specified connection.
+ *
+ * @param c      the connection
+ * @param format the format of the response
+ */
+static void
+put(struct connection *c, const char *format, ...) {
+    va_list args;
+    int     n;
+
+    if (c->outcap - c->outlen < 64)
+        c->out = grow(c->out, &c->outcap, sizeof(char), c->outlen + 64);
+
+    for (;;) {
+        va_start(args, format);
+        n = vsnprintf(c->out + c->outlen, c->outcap - c->outlen, format, args);
+        va_end(args);
+
+        /* It checks if the response has fit in the buffer */
+        if (n >= 0 && (size_t)n < c->outcap - c->outlen) {
+            c->outlen += (size_t)n;
+            return;
+        }
+        c->out = grow(c->out, &c->outcap, sizeof(char), c->outlen + (n > 0 ? (size_t)n : 0) + 1);
+    }
+}
+
+/**
+ * It appends the response of the request of the specified connection
+ * which has just failed, holding the position and the message of the
+ * first error of the request.
+ *
+ * @param server the server
+ * @param c      the connection
+ */
+static void
+fail(struct server *server, struct connection *c) {
+    struct rdpc_status status;
+
+    server->failed++;
+    rdpc_errors(server->ctx, &status, 1);
+    put(c, "error %llu:%llu %s\n", status.line, status.column, status.message);
+}
+
+/**
+ * It serves the specified request of the specified connection, appending
+ * its response to the responses of the connection.
+ *
+ * @param server  the server
+ * @param c       the connection
+ * @param request the request, without its line break
+ * @param len     the request length
+ */
+static void
+respond(struct server *server, struct connection *c, const char *request, size_t len) {
+    const double *results;
+    const char   *nul;
+    size_t        nresults;
+
+    if (len > 0 && request[len - 1] == '\r')
+        len--;
+
+    server->served++;
+
+    /* The calculator takes a null character for the end of its input, */
+    /* hence, a request holding one is rejected rather than served in part */
+    if ((nul = memchr(request, '\0', len))) {
+        server->failed++;
+        put(c, "error 1:%zu serve: A request cannot hold a null character.\n", (size_t)(nul - request) + 1);
+        return;
+    }
+
+    /* The variables keep their values across the requests */
+    if (!(results = rdpc_cache_eval(server->cache, request, len, &nresults))) {
+        fail(server, c);
+        return;
+    }
+
+    put(c, "ok");
+    for (size_t i = 0; i < nresults; i++) {
+        if (c->outcap - c->outlen < OUTPUT_DOUBLE_MAX + 1)
+            c->out = grow(c->out, &c->outcap, sizeof(char), c->outlen + OUTPUT_DOUBLE_MAX + 1);
+        c->out[c->outlen++] = ' ';
+        c->outlen          += format_double(results[i], c->out + c->outlen);
+    }
+    put(c, "\n");
+}
+
+/**
+ * It closes the specified connection and frees it.
+ *
+ * @param server the server
+ * @param c      the connection
+ */
+static void
+hang_up(struct server *server, struct connection *c) {
+    if (c->prev)
+        c->prev->next = c->next;
+    else server->connections = c->next;
+    if (c->next)
+        c->next->prev = c->prev;
+
+    epoll_ctl(server->epoll, EPOLL_CTL_DEL, c->fd, NULL);
+    close(c->fd);
+    free(c->in);
+    free(c->out);
+    free(c);
+}
+
+/**
+ * It sends as many responses of the specified connection as the socket
+ * accepts without blocking.
+ *
+ * @param c the connection
+ *
+ * @return 0 if the connection is still open, -1 if it has been closed
+ */
+static int
+flush(struct connection *c) {
+    while (c->outpos < c->outlen) {
+        const ssize_t n = send(c->fd, c->out + c->outpos, c->outlen - c->outpos, MSG_NOSIGNAL);
+
+        if (n > 0)
+            c->outpos += (size_t)n;
+        else if (n < 0 && errno == EINTR)
+            continue;
+        else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            return 0;
+        else return -1;
+    }
+    c->outpos = c->outlen = 0;
+    return 0;
+}
+
+/**
+ * It handles the specified events of the specified connection, reading
+ * its requests, serving every whole request and sending the responses.
+ *
+ * @param server the server
+ * @param c      the connection
+ * @param events the events
+ */
+static void
+handle(struct server *server, struct connection *c, const uint32_t events) {
+    struct epoll_event event;
+    size_t             begin = 0;
+    char              *end;
+
+    if (events & (EPOLLERR | EPOLLHUP)) {
+        hang_up(server, c);
+        return;
+    }
+
+    if (events & EPOLLIN) {
+        ssize_t n;
+
+        if (c->incap - c->inlen < SERVE_READ)
+            c->in = grow(c->in, &c->incap, sizeof(char), c->inlen + SERVE_READ);
+
+        while ((n = recv(c->fd, c->in + c->inlen, c->incap - c->inlen, 0)) < 0 && errno == EINTR);
+
+        /* It checks if the client has closed the connection */
+        if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) {
+            hang_up(server, c);
+            return;
+        }
+        if (n > 0)
+            c->inlen += (size_t)n;
+
+        /* It serves the whole requests read so far */
+        while ((end = memchr(c->in + begin, '\n', c->inlen - begin))) {
+            respond(server, c, c->in + begin, (size_t)(end - c->in) - begin);
+            begin = (size_t)(end - c->in) + 1;
+        }
+        memmove(c->in, c->in + begin, c->inlen - begin);
+        c->inlen -= begin;
+
+        /* It checks if the request being read is too long to be served */
+        if (c->inlen > SERVE_LINE_MAX) {
+            put(c, "error serve: A request longer than %d characters cannot be served.\n", SERVE_LINE_MAX);
+            flush(c);
+            hang_up(server, c);
+            return;
+        }
+    }
+
+    if (flush(c) < 0) {
+        hang_up(server, c);
+        return;
+    }
+
+    /* It waits for the socket to be writable while there are responses */
+    /* left, and only then for the next requests */
+    event.events   = c->outlen > c->outpos ? EPOLLOUT : EPOLLIN;
+    event.data.ptr = c;
+    if (event.events != c->events) {
+        c->events = event.events;
+        epoll_ctl(server->epoll, EPOLL_CTL_MOD, c->fd, &event);
+    }
+}
+
+/**
+ * It accepts every pending connection of the specified server.
+ *
+ * @param server the server
+ */
+static void
+accept_all(struct server *server) {
+    for (;;) {
+        const int          fd = accept4(server->listener, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        struct connection *c;
+        struct epoll_event event;
+
+        if (fd < 0) {
+            /* It checks if the connections left are only refused for now, */
+            /* e.g., the descriptors are exhausted, so they are retried later */
+            if (errno == EINTR || errno == ECONNABORTED)
+                continue;
+            return;
+        }
+
+        if (!(c = calloc(1, sizeof(struct connection)))) {
+            close(fd);
+            continue;
+        }
+        c->fd          = fd;
+        c->events      = EPOLLIN;
+        event.events   = EPOLLIN;
+        event.data.ptr = c;
+
+        if (epoll_ctl(server->epoll, EPOLL_CTL_ADD, fd, &event) < 0) {
+            close(fd);
+            free(c);
+            continue;
+        }
+
+        if ((c->next = server->connections))
+            c->next->prev = c;
+        server->connections = c;
+        server->accepted++;
+    }
+}
+
+/**
+ * It creates the listening socket at the specified path.
+ * <p>
+ * If the socket could not be created, then the program is exited.
+ *
+ * @param path the path of the socket
+ *
+ * @return the listening socket
+ */
+static int
+listen_at(const char *path) {
+    struct sockaddr_un address = { .sun_family = AF_UNIX };
+    struct stat        st;
+    int                fd;
+
+    /* It checks if the path does not fit in the socket address */
+    if (strlen(path) >= sizeof(address.sun_path)) {
+        printf("serve: The socket path %s is longer than %zu characters.\n", path, sizeof(address.sun_path) - 1);
+        exit(EXIT_FAILURE);
+    }
+    strcpy(address.sun_path, path);
+
+    /* A socket left by a previous server is replaced, */
+    /* whereas any other file is kept */
+    if (0 == lstat(path, &st)) {
+        if (!S_ISSOCK(st.st_mode)) {
+            printf("serve: The path %s already exists and is not a socket.\n", path);
+            exit(EXIT_FAILURE);
+        }
+        unlink(path);
+    }
+
+    if ((fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0)) < 0 ||
+        bind(fd, (struct sockaddr *)&address, sizeof(address)) < 0 || listen(fd, SERVE_BACKLOG) < 0) {
+        printf("serve: The socket %s could not be created (%s).\n", path, strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+
+    return fd;
+}
+
+void
+serve(const char *path, const size_t expressions, const size_t results, const int stats) {
+    struct server      server = { 0 };
+    struct epoll_event events[SERVE_EVENTS];
+    struct epoll_event event;
+    struct rlimit      limit;
+    sigset_t           mask;
+    int                running = 1;
+
+    /* Each client takes a descriptor, hence, as many as allowed are used */
+    if (0 == getrlimit(RLIMIT_NOFILE, &limit) && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+
+    /* The interruptions are read from the event loop, such that */
+    /* the server stops between requests */
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGINT);
+    sigaddset(&mask, SIGTERM);
+    sigprocmask(SIG_BLOCK, &mask, NULL);
+
+    server.listener = listen_at(path);
+    server.epoll    = epoll_create1(EPOLL_CLOEXEC);
+    server.signals  = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+    server.ctx      = rdpc_ctx_new();
+    server.cache    = rdpc_cache_new(server.ctx, expressions, results);
+
+    if (server.epoll < 0 || server.signals < 0) {
+        printf("serve: The event loop could not be created (%s).\n", strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+
+    if (!server.ctx || !server.cache) {
+        printf("serve: The calculator could not be allocated.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    event.events   = EPOLLIN;
+    event.data.ptr = &server.listener;
+    epoll_ctl(server.epoll, EPOLL_CTL_ADD, server.listener, &event);
+    event.data.ptr = &server.signals;
+    epoll_ctl(server.epoll, EPOLL_CTL_ADD, server.signals, &event);
+
+    while (running) {
+        const int n = epoll_wait(server.epoll, events, SERVE_EVENTS, -1);
+
+        if (n < 0 && errno != EINTR) {
+            printf("serve: The event loop has failed (%s).\n", strerror(errno));
+            exit(EXIT_FAILURE);
+        }
+
+        for (int i = 0; i < n; i++) {
+            if (events[i].data.ptr == &server.listener)
+                accept_all(&server);
+            else if (events[i].data.ptr == &server.signals)
+                running = 0;
+            else handle(&server, events[i].data.ptr, events[i].events);
+        }
+    }
+
+    if (stats) {
+        struct rdpc_cache_stats cache;
+
+        rdpc_cache_stats(server.cache, &cache);
+        fprintf(stderr, "stats: %llu connections accepted, %llu requests served (%llu failed).\n",
+                server.accepted, server.served, server.failed);
+        fprintf(stderr, "stats: %llu expressions compiled, %llu reused and %llu evicted, %zu resident in %zu bytes.\n",
+                cache.misses, cache.hits, cache.evictions, cache.expressions, cache.expression_bytes);
+        fprintf(stderr, "stats: %llu results evaluated, %llu reused and %llu evicted, %zu resident in %zu bytes.\n",
+                cache.result_misses, cache.result_hits, cache.result_evictions, cache.results, cache.result_bytes);
+    }
+
+    while (server.connections)
+        hang_up(&server, server.connections);
+    close(server.listener);
+    close(server.signals);
+    close(server.epoll);
+    unlink(path);
+
+    rdpc_cache_free(server.cache);
+    rdpc_ctx_free(server.ctx);
+}
@@ -0,0 +1,84 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Ricardo Fares
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef SERVE_H
+#define SERVE_H
+
+#include <stddef.h>
+
+/**
+ * Server constants definition.
+ * <p>
+ * The requests longer than SERVE_LINE_MAX characters close their
+ * connection, and by default, the compiled expressions and the results
+ * of the requests are cached in SERVE_EXPRESSIONS and SERVE_RESULTS
+ * bytes respectively.
+ */
+#define SERVE_EVENTS      (256)
+#define SERVE_BACKLOG     (4096)
+#define SERVE_READ        (64 * 1024)
+#define SERVE_LINE_MAX    (1024 * 1024)
+#define SERVE_EXPRESSIONS ((size_t)256 * 1024 * 1024)
+#define SERVE_RESULTS     ((size_t)64 * 1024 * 1024)
+
+/* Function Declaration */
+
+/**
+ * It serves the evaluation requests of the clients connecting to a Unix
+ * domain socket created at the specified path, until the process is
+ * interrupted or terminated.
+ * <p>
+ * A request is a line holding a program, whose statements are separated
+ * by semicolons. Its response is a line holding <em>ok</em> followed by
+ * the value of each result, or <em>error</em> followed by the position,
+ * as <em>line:column</em>, and the message of the first error of the
+ * request. A client may send its requests without
+ * waiting for their responses, which are sent in the request order.
+ * <p>
+ * The variables are shared by every request, hence, the definitions of
+ * a request remain for the next ones, even of other clients. Further,
+ * the program of each distinct request, regardless of its blanks, is
+ * compiled and optimized once and then cached, as long as no defined
+ * variable is defined anew with other flags. Likewise, the results of a
+ * request which does not define any variable are cached by the values
+ * of the variables it reads. The least recently used ones are evicted
+ * beyond the memory given to each cache.
+ * <p>
+ * The connections are multiplexed on a single thread by an epoll event
+ * loop, therefore, the requests are served one at a time without any
+ * locking, while thousands of clients may be connected at a time.
+ * <p>
+ * If the socket could not be created, then the program is exited.
+ *
+ * @param path        the path of the socket, which is replaced if it is
+ *                    a stale socket
+ * @param expressions the bytes the cached expressions may take
+ * @param results     the bytes the cached results may take
+ * @param stats       whether the statistics about the requests served,
+ *                    and the hits, the misses and the evictions of the
+ *                    caches, are printed to the standard error at the end
+ */
+void
+serve(const char *path, size_t expressions, size_t results, int stats);
+
+#endif // SERVE_H
@@ -24,138 +24,285 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 #include "./hashtable.h"
 
+/**
+ * The control bytes of the slots which are not full, whose
+ * highest bit is set, unlike the control byte of a full slot.
+ */
+#define HASHTABLE_EMPTY   ((signed char)-128)
+#define HASHTABLE_DELETED ((signed char)-2)
+
 /**
  * It calculates a hash code for the specified key.
  * <p>
  * <b>Implementation Notes:</b>
- * This function implements the DJB2 Hash Algorithm.
+ * This function implements the FNV-1a Hash Algorithm, whose
+ * result is mixed by the MurmurHash3 finalizer, such that both
+ * the lowest bits, which select the first group to be probed,
+ * and the highest bits, which are kept in the control byte,
+ * depend on every character of the key.
  *
- * @param ht_cap the hash table capacity
- * @param key    the key to be hashed
+ * @param key the key to be hashed
  *
  * @return the key hash code
  */
+static uint64_t
+hash(const char *key) {
+    uint64_t      hash = 14695981039346656037ull;
+    unsigned char c;
+    while ((c = (unsigned char)*key++))
+        hash = (hash ^ c) * 1099511628211ull;
+    hash ^= hash >> 33;
+    hash *= 0xFF51AFD7ED558CCDull;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+/**
+ * It returns which control bytes of the specified group are equal
+ * to the specified byte, as a mask whose i-th bit is set if the
+ * i-th control byte is equal.
+ *
+ * @param group the first control byte of the group
+ * @param byte  the byte
+ *
+ * @return the mask of the control bytes equal to the byte
+ */
+static unsigned
+match(const signed char *group, const signed char byte) {
+#if defined(__SSE2__)
+    const __m128i ctrl = _mm_loadu_si128((const __m128i *)group);
+    return (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(byte)));
+#else
+    unsigned mask = 0;
+    for (unsigned i = 0; i < HASHTABLE_GROUP; i++)
+        mask |= (unsigned)(group[i] == byte) << i;
+    return mask;
+#endif
+}
+
+/**
+ * It returns which slots of the specified group are either empty
+ * or deleted, as a mask whose i-th bit is set if the i-th slot is.
+ *
+ * @param group the first control byte of the group
+ *
+ * @return the mask of the slots which are not full
+ */
+static unsigned
+match_free(const signed char *group) {
+#if defined(__SSE2__)
+    const __m128i ctrl = _mm_loadu_si128((const __m128i *)group);
+    return (unsigned)_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_set1_epi8(-1), ctrl));
+#else
+    unsigned mask = 0;
+    for (unsigned i = 0; i < HASHTABLE_GROUP; i++)
+        mask |= (unsigned)(group[i] < -1) << i;
+    return mask;
+#endif
+}
+
+/**
+ * It sets the control byte of the specified slot, as well as its
+ * copy following the control bytes if the slot is in the first group.
+ * <p>
+ * The copy lets a group starting at any slot be loaded at once,
+ * wrapping around the end of the table.
+ *
+ * @param ht   the hash table
+ * @param i    the slot
+ * @param byte the control byte
+ */
+static void
+set_ctrl(struct hashtable *ht, const size_t i, const signed char byte) {
+    ht->ctrl[i] = byte;
+    if (i < HASHTABLE_GROUP)
+        ht->ctrl[ht->capacity + i] = byte;
+}
+
+/**
+ * It returns the first slot which is not full in the probe sequence
+ * of the specified hash code.
+ *
+ * @param ht the hash table
+ * @param h  the hash code
+ *
+ * @return the first slot which is not full
+ */
+static size_t
+find_free(const struct hashtable *ht, const uint64_t h) {
+    const size_t mask = ht->capacity - 1;
+    size_t       pos  = h & mask, step = 0;
+    unsigned     free;
+
+    while (!(free = match_free(ht->ctrl + pos))) {
+        step += HASHTABLE_GROUP;
+        pos   = (pos + step) & mask;
+    }
+    return (pos + (size_t)__builtin_ctz(free)) & mask;
+}
+
+/**
+ * It returns the slot of the specified key, or SIZE_MAX if the key
+ * is not mapped.
+ * <p>
+ * The groups are probed quadratically, i.e., the n-th group probed
+ * starts n(n + 1)/2 groups after the first one, which visits every
+ * slot since the capacity is a power of two. The probing stops at
+ * the first group having an empty slot, since the key would have
+ * been inserted there.
+ *
+ * @param ht  the hash table
+ * @param key the key
+ * @param h   the key hash code
+ *
+ * @return the slot of the key or SIZE_MAX
+ */
 static size_t
-hash(const size_t ht_cap, const char *key) {
-    size_t hash = 5381;
-    char c;
-    while ((c = *key++))
-        hash = ((hash << 5) + hash) + c;
-    return hash % ht_cap;
+find_slot(const struct hashtable *ht, const char *key, const uint64_t h) {
+    const signed char h2   = (signed char)(h >> 57);
+    const size_t      mask = ht->capacity - 1;
+    size_t            pos  = h & mask, step = 0;
+
+    for (;;) {
+        const signed char *group = ht->ctrl + pos;
+
+        for (unsigned m = match(group, h2); m; m &= m - 1) {
+            const size_t i = (pos + (size_t)__builtin_ctz(m)) & mask;
+            if (0 == strcmp(ht->slots[i].key, key))
+                return i;
+        }
+        if (match(group, HASHTABLE_EMPTY))
+            return SIZE_MAX;
+        step += HASHTABLE_GROUP;
+        pos   = (pos + step) & mask;
+    }
 }
 
 /**
- * It resizes the specified hash table.
+ * It resizes the specified hash table to the specified capacity,
+ * which must be a power of two, dropping its deleted slots.
  * <p>
- * If the new hash table capacity exceeds the maximum size
- * or if there is not enough memory to resize the hash table,
+ * If there is not enough memory to resize the hash table,
  * then the application is immediately terminated.
  *
- * @param ht the hash table to be resized
+ * @param ht       the hash table to be resized
+ * @param capacity the new capacity
  */
 static void
-resize(struct hashtable *ht) {
-    size_t old_cap = ht->capacity;
-    size_t new_cap = old_cap << 1; /* newCap = 2 oldCap */
-    /* It checks if the resizing exceeds the maximum size */
-    if (new_cap < old_cap) {
-        printf("Hash table maximum size exceeded.\n");
-        exit(EXIT_FAILURE);
-    }
-    struct node **new_table;
-    /* It checks if the hash table nodes could not be allocated for the new capacity */
-    if (!(new_table = malloc(sizeof(struct node *) * new_cap))) {
-        printf("Hash table resizing could not allocate %zu elements.\n", new_cap);
+resize(struct hashtable *ht, const size_t capacity) {
+    signed char           *old_ctrl  = ht->ctrl;
+    struct hashtable_slot *old_slots = ht->slots;
+    const size_t           old_cap   = ht->capacity;
+
+    /* It checks if the hash table slots could not be allocated for the new capacity */
+    if (!(ht->ctrl = malloc(capacity + HASHTABLE_GROUP)) ||
+        !(ht->slots = malloc(sizeof(struct hashtable_slot) * capacity))) {
+        printf("Hash table resizing could not allocate %zu elements.\n", capacity);
         exit(EXIT_FAILURE);
     }
+    memset(ht->ctrl, HASHTABLE_EMPTY, capacity + HASHTABLE_GROUP);
+    ht->capacity = capacity;
+    ht->growth   = capacity - capacity / 8 - ht->size;
+
     for (size_t i = 0; i < old_cap; i++) {
-        struct node *curr = ht->table[i];
-        while (curr) {
-            ht->table[i] = curr->next;
-            size_t new_h = hash(new_cap, curr->key);
-            curr->next = new_table[new_h];
-            new_table[new_h] = curr;
-            curr = ht->table[i];
+        /* The keys are scattered, hence, they are fetched ahead of their hashing */
+        if (i + HASHTABLE_GROUP < old_cap && old_ctrl[i + HASHTABLE_GROUP] >= 0)
+            __builtin_prefetch(old_slots[i + HASHTABLE_GROUP].key);
+        if (old_ctrl[i] >= 0) {
+            const size_t j = find_free(ht, hash(old_slots[i].key));
+            set_ctrl(ht, j, old_ctrl[i]);
+            ht->slots[j] = old_slots[i];
         }
     }
-    free(ht->table);
-    ht->table    = new_table;
-    ht->capacity = new_cap;
-    ht->lf       = (float)ht->size / ht->capacity;
+    free(old_ctrl);
+    free(old_slots);
 }
 
 struct hashtable *
 hashtable_new(size_t initial_capacity) {
-    struct hashtable *ht = malloc(sizeof(struct hashtable));
+    struct hashtable *ht       = calloc(1, sizeof(struct hashtable));
+    size_t            capacity = HASHTABLE_GROUP;
     /* It checks if there is not enough memory to allocate a hash table */
     if (!ht) {
         printf("A hash table could not be allocated.\n");
         exit(EXIT_FAILURE);
     }
-    ht->size     = 0;
-    ht->capacity = initial_capacity;
-    ht->lf       = 0.0f;
-    /* It checks if the hash table nodes could not be allocated */
-    if (!(ht->table = malloc(sizeof(struct node *) * initial_capacity))) {
-        printf("A hash table with initial capacity %zu could not be allocated.\n", initial_capacity);
-        free(ht);
-        exit(EXIT_FAILURE);
+    /* The capacity is the least power of two keeping the table at most 7/8 full */
+    while (capacity - capacity / 8 < initial_capacity) {
+        /* It checks if the capacity exceeds the maximum size */
+        if (capacity << 1 < capacity) {
+            printf("A hash table with initial capacity %zu could not be allocated.\n", initial_capacity);
+            exit(EXIT_FAILURE);
+        }
+        capacity <<= 1;
     }
+    resize(ht, capacity);
     return ht;
 }
 
 void
 hashtable_insert(struct hashtable *ht, const char *key, struct var_descriptor_t *value) {
-    struct node *new_node = malloc(sizeof(struct node));
-    /* It checks if there is not enough memory to allocate a hash table node */
-    if (!new_node) {
-        printf("A hashtable node could not be allocated.\n");
-        exit(EXIT_FAILURE);
+    const uint64_t h = hash(key);
+    size_t         i = find_slot(ht, key, h);
+
+    if (i != SIZE_MAX) {
+        ht->slots[i].descriptor = *value;
+        return;
+    }
+    /* It checks if the table is full, counting the deleted slots. If at */
+    /* most half of the slots are in use, the deleted slots are dropped */
+    /* and the capacity is kept */
+    if (!ht->growth) {
+        const size_t capacity = ht->size < ht->capacity / 2 ? ht->capacity : ht->capacity << 1;
+        /* It checks if the resizing exceeds the maximum size */
+        if (capacity < ht->capacity) {
+            printf("Hash table maximum size exceeded.\n");
+            exit(EXIT_FAILURE);
+        }
+        resize(ht, capacity);
     }
-    if (ht->lf >= 0.75f)
-        resize(ht);
-    size_t h = hash(ht->capacity, key);
-    new_node->key              = key;
-    memcpy(&new_node->descriptor, value, sizeof(struct var_descriptor_t));
-    new_node->next             = ht->table[h];
-    ht->table[h]               = new_node;
+    i = find_free(ht, h);
+    if (ht->ctrl[i] == HASHTABLE_EMPTY)
+        ht->growth--;
+    set_ctrl(ht, i, (signed char)(h >> 57));
+    ht->slots[i].key        = key;
+    ht->slots[i].descriptor = *value;
     ht->size++;
-    ht->lf                     = (float)ht->size / ht->capacity;
 }
 
 struct var_descriptor_t *
 hashtable_find(struct hashtable *ht, const char *key) {
-    size_t h          = hash(ht->capacity, key);
-    struct node *curr = ht->table[h];
-    while (curr) {
-        if (0 == strcmp(curr->key, key))
-            return &curr->descriptor;
-        curr = curr->next;
-    }
-    return NULL;
+    const size_t i = find_slot(ht, key, hash(key));
+    return i != SIZE_MAX ? &ht->slots[i].descriptor : NULL;
 }
 
 void
 hashtable_remove(struct hashtable *ht, const char *key, struct var_descriptor_t *placeholder) {
-    size_t h          = hash(ht->capacity, key);
-    struct node *prev = NULL, *curr = ht->table[h];
-    while  (curr) {
-        if (0 == strcmp(curr->key, key)) {
-            *placeholder = curr->descriptor;
-            break;
-        }
-        prev = curr;
-        curr = curr->next;
-    }
-    if (curr) {
-        if (prev)
-            prev->next = curr->next;
-        else ht->table[h] = curr->next;
+    const size_t i = find_slot(ht, key, hash(key));
+    if (i != SIZE_MAX) {
+        *placeholder = ht->slots[i].descriptor;
+        /* The slot stays deleted rather than empty, hence, the */
+        /* probing for the keys inserted after it goes on */
+        set_ctrl(ht, i, HASHTABLE_DELETED);
         ht->size--;
-        ht->lf = (float)ht->size / ht->capacity;
-        free(curr);
     }
 }
+
+size_t
+hashtable_memory(const struct hashtable *ht) {
+    return sizeof(struct hashtable) + ht->capacity + HASHTABLE_GROUP + sizeof(struct hashtable_slot) * ht->capacity;
+}
+
+void
+hashtable_free(struct hashtable *ht) {
+    free(ht->ctrl);
+    free(ht->slots);
+    free(ht);
+}
@@ -28,22 +28,37 @@
 #include "../semantic/semantic.h"
 
 /**
- * A singly-linked hash table node.
+ * The amount of control bytes probed at a time, i.e., the width
+ * of a group.
+ */
+#define HASHTABLE_GROUP (16)
+
+/**
+ * A hash table slot.
  * <p>
- * This hash table node stores the key-value pair
- * as well as the next node in the list.
+ * This hash table slot stores the key-value pair inline,
+ * hence, inserting a pair does not allocate it.
  */
-struct node {
+struct hashtable_slot {
     const char              *key;
     struct var_descriptor_t  descriptor;
-    struct node             *next;
 };
 
 /**
  * A hash table.
  * <p>
- * This hash table implementation use <b>chaining</b>
- * to resolve the <em>collisions</em>.
+ * This hash table implementation uses <b>open addressing</b>
+ * to resolve the <em>collisions</em>, in the style of the SwissTable.
+ * Each slot has a control byte telling whether it is empty, deleted
+ * or full, in which case it holds the 7 highest bits of the key hash
+ * code. A lookup compares a whole group of HASHTABLE_GROUP control
+ * bytes against those bits at once, with SSE2 where available, and
+ * compares the keys of the matching slots only. Hence, a lookup
+ * rarely compares more than one key.
+ * <p>
+ * The capacity is a power of two, the groups are probed
+ * quadratically and the table is resized when it is 7/8 full,
+ * counting the deleted slots.
  * <p>
  * Moreover, this hash table has been implemented using an
  * aggressive way to handle exceptional cases, in any of
@@ -59,10 +74,11 @@ struct node {
  * and modification.
  */
 struct hashtable {
-    struct node  **table;
-    size_t         size;
-    size_t         capacity;
-    float          lf;
+    signed char           *ctrl;     /* the control bytes, followed by a copy of the first group */
+    struct hashtable_slot *slots;
+    size_t                 size;
+    size_t                 capacity;
+    size_t                 growth;   /* the insertions into an empty slot left before resizing */
 };
 
 /* Hash Table Function Declaration */
@@ -71,9 +87,10 @@ struct hashtable {
  * It allocates a <em>hashtable</em> structure and returns a pointer
  * to the allocated memory.
  * <p>
- * If there is not enough memory to allocate the <em>hashtable</em>
- * structure or allocate the nodes to satisfy the <em>initial capacity</em>,
- * then the application is immediately terminated.
+ * The hash table holds at least <em>initial capacity</em> pairs before
+ * being resized. If there is not enough memory to allocate the
+ * <em>hashtable</em> structure or its slots, then the application is
+ * immediately terminated.
  *
  * @param initial_capacity the initial capacity
  *
@@ -83,7 +100,10 @@ struct hashtable *
 hashtable_new(size_t initial_capacity);
 
 /**
- * It inserts a key-value pair into the hash table.
+ * It inserts a key-value pair into the hash table, replacing the
+ * value of the key if it is already mapped.
+ * <p>
+ * The key is not copied, hence, it must outlive the mapping.
  *
  * @param ht    the hash table
  * @param key   the key
@@ -96,7 +116,7 @@ hashtable_insert(struct hashtable *ht, const char *key, struct var_descriptor_t
  * It returns a pointer to the value mapped by key in this hash table.
  * <p>
  * If the pointer is NULL, then the mapping does not exist in the
- * specified hash table.
+ * specified hash table. The pointer is valid until the next insertion.
  *
  * @param ht  the hash table
  * @param key the key
@@ -119,4 +139,23 @@ hashtable_find(struct hashtable *ht, const char *key);
 void
 hashtable_remove(struct hashtable *ht, const char *key, struct var_descriptor_t *placeholder);
 
+/**
+ * It returns the amount of bytes allocated by the specified hash
+ * table.
+ *
+ * @param ht the hash table
+ *
+ * @return the amount of bytes allocated by the hash table
+ */
+size_t
+hashtable_memory(const struct hashtable *ht);
+
+/**
+ * It frees the specified hash table.
+ *
+ * @param ht the hash table
+ */
+void
+hashtable_free(struct hashtable *ht);
+
 #endif // HASHTABLE_H
@@ -0,0 +1,192 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Ricardo Fares
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "./intern.h"
+
+/**
+ * The initial capacities of the pool storages.
+ */
+#define INTERN_INITIAL_CHARS   (1024)
+#define INTERN_INITIAL_ENTRIES (64)
+
+/**
+ * It calculates a hash code for the specified name.
+ * <p>
+ * <b>Implementation Notes:</b>
+ * This function implements the FNV-1a Hash Algorithm.
+ *
+ * @param name the name to be hashed
+ * @param len  the name length
+ *
+ * @return the name hash code
+ */
+static unsigned
+hash(const char *name, const size_t len) {
+    unsigned hash = 2166136261u;
+    for (size_t i = 0; i < len; i++)
+        hash = (hash ^ (unsigned char)name[i]) * 16777619u;
+    return hash;
+}
+
+/**
+ * It reallocates the specified memory, counting the allocation in the
+ * specified pool.
+ * <p>
+ * If there is not enough memory, then the application is immediately
+ * terminated.
+ *
+ * @param pool the interning pool
+ * @param ptr  the memory to be reallocated
+ * @param size the new size
+ *
+ * @return the reallocated memory
+ */
+static void *
+grow(struct intern_pool *pool, void *ptr, const size_t size) {
+    if (!(ptr = realloc(ptr, size))) {
+        printf("Interning pool could not allocate %zu bytes.\n", size);
+        exit(EXIT_FAILURE);
+    }
+    pool->allocations++;
+    return ptr;
+}
+
+/**
+ * It rebuilds the index of the specified pool with the specified
+ * capacity, which must be a power of two.
+ *
+ * @param pool     the interning pool
+ * @param capacity the new index capacity
+ */
+static void
+reindex(struct intern_pool *pool, const unsigned capacity) {
+    unsigned *index = grow(pool, NULL, sizeof(unsigned) * capacity);
+    memset(index, 0xFF, sizeof(unsigned) * capacity);
+    for (unsigned id = 0; id < pool->count; id++) {
+        unsigned h = pool->entries[id].hash & (capacity - 1);
+        while (index[h] != INTERN_NONE)
+            h = (h + 1) & (capacity - 1);
+        index[h] = id;
+    }
+    free(pool->index);
+    pool->index = index;
+    pool->mask  = capacity - 1;
+}
+
+struct intern_pool *
+intern_new() {
+    struct intern_pool *pool = calloc(1, sizeof(struct intern_pool));
+    /* It checks if there is not enough memory to allocate a pool */
+    if (!pool) {
+        printf("An interning pool could not be allocated.\n");
+        exit(EXIT_FAILURE);
+    }
+    pool->allocations = 1;
+    pool->charscap    = INTERN_INITIAL_CHARS;
+    pool->chars       = grow(pool, NULL, pool->charscap);
+    pool->capacity    = INTERN_INITIAL_ENTRIES;
+    pool->entries     = grow(pool, NULL, sizeof(struct intern_entry) * pool->capacity);
+    reindex(pool, INTERN_INITIAL_ENTRIES * 2);
+    return pool;
+}
+
+unsigned
+intern_find(const struct intern_pool *pool, const char *name, const size_t len) {
+    const unsigned h = hash(name, len);
+    unsigned i       = h & pool->mask;
+    unsigned id;
+    while ((id = pool->index[i]) != INTERN_NONE) {
+        const struct intern_entry *entry = &pool->entries[id];
+        if (entry->hash == h && entry->len == len && 0 == memcmp(pool->chars + entry->offset, name, len))
+            return id;
+        i = (i + 1) & pool->mask;
+    }
+    return INTERN_NONE;
+}
+
+unsigned
+intern(struct intern_pool *pool, const char *name, const size_t len) {
+    unsigned id = intern_find(pool, name, len);
+    if (id != INTERN_NONE)
+        return id;
+    /* It checks if the character storage must be grown to fit the name */
+    if (pool->charslen + len + 1 > pool->charscap) {
+        while (pool->charslen + len + 1 > pool->charscap)
+            pool->charscap <<= 1;
+        pool->chars = grow(pool, pool->chars, pool->charscap);
+    }
+    /* It checks if the entries must be grown to fit the symbol */
+    if (pool->count == pool->capacity) {
+        pool->capacity <<= 1;
+        pool->entries    = grow(pool, pool->entries, sizeof(struct intern_entry) * pool->capacity);
+    }
+    id = pool->count++;
+    pool->entries[id].offset = pool->charslen;
+    pool->entries[id].len    = (unsigned)len;
+    pool->entries[id].hash   = hash(name, len);
+    memcpy(pool->chars + pool->charslen, name, len);
+    pool->chars[pool->charslen + len] = '\0';
+    pool->charslen += len + 1;
+    /* It keeps the index at most half full */
+    if (pool->count * 2 > pool->mask + 1)
+        reindex(pool, (pool->mask + 1) << 1);
+    else {
+        unsigned i = pool->entries[id].hash & pool->mask;
+        while (pool->index[i] != INTERN_NONE)
+            i = (i + 1) & pool->mask;
+        pool->index[i] = id;
+    }
+    return id;
+}
+
+const char *
+intern_name(const struct intern_pool *pool, const unsigned id) {
+    return pool->chars + pool->entries[id].offset;
+}
+
+void
+intern_truncate(struct intern_pool *pool, const unsigned count) {
+    /* The index has been filled in the order of the identifiers, */
+    /* hence, no probe of an older symbol passes by a newer one, and */
+    /* the newest symbols are removed by clearing their slot */
+    while (pool->count > count) {
+        const unsigned id = --pool->count;
+        unsigned       i  = pool->entries[id].hash & pool->mask;
+        while (pool->index[i] != id)
+            i = (i + 1) & pool->mask;
+        pool->index[i] = INTERN_NONE;
+        pool->charslen = pool->entries[id].offset;
+    }
+}
+
+void
+intern_free(struct intern_pool *pool) {
+    free(pool->chars);
+    free(pool->entries);
+    free(pool->index);
+    free(pool);
+}
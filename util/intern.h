@@ -0,0 +1,148 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Ricardo Fares
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef INTERN_H
+#define INTERN_H
+
+#include <stddef.h>
+
+/**
+ * An interned symbol entry.
+ * <p>
+ * It describes where the symbol name is stored in the
+ * pool character storage as well as its cached hash code.
+ */
+struct intern_entry {
+    size_t   offset;
+    unsigned len;
+    unsigned hash;
+};
+
+/**
+ * An interning pool.
+ * <p>
+ * This pool stores each distinct symbol name exactly once and
+ * maps it to a stable <em>symbol identifier</em>. The identifiers
+ * are dense, that is, they are assigned sequentially starting at
+ * zero, therefore, they may be used to index arrays directly.
+ * <p>
+ * The names are stored contiguously and null-terminated in a single
+ * character storage, and they are indexed by an <b>open addressing</b>
+ * table with linear probing whose capacity is a power of two.
+ * <p>
+ * Moreover, as the hash table, this pool has been implemented using an
+ * aggressive way to handle exceptional cases, in any of these cases the
+ * application is immediately terminated.
+ */
+struct intern_pool {
+    char                *chars;
+    size_t               charslen;
+    size_t               charscap;
+    struct intern_entry *entries;
+    unsigned             count;
+    unsigned             capacity;
+    unsigned            *index;
+    unsigned             mask;
+    unsigned long long   allocations;
+};
+
+/* Interning Pool Function Declaration */
+
+/**
+ * It allocates an <em>intern_pool</em> structure and returns a pointer
+ * to the allocated memory.
+ * <p>
+ * If there is not enough memory to allocate the pool, then the
+ * application is immediately terminated.
+ *
+ * @return a pointer to the memory allocated for the <em>intern_pool</em>
+ */
+struct intern_pool *
+intern_new();
+
+/**
+ * It returns the symbol identifier of the specified name, interning
+ * the name if it has not been interned yet.
+ * <p>
+ * The name does not need to be null-terminated.
+ *
+ * @param pool the interning pool
+ * @param name the name
+ * @param len  the name length
+ *
+ * @return the symbol identifier of the name
+ */
+unsigned
+intern(struct intern_pool *pool, const char *name, size_t len);
+
+/**
+ * It returns the symbol identifier of the specified name, or
+ * <em>INTERN_NONE</em> if the name has not been interned.
+ *
+ * @param pool the interning pool
+ * @param name the name
+ * @param len  the name length
+ *
+ * @return the symbol identifier of the name or <em>INTERN_NONE</em>
+ */
+unsigned
+intern_find(const struct intern_pool *pool, const char *name, size_t len);
+
+/**
+ * It returns the null-terminated name of the specified symbol.
+ *
+ * @param pool the interning pool
+ * @param id   the symbol identifier
+ *
+ * @return the name of the symbol
+ */
+const char *
+intern_name(const struct intern_pool *pool, unsigned id);
+
+/**
+ * It forgets the symbols interned after the first specified amount of
+ * symbols, such that their identifiers are assigned again to the next
+ * names interned.
+ * <p>
+ * The storage of the pool is kept, rather than shrunk.
+ *
+ * @param pool  the interning pool
+ * @param count the amount of symbols to be kept
+ */
+void
+intern_truncate(struct intern_pool *pool, unsigned count);
+
+/**
+ * It frees the specified interning pool.
+ *
+ * @param pool the interning pool
+ */
+void
+intern_free(struct intern_pool *pool);
+
+/**
+ * It represents the absence of a symbol identifier.
+ */
+#define INTERN_NONE (~0u)
+
+#endif // INTERN_H
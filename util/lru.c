@@ -0,0 +1,189 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Ricardo Fares
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "./lru.h"
+
+/**
+ * The amount of buckets of an empty cache.
+ */
+#define LRU_BUCKETS (64)
+
+/**
+ * It unlinks the specified entry from the list ordered by recency.
+ *
+ * @param entry the entry
+ */
+static void
+unlink_entry(struct lru_entry *entry) {
+    entry->prev->next = entry->next;
+    entry->next->prev = entry->prev;
+}
+
+/**
+ * It links the specified entry into the specified cache as its most
+ * recently used entry.
+ *
+ * @param lru   the cache
+ * @param entry the entry
+ */
+static void
+push_front(struct lru *lru, struct lru_entry *entry) {
+    entry->prev           = &lru->order;
+    entry->next           = lru->order.next;
+    lru->order.next->prev = entry;
+    lru->order.next       = entry;
+}
+
+/**
+ * It resizes the buckets of the specified cache to the specified
+ * amount, rehashing every entry.
+ * <p>
+ * If there is not enough memory, then the application is immediately
+ * terminated.
+ *
+ * @param lru      the cache
+ * @param nbuckets the amount of buckets, a power of two
+ */
+static void
+rehash(struct lru *lru, const size_t nbuckets) {
+    struct lru_entry **buckets = calloc(nbuckets, sizeof(struct lru_entry *));
+
+    /* It checks if there is not enough memory to allocate the buckets */
+    if (!buckets) {
+        printf("A cache of %zu buckets could not be allocated.\n", nbuckets);
+        exit(EXIT_FAILURE);
+    }
+
+    for (struct lru_entry *entry = lru->order.next; entry != &lru->order; entry = entry->next) {
+        struct lru_entry **bucket = &buckets[entry->hash & (nbuckets - 1)];
+
+        entry->chain = *bucket;
+        *bucket      = entry;
+    }
+
+    free(lru->buckets);
+    lru->buckets  = buckets;
+    lru->nbuckets = nbuckets;
+}
+
+/**
+ * It evicts the least recently used entry of the specified cache,
+ * releasing it.
+ *
+ * @param lru the cache
+ */
+static void
+evict(struct lru *lru) {
+    struct lru_entry  *victim = lru->order.prev;
+    struct lru_entry **link   = &lru->buckets[victim->hash & (lru->nbuckets - 1)];
+
+    while (*link != victim)
+        link = &(*link)->chain;
+    *link = victim->chain;
+
+    unlink_entry(victim);
+    lru->count--;
+    lru->used -= victim->size;
+    lru->evictions++;
+    lru->release(victim, lru->arg);
+}
+
+struct lru *
+lru_new(const size_t limit, const lru_release release, void *arg) {
+    struct lru *lru = calloc(1, sizeof(struct lru));
+
+    /* It checks if there is not enough memory to allocate a cache */
+    if (!lru) {
+        printf("A cache could not be allocated.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    lru->order.prev = lru->order.next = &lru->order;
+    lru->limit      = limit;
+    lru->release    = release;
+    lru->arg        = arg;
+    rehash(lru, LRU_BUCKETS);
+
+    return lru;
+}
+
+struct lru_entry *
+lru_find(struct lru *lru, const uint64_t hash, const lru_match match, const void *key) {
+    struct lru_entry *entry = lru->buckets[hash & (lru->nbuckets - 1)];
+
+    while (entry && (entry->hash != hash || !match(entry, key)))
+        entry = entry->chain;
+
+    if (!entry) {
+        lru->misses++;
+        return NULL;
+    }
+
+    lru->hits++;
+    unlink_entry(entry);
+    push_front(lru, entry);
+
+    return entry;
+}
+
+int
+lru_insert(struct lru *lru, struct lru_entry *entry) {
+    struct lru_entry **bucket;
+
+    /* It checks if the entry would evict every other entry in vain */
+    if (entry->size > lru->limit)
+        return -1;
+
+    while (lru->used + entry->size > lru->limit)
+        evict(lru);
+
+    if (lru->count >= lru->nbuckets)
+        rehash(lru, lru->nbuckets << 1);
+
+    bucket       = &lru->buckets[entry->hash & (lru->nbuckets - 1)];
+    entry->chain = *bucket;
+    *bucket      = entry;
+    push_front(lru, entry);
+    lru->count++;
+    lru->used += entry->size;
+
+    return 0;
+}
+
+void
+lru_free(struct lru *lru) {
+    struct lru_entry *entry = lru->order.next;
+
+    while (entry != &lru->order) {
+        struct lru_entry *next = entry->next;
+
+        lru->release(entry, lru->arg);
+        entry = next;
+    }
+
+    free(lru->buckets);
+    free(lru);
+}
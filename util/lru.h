@@ -0,0 +1,156 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Ricardo Fares
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef LRU_H
+#define LRU_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * An entry of a least recently used cache.
+ * <p>
+ * The entry is embedded as the first member of the structure being
+ * cached, hence, inserting it does not allocate it. Its size is the
+ * amount of bytes it is charged for, which is given by its owner.
+ */
+struct lru_entry {
+    uint64_t          hash;
+    size_t            size;
+    struct lru_entry *chain; /* the next entry of its bucket */
+    struct lru_entry *prev;  /* the next more recently used entry */
+    struct lru_entry *next;  /* the next less recently used entry */
+};
+
+/**
+ * It tells whether the specified entry has the specified key, whose
+ * hash code is already known to be the one of the entry.
+ *
+ * @param entry the entry
+ * @param key   the key
+ *
+ * @return non-zero if the entry has the key, zero otherwise
+ */
+typedef int (*lru_match)(const struct lru_entry *entry, const void *key);
+
+/**
+ * It frees the specified entry, which has just been evicted.
+ *
+ * @param entry the entry
+ * @param arg   the argument given to the cache
+ */
+typedef void (*lru_release)(struct lru_entry *entry, void *arg);
+
+/**
+ * A least recently used cache bounded by memory.
+ * <p>
+ * The entries are chained into the buckets of a hash table, whose
+ * amount is a power of two doubled as soon as the entries outnumber
+ * them, and into a list ordered by recency, such that a lookup, an
+ * insertion and an eviction take constant time. Once the entries are
+ * charged more than the limit, the least recently used ones are
+ * evicted and released.
+ * <p>
+ * The cache does not hash the keys itself, hence, the hash codes given
+ * by its owner must be mixed well enough for their lowest bits to
+ * select a bucket.
+ * <p>
+ * Moreover, as the hash table, this cache has been implemented using an
+ * aggressive way to handle exceptional cases, in any of these cases the
+ * application is immediately terminated.
+ */
+struct lru {
+    struct lru_entry  **buckets;
+    size_t              nbuckets;
+    size_t              count;
+    struct lru_entry    order;     /* the sentinel of the list ordered by recency */
+    size_t              used;      /* the bytes the entries are charged for */
+    size_t              limit;
+    lru_release         release;
+    void               *arg;
+    unsigned long long  hits;
+    unsigned long long  misses;
+    unsigned long long  evictions;
+};
+
+/* LRU Cache Function Declaration */
+
+/**
+ * It allocates an empty <em>lru</em> structure and returns a pointer
+ * to the allocated memory.
+ * <p>
+ * If there is not enough memory to allocate the cache, then the
+ * application is immediately terminated.
+ *
+ * @param limit   the amount of bytes the entries may be charged for
+ * @param release the function freeing an evicted entry
+ * @param arg     the argument given to the function
+ *
+ * @return a pointer to the memory allocated for the <em>lru</em>
+ */
+struct lru *
+lru_new(size_t limit, lru_release release, void *arg);
+
+/**
+ * It returns the entry of the specified cache having the specified key,
+ * which becomes its most recently used entry.
+ * <p>
+ * The lookup is counted as a hit if the entry is found, or as a miss
+ * otherwise.
+ *
+ * @param lru   the cache
+ * @param hash  the hash code of the key
+ * @param match the function comparing an entry with the key
+ * @param key   the key
+ *
+ * @return the entry, or NULL if no entry has the key
+ */
+struct lru_entry *
+lru_find(struct lru *lru, uint64_t hash, lru_match match, const void *key);
+
+/**
+ * It inserts the specified entry, whose hash code and size are set,
+ * into the specified cache as its most recently used entry, evicting
+ * the least recently used entries beyond the limit of the cache.
+ * <p>
+ * The entry must not have the key of another entry of the cache. If
+ * the entry alone exceeds the limit, then it is not inserted, and it
+ * is still owned by the caller.
+ *
+ * @param lru   the cache
+ * @param entry the entry
+ *
+ * @return zero, or -1 if the entry has not been inserted
+ */
+int
+lru_insert(struct lru *lru, struct lru_entry *entry);
+
+/**
+ * It releases every entry of the specified cache and frees it.
+ *
+ * @param lru the cache
+ */
+void
+lru_free(struct lru *lru);
+
+#endif // LRU_H
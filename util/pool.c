@@ -0,0 +1,283 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Ricardo Fares
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sched.h>
+#include <unistd.h>
+
+#include "./pool.h"
+
+/**
+ * It packs the specified range of indices into a word.
+ *
+ * @param begin the first index
+ * @param end   the end of the range
+ *
+ * @return the packed range
+ */
+static uint64_t
+pack(const uint64_t begin, const uint64_t end) {
+    return begin << 32 | end;
+}
+
+/**
+ * It claims the first index left to the specified worker, which must
+ * be run by the worker itself.
+ *
+ * @param worker the worker
+ * @param index  the claimed index
+ *
+ * @return 1 if an index has been claimed, 0 if none is left
+ */
+static int
+claim(struct pool_worker *worker, size_t *index) {
+    uint64_t range = atomic_load(&worker->range);
+
+    while (range >> 32 < (range & 0xFFFFFFFF)) {
+        if (atomic_compare_exchange_weak(&worker->range, &range, range + ((uint64_t)1 << 32))) {
+            *index = range >> 32;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * It steals the back half of the indices left to the specified victim,
+ * claiming the first stolen index and handing the others over to the
+ * specified thief, whose range must be empty.
+ *
+ * @param thief  the worker stealing
+ * @param victim the worker being stolen from
+ * @param index  the claimed index
+ *
+ * @return 1 if an index has been stolen, 0 if none is left
+ */
+static int
+steal(struct pool_worker *thief, struct pool_worker *victim, size_t *index) {
+    uint64_t range = atomic_load(&victim->range);
+
+    while (range >> 32 < (range & 0xFFFFFFFF)) {
+        const uint64_t begin = range >> 32, end = range & 0xFFFFFFFF;
+        const uint64_t half  = begin + (end - begin) / 2;
+
+        if (atomic_compare_exchange_weak(&victim->range, &range, pack(begin, half))) {
+            atomic_store(&thief->range, pack(half + 1, end));
+            *index = half;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * It runs the indices of the current run with the specified worker,
+ * until every index of the run has been run.
+ *
+ * @param worker the worker
+ */
+static void
+work(struct pool_worker *worker) {
+    struct pool *pool = worker->pool;
+    size_t       index, done = 0;
+
+    for (;;) {
+        while (claim(worker, &index)) {
+            pool->task(pool->arg, index, worker->id);
+            done++;
+        }
+
+        if (done > 0) {
+            atomic_fetch_sub(&pool->pending, done);
+            done = 0;
+        }
+
+        /* It checks if the other workers are running the last indices */
+        if (atomic_load(&pool->pending) == 0)
+            return;
+
+        /* It steals from the nearest worker with indices left */
+        for (unsigned d = 1; d < pool->nworkers; d++) {
+            if (steal(worker, &pool->workers[(worker->id + d) % pool->nworkers], &index)) {
+                pool->task(pool->arg, index, worker->id);
+                done++;
+                break;
+            }
+        }
+
+        if (done == 0)
+            sched_yield();
+    }
+}
+
+/**
+ * It is the body of the threads of a pool, which wait for a run,
+ * take part in it and wait for the next one until the pool is freed.
+ *
+ * @param arg the worker of the thread
+ *
+ * @return NULL
+ */
+static void *
+thread_main(void *arg) {
+    struct pool_worker *worker = arg;
+    struct pool        *pool   = worker->pool;
+    unsigned long       seen   = 0;
+
+    pthread_mutex_lock(&pool->mutex);
+    for (;;) {
+        while (pool->generation == seen && !pool->quit)
+            pthread_cond_wait(&pool->start, &pool->mutex);
+        if (pool->quit)
+            break;
+        seen = pool->generation;
+        pthread_mutex_unlock(&pool->mutex);
+
+        work(worker);
+
+        pthread_mutex_lock(&pool->mutex);
+        if (--pool->busy == 0)
+            pthread_cond_signal(&pool->done);
+    }
+    pthread_mutex_unlock(&pool->mutex);
+
+    return NULL;
+}
+
+struct pool *
+pool_new(unsigned threads) {
+    struct pool *pool = malloc(sizeof(struct pool));
+    unsigned     ncpus;
+#if defined(__linux__)
+    cpu_set_t    available;
+    unsigned     cpus[CPU_SETSIZE];
+
+    /* The threads are pinned to the cores the process may run on */
+    ncpus = 0;
+    if (0 == sched_getaffinity(0, sizeof(available), &available)) {
+        for (unsigned cpu = 0; cpu < CPU_SETSIZE; cpu++)
+            if (CPU_ISSET(cpu, &available))
+                cpus[ncpus++] = cpu;
+    }
+#else
+    ncpus = (unsigned)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+
+    if (ncpus == 0)
+        ncpus = 1;
+    if (threads == 0)
+        threads = ncpus;
+
+    if (!pool || !(pool->workers = aligned_alloc(64, sizeof(struct pool_worker) * threads))) {
+        printf("pool_new: A pool of %u threads could not be allocated.\n", threads);
+        exit(EXIT_FAILURE);
+    }
+
+    pool->nworkers   = threads;
+    pool->task       = NULL;
+    pool->arg        = NULL;
+    pool->busy       = 0;
+    pool->generation = 0;
+    pool->quit       = 0;
+    atomic_init(&pool->pending, 0);
+    pthread_mutex_init(&pool->mutex, NULL);
+    pthread_cond_init(&pool->start, NULL);
+    pthread_cond_init(&pool->done, NULL);
+
+    for (unsigned i = 0; i < threads; i++) {
+        struct pool_worker *worker = &pool->workers[i];
+
+        worker->pool = pool;
+        worker->id   = i;
+        atomic_init(&worker->range, 0);
+
+        /* The first worker is the calling thread */
+        if (i == 0)
+            continue;
+
+        if (0 != pthread_create(&worker->thread, NULL, thread_main, worker)) {
+            printf("pool_new: Thread %u of the pool could not be started.\n", i);
+            exit(EXIT_FAILURE);
+        }
+
+#if defined(__linux__)
+        {
+            cpu_set_t cpu;
+            CPU_ZERO(&cpu);
+            CPU_SET(cpus[i % ncpus], &cpu);
+            pthread_setaffinity_np(worker->thread, sizeof(cpu), &cpu);
+        }
+#endif
+    }
+
+    return pool;
+}
+
+void
+pool_run(struct pool *pool, const size_t count, const pool_task task, void *arg) {
+    if (count > 0xFFFFFFFF) {
+        printf("pool_run: A run of %zu indices is too large.\n", count);
+        exit(EXIT_FAILURE);
+    }
+
+    /* Each worker gets a contiguous share of the indices */
+    pthread_mutex_lock(&pool->mutex);
+    for (unsigned i = 0; i < pool->nworkers; i++)
+        atomic_store(&pool->workers[i].range,
+                     pack(count * i / pool->nworkers, count * (i + 1) / pool->nworkers));
+    atomic_store(&pool->pending, count);
+    pool->task = task;
+    pool->arg  = arg;
+    pool->busy = pool->nworkers - 1;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->mutex);
+
+    work(&pool->workers[0]);
+
+    /* It waits for the other workers to leave the run */
+    pthread_mutex_lock(&pool->mutex);
+    while (pool->busy > 0)
+        pthread_cond_wait(&pool->done, &pool->mutex);
+    pthread_mutex_unlock(&pool->mutex);
+}
+
+void
+pool_free(struct pool *pool) {
+    pthread_mutex_lock(&pool->mutex);
+    pool->quit = 1;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->mutex);
+
+    for (unsigned i = 1; i < pool->nworkers; i++)
+        pthread_join(pool->workers[i].thread, NULL);
+
+    pthread_mutex_destroy(&pool->mutex);
+    pthread_cond_destroy(&pool->start);
+    pthread_cond_destroy(&pool->done);
+    free(pool->workers);
+    free(pool);
+}
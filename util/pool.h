@@ -0,0 +1,130 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Ricardo Fares
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef POOL_H
+#define POOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+/**
+ * A task of a pool, which is run once for each index of a range.
+ * <p>
+ * The worker is the index of the thread running the task, from zero to
+ * the amount of threads of the pool, hence, it may be used to index the
+ * storage private to each thread.
+ *
+ * @param arg    the argument of the task
+ * @param index  the index being run
+ * @param worker the worker running the index
+ */
+typedef void (*pool_task)(void *arg, size_t index, unsigned worker);
+
+/**
+ * A worker of a pool.
+ * <p>
+ * The indices left to the worker are the range packed into a single
+ * word, the first index in the high half and the end in the low half,
+ * such that both the owner and the thieves claim indices with a single
+ * compare-and-swap. Each worker has its own cache line, since the range
+ * is written by every claim.
+ */
+struct pool_worker {
+    _Alignas(64) _Atomic uint64_t range;
+    struct pool                  *pool;
+    unsigned                      id;
+    pthread_t                     thread;
+};
+
+/**
+ * A work-stealing thread pool.
+ * <p>
+ * Each run splits a range of indices into a contiguous share for each
+ * worker, which runs its share from the front, and once it is done, it
+ * steals the back half of the share of another worker, starting from
+ * its neighbours. Hence, a worker touches contiguous memory as long as
+ * the shares are balanced, and each thread is pinned to its own core,
+ * such that the memory it touches first stays on its NUMA node.
+ * <p>
+ * The thread creating the pool is its first worker, hence, it takes
+ * part in every run.
+ * <p>
+ * Moreover, as the hash table, this pool has been implemented using an
+ * aggressive way to handle exceptional cases, in any of these cases the
+ * application is immediately terminated.
+ */
+struct pool {
+    struct pool_worker *workers;
+    unsigned            nworkers;
+    pool_task           task;
+    void               *arg;
+    _Atomic size_t      pending;    /* the indices not run yet */
+    unsigned            busy;       /* the threads still taking part in the run */
+    unsigned long       generation; /* the amount of runs started */
+    int                 quit;
+    pthread_mutex_t     mutex;
+    pthread_cond_t      start;
+    pthread_cond_t      done;
+};
+
+/* Thread Pool Function Declaration */
+
+/**
+ * It allocates a <em>pool</em> structure and starts its threads.
+ * <p>
+ * If there is not enough memory to allocate the pool, or its threads
+ * could not be started, then the application is immediately terminated.
+ *
+ * @param threads the amount of threads, or 0 for one per available core
+ *
+ * @return a pointer to the memory allocated for the <em>pool</em>
+ */
+struct pool *
+pool_new(unsigned threads);
+
+/**
+ * It runs the specified task once for each index from 0 to
+ * <em>count</em>, returning when every index has been run.
+ * <p>
+ * The indices are run in no particular order, hence, a task writing
+ * the output of each index apart produces the same output in any run.
+ *
+ * @param pool  the pool
+ * @param count the amount of indices
+ * @param task  the task
+ * @param arg   the argument of the task
+ */
+void
+pool_run(struct pool *pool, size_t count, pool_task task, void *arg);
+
+/**
+ * It stops the threads of the specified pool and frees it.
+ *
+ * @param pool the pool
+ */
+void
+pool_free(struct pool *pool);
+
+#endif // POOL_H
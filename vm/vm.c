@@ -0,0 +1,329 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Ricardo Fares
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "../eval/eval.h"
+#include "./vm.h"
+
+/**
+ * It indicates whether the dispatch is threaded, that is, each
+ * instruction jumps directly to the next one through a computed
+ * goto, instead of going back to a central switch.
+ */
+#if defined(__GNUC__)
+#define VM_THREADED (1)
+#else
+#define VM_THREADED (0)
+#endif
+
+/**
+ * The maximum stack depth that is kept on the native stack.
+ * Deeper bytecodes allocate their stack on each run.
+ */
+#define VM_STACK_INLINE (256)
+
+/**
+ * A bytecode emitter.
+ */
+struct emitter {
+    struct bytecode      *bytecode;
+    const struct program *program;
+    uint32_t             *uses;  /* amount of nodes using each node */
+    uint32_t             *temps; /* temporary slot of each computed shared node */
+    uint32_t              last;  /* offset of the last emitted instruction */
+    uint32_t              sp;    /* stack depth after the last instruction */
+};
+
+/**
+ * It appends the specified word to the code being emitted.
+ * <p>
+ * If there is not enough memory, then the application is immediately
+ * terminated.
+ *
+ * @param e    the emitter
+ * @param word the word
+ */
+static void
+emit_word(struct emitter *e, const uint32_t word) {
+    struct bytecode *bc = e->bytecode;
+    if (bc->len == bc->capacity) {
+        bc->capacity = bc->capacity ? bc->capacity << 1 : 64;
+        if (!(bc->code = realloc(bc->code, sizeof(uint32_t) * bc->capacity))) {
+            printf("Bytecode could not allocate %u words.\n", bc->capacity);
+            exit(EXIT_FAILURE);
+        }
+    }
+    bc->code[bc->len++] = word;
+}
+
+/**
+ * It emits an instruction with the specified opcode, which changes
+ * the stack depth by the specified amount.
+ *
+ * @param e     the emitter
+ * @param op    the opcode
+ * @param delta the stack depth change
+ */
+static void
+emit_op(struct emitter *e, const uint32_t op, const int delta) {
+    e->last = e->bytecode->len;
+    e->sp  += delta;
+    if (e->sp > e->bytecode->depth)
+        e->bytecode->depth = e->sp;
+    emit_word(e, op);
+}
+
+/**
+ * It emits the instructions computing the value of the specified
+ * node onto the stack.
+ *
+ * @param e     the emitter
+ * @param index the index of the node
+ */
+static void
+emit_node(struct emitter *e, const uint32_t index) {
+    const struct ast_node *node = &e->program->nodes[index];
+
+    /* It checks if the node is shared and has already been computed */
+    if (e->temps[index] != AST_NONE) {
+        emit_op(e, VM_LOAD, 1);
+        emit_word(e, e->temps[index]);
+        return;
+    }
+
+    /* It checks if the node is shared and worth keeping, */
+    /* such that it is computed once into a temporary slot */
+    if (e->uses[index] > 1 && node->op != AST_NUMBER && node->op != AST_LOAD) {
+        e->uses[index] = 1;
+        emit_node(e, index);
+        emit_op(e, VM_TEE, 0);
+        emit_word(e, e->temps[index] = e->bytecode->nslots++);
+        return;
+    }
+
+    switch (node->op) {
+        case AST_NUMBER:
+            emit_op(e, VM_CONST, 1);
+            emit_word(e, node->aux);
+            return;
+        case AST_LOAD:
+            emit_op(e, VM_LOAD, 1);
+            emit_word(e, node->aux);
+            return;
+        case AST_ADD: case AST_SUB: case AST_MUL: case AST_DIV: {
+            uint32_t rhs;
+
+            emit_node(e, node->lhs);
+            emit_node(e, node->rhs);
+
+            /* It checks if the right operand has been pushed by the last */
+            /* instruction. If so, then both are fused into a superinstruction */
+            rhs = e->bytecode->code[e->last];
+            if (rhs == VM_LOAD || rhs == VM_CONST) {
+                e->bytecode->code[e->last] = (rhs == VM_LOAD ? VM_LOAD_ADD : VM_CONST_ADD) + node->op - AST_ADD;
+                e->sp--;
+                return;
+            }
+
+            emit_op(e, node->op + 1, -1);
+            return;
+        }
+        case AST_POW:
+            emit_node(e, node->lhs);
+            emit_node(e, node->rhs);
+            emit_op(e, VM_POW, -1);
+            return;
+        default: /* the unary operations */
+            emit_node(e, node->lhs);
+            emit_op(e, node->op + 1, 0);
+            return;
+    }
+}
+
+struct bytecode *
+vm_compile(const struct program *program) {
+    struct bytecode *bc = calloc(1, sizeof(struct bytecode));
+    struct emitter   e  = { bc, program, NULL, NULL, 0, 0 };
+
+    /* It checks if there is not enough memory to allocate a bytecode */
+    if (!bc || !(bc->consts = malloc(sizeof(double) * (program->nconsts + 1))) ||
+        !(e.uses = calloc(program->count + 1, sizeof(uint32_t))) ||
+        !(e.temps = malloc(sizeof(uint32_t) * (program->count + 1)))) {
+        printf("A bytecode could not be allocated.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    memset(e.temps, 0xFF, sizeof(uint32_t) * program->count);
+    for (uint32_t i = 0; i < program->count; i++) {
+        const struct ast_node *node = &program->nodes[i];
+
+        /* The right operand of a load is not computed by the load */
+        if (node->op == AST_NUMBER || node->op == AST_LOAD)
+            continue;
+        e.uses[node->lhs]++;
+        if (node->rhs != AST_NONE)
+            e.uses[node->rhs]++;
+    }
+    /* A result is a use as well, since the node of a result may be */
+    /* shared with a later statement, after its loads have been stored */
+    for (uint32_t i = 0; i < program->nstatements; i++)
+        if (program->statements[i].output != AST_NONE)
+            e.uses[program->statements[i].node]++;
+
+    memcpy(bc->consts, program->consts, sizeof(double) * program->nconsts);
+    bc->nconsts = program->nconsts;
+    bc->nslots  = program->nslots + program->nresults;
+
+    /* The statements are emitted in the program order */
+    for (uint32_t i = 0; i < program->nstatements; i++) {
+        const struct ast_statement *statement = &program->statements[i];
+
+        if (statement->output == AST_NONE) {
+            emit_node(&e, program->nodes[statement->node].lhs);
+            emit_op(&e, VM_STORE, -1);
+            emit_word(&e, program->nodes[statement->node].aux);
+        } else {
+            emit_node(&e, statement->node);
+            emit_op(&e, VM_OUT, -1);
+            emit_word(&e, program->nslots + statement->output);
+        }
+    }
+
+    /* It returns the last result, which the definitions may follow, */
+    /* or NaN if every statement is a definition */
+    if (program->nresults) {
+        emit_op(&e, VM_LOAD, 1);
+        emit_word(&e, program->nslots + program->nresults - 1);
+    } else {
+        bc->consts[bc->nconsts] = NAN;
+        emit_op(&e, VM_CONST, 1);
+        emit_word(&e, bc->nconsts++);
+    }
+    emit_op(&e, VM_RET, -1);
+
+    free(e.uses);
+    free(e.temps);
+
+    return bc;
+}
+
+double
+vm_run(const struct bytecode *bytecode, double *vars) {
+    double          inline_stack[VM_STACK_INLINE];
+    double         *stack = inline_stack;
+    double         *sp;
+    double          value;
+    const uint32_t *pc = bytecode->code;
+    const double   *k  = bytecode->consts;
+
+    /* It checks if the stack does not fit on the native stack */
+    if (bytecode->depth > VM_STACK_INLINE && !(stack = malloc(sizeof(double) * bytecode->depth))) {
+        printf("A stack of %u values could not be allocated.\n", bytecode->depth);
+        exit(EXIT_FAILURE);
+    }
+
+    sp = stack - 1; /* it points to the top of the stack */
+
+#if VM_THREADED
+    static const void *dispatch[] = {
+        &&op_VM_RET,      &&op_VM_CONST,     &&op_VM_LOAD,      &&op_VM_STORE,
+        &&op_VM_ADD,      &&op_VM_SUB,       &&op_VM_MUL,       &&op_VM_DIV,
+        &&op_VM_POW,      &&op_VM_FACT,      &&op_VM_ABS,       &&op_VM_SIN,
+        &&op_VM_COS,      &&op_VM_TAN,       &&op_VM_CSC,       &&op_VM_SEC,
+        &&op_VM_COT,      &&op_VM_FLOOR,     &&op_VM_CEIL,      &&op_VM_SQRT,
+        &&op_VM_CBRT,     &&op_VM_LOG10,     &&op_VM_LOG2,      &&op_VM_LOAD_ADD,
+        &&op_VM_LOAD_SUB, &&op_VM_LOAD_MUL,  &&op_VM_LOAD_DIV,  &&op_VM_CONST_ADD,
+        &&op_VM_CONST_SUB, &&op_VM_CONST_MUL, &&op_VM_CONST_DIV, &&op_VM_TEE,
+        &&op_VM_OUT,
+    };
+#define CASE( OP ) op_##OP:
+#define NEXT()     goto *dispatch[*pc++]
+
+    NEXT();
+#else
+#define CASE( OP ) case OP:
+#define NEXT()     break
+
+    for (;;) switch (*pc++) {
+#endif
+        CASE(VM_CONST)     { *++sp = k[*pc++];                  NEXT(); }
+        CASE(VM_LOAD)      { *++sp = vars[*pc++];               NEXT(); }
+        CASE(VM_STORE)     { vars[*pc++] = *sp--;               NEXT(); }
+        CASE(VM_TEE)       { vars[*pc++] = *sp;                 NEXT(); }
+        CASE(VM_OUT)       { vars[*pc++] = *sp--;               NEXT(); }
+        CASE(VM_ADD)       { sp[-1] += sp[0]; sp--;             NEXT(); }
+        CASE(VM_SUB)       { sp[-1] -= sp[0]; sp--;             NEXT(); }
+        CASE(VM_MUL)       { sp[-1] *= sp[0]; sp--;             NEXT(); }
+        CASE(VM_DIV)       { sp[-1] /= sp[0]; sp--;             NEXT(); }
+        CASE(VM_POW)       { sp[-1] = pow(sp[-1], sp[0]); sp--; NEXT(); }
+        CASE(VM_FACT)      { *sp = factorial(*sp);              NEXT(); }
+        CASE(VM_ABS)       { *sp = fabs(*sp);                   NEXT(); }
+        CASE(VM_SIN)       { *sp = sin(*sp);                    NEXT(); }
+        CASE(VM_COS)       { *sp = cos(*sp);                    NEXT(); }
+        CASE(VM_TAN)       { *sp = tan(*sp);                    NEXT(); }
+        CASE(VM_CSC)       { *sp = 1.0 / sin(*sp);              NEXT(); }
+        CASE(VM_SEC)       { *sp = 1.0 / cos(*sp);              NEXT(); }
+        CASE(VM_COT)       { *sp = 1.0 / tan(*sp);              NEXT(); }
+        CASE(VM_FLOOR)     { *sp = floor(*sp);                  NEXT(); }
+        CASE(VM_CEIL)      { *sp = ceil(*sp);                   NEXT(); }
+        CASE(VM_SQRT)      { *sp = sqrt(*sp);                   NEXT(); }
+        CASE(VM_CBRT)      { *sp = cbrt(*sp);                   NEXT(); }
+        CASE(VM_LOG10)     { *sp = log10(*sp);                  NEXT(); }
+        CASE(VM_LOG2)      { *sp = log2(*sp);                   NEXT(); }
+        CASE(VM_LOAD_ADD)  { *sp += vars[*pc++];                NEXT(); }
+        CASE(VM_LOAD_SUB)  { *sp -= vars[*pc++];                NEXT(); }
+        CASE(VM_LOAD_MUL)  { *sp *= vars[*pc++];                NEXT(); }
+        CASE(VM_LOAD_DIV)  { *sp /= vars[*pc++];                NEXT(); }
+        CASE(VM_CONST_ADD) { *sp += k[*pc++];                   NEXT(); }
+        CASE(VM_CONST_SUB) { *sp -= k[*pc++];                   NEXT(); }
+        CASE(VM_CONST_MUL) { *sp *= k[*pc++];                   NEXT(); }
+        CASE(VM_CONST_DIV) { *sp /= k[*pc++];                   NEXT(); }
+        CASE(VM_RET) {
+            value = *sp;
+
+            if (stack != inline_stack)
+                free(stack);
+
+            return value;
+        }
+#if !VM_THREADED
+        default:
+            printf("vm_run: Should not reach here!");
+            exit(EXIT_FAILURE);
+    }
+#endif
+
+#undef CASE
+#undef NEXT
+}
+
+void
+bytecode_free(struct bytecode *bytecode) {
+    free(bytecode->code);
+    free(bytecode->consts);
+    free(bytecode);
+}
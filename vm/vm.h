@@ -0,0 +1,141 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Ricardo Fares
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef VM_H
+#define VM_H
+
+#include <stdint.h>
+
+#include "../ast/ast.h"
+
+/**
+ * Virtual machine opcodes definition.
+ * <p>
+ * The operands of an instruction follow its opcode in the code. The
+ * math function opcodes follow the same order as their expression
+ * tree node operations.
+ */
+#define VM_RET       (0x0)  /* return the top of the stack                   */
+#define VM_CONST     (0x1)  /* k: push the constant k                        */
+#define VM_LOAD      (0x2)  /* s: push the variable in slot s                */
+#define VM_STORE     (0x3)  /* s: pop into the variable in slot s            */
+#define VM_ADD       (0x4)
+#define VM_SUB       (0x5)
+#define VM_MUL       (0x6)
+#define VM_DIV       (0x7)
+#define VM_POW       (0x8)
+#define VM_FACT      (0x9)
+#define VM_ABS       (0xA)
+#define VM_SIN       (0xB)
+#define VM_COS       (0xC)
+#define VM_TAN       (0xD)
+#define VM_CSC       (0xE)
+#define VM_SEC       (0xF)
+#define VM_COT       (0x10)
+#define VM_FLOOR     (0x11)
+#define VM_CEIL      (0x12)
+#define VM_SQRT      (0x13)
+#define VM_CBRT      (0x14)
+#define VM_LOG10     (0x15)
+#define VM_LOG2      (0x16)
+
+/**
+ * Superinstructions definition.
+ * <p>
+ * They fuse a push of a variable or a constant with the binary
+ * operation consuming it, which is the most common pair of
+ * instructions, saving a dispatch and a stack round trip.
+ */
+#define VM_LOAD_ADD  (0x17) /* s: top += variable in slot s                  */
+#define VM_LOAD_SUB  (0x18) /* s: top -= variable in slot s                  */
+#define VM_LOAD_MUL  (0x19) /* s: top *= variable in slot s                  */
+#define VM_LOAD_DIV  (0x1A) /* s: top /= variable in slot s                  */
+#define VM_CONST_ADD (0x1B) /* k: top += constant k                          */
+#define VM_CONST_SUB (0x1C) /* k: top -= constant k                          */
+#define VM_CONST_MUL (0x1D) /* k: top *= constant k                          */
+#define VM_CONST_DIV (0x1E) /* k: top /= constant k                          */
+#define VM_TEE       (0x1F) /* s: copy the top into the variable in slot s   */
+#define VM_OUT       (0x20) /* s: pop into the result in slot s              */
+
+/* Structure Definitions */
+
+/**
+ * A compiled bytecode.
+ * <p>
+ * The bytecode shares the variable slots of the program it has been
+ * compiled from, hence, it is run over the same variables. The value
+ * of each result is popped into its slot following the variable slots,
+ * as the evaluations leave it in the frame. The values of the
+ * subexpressions shared by several nodes are kept in temporary slots
+ * following the results, which always fit in a frame of
+ * <em>program_frame_size(program)</em> doubles.
+ */
+struct bytecode {
+    uint32_t *code;
+    uint32_t  len;
+    uint32_t  capacity;
+    double   *consts;
+    uint32_t  nconsts;
+    uint32_t  nslots;
+    uint32_t  depth;
+};
+
+/* Function Declaration */
+
+/**
+ * It compiles the specified program into bytecode.
+ * <p>
+ * If there is not enough memory to allocate the bytecode, then
+ * the application is immediately terminated.
+ *
+ * @param program the program to be compiled
+ *
+ * @return the compiled bytecode, which must be freed by the caller
+ */
+struct bytecode *
+vm_compile(const struct program *program);
+
+/**
+ * It runs the specified bytecode.
+ * <p>
+ * The variables must have <em>bytecode->nslots</em> doubles.
+ * The bytecode is not modified, hence, it may be run concurrently
+ * as long as each run has its own variables.
+ *
+ * @param bytecode the bytecode to be run
+ * @param vars     the variables
+ *
+ * @return the value of the last program result
+ */
+double
+vm_run(const struct bytecode *bytecode, double *vars);
+
+/**
+ * It frees the specified bytecode.
+ *
+ * @param bytecode the bytecode
+ */
+void
+bytecode_free(struct bytecode *bytecode);
+
+#endif // VM_H